@@ -1,75 +1,448 @@
+#pragma once
+#include<iostream>
 #include<assert.h>
+#include<memory>
+#include<functional>
+#include<tuple>
+#include<utility>
+#include<type_traits>
+#include"../Template_Advanced/reverse_iterator.h"
+#include"../Memory_management/PoolAllocator.h"
 
-template<class K, class V>
+using namespace std;
+
+template<class T>
 struct AVLTreeNode
 {
-	AVLTreeNode<K, V>* _left;
-	AVLTreeNode<K, V>* _right;
-	AVLTreeNode<K, V>* _parent;
-	// std::pair<K, V>是C++标准库提供的一种模板类，用于将两个值组合成一个单一的对象
-	// 它的主要作用是方便地同时操作或传递两个相关联的数据项
-	pair<K, V> _kv;   // 键值对，存储节点的数据
+	// 头节点的平衡因子固定为kHeaderBf，正常节点只会是-1/0/1，迭代器靠它认出end()
+	static const int kHeaderBf = 3;
+
+	AVLTreeNode<T>* _left;
+	AVLTreeNode<T>* _right;
+	AVLTreeNode<T>* _parent;
+	union
+	{
+		T _data;   // 节点数据，T可能是Key，也可能是pair<K, V>；头节点不构造它
+	};
 	int _bf; // 平衡因子
 
-	// 构造函数
-	AVLTreeNode(const pair<K, V>& kv)
+	// 头节点用：只有链接，没有数据
+	AVLTreeNode()
 		:_left(nullptr)
 		,_right(nullptr)
 		,_parent(nullptr)
-		,_kv(kv)
+		,_bf(kHeaderBf)
+	{}
+
+	// 构造函数：参数原样转发给T，拷贝和移动都走这里
+	template<class... Args>
+	explicit AVLTreeNode(std::in_place_t, Args&&... args)
+		:_left(nullptr)
+		,_right(nullptr)
+		,_parent(nullptr)
+		,_data(std::forward<Args>(args)...)
 		,_bf(0)
 	{}
+
+	// _data在union里，由AVLTree释放节点时显式析构
+	~AVLTreeNode()
+	{}
+};
+
+// AVL树迭代器，头节点的布局和RBTree一样：
+//   header->_parent 指向根，根的_parent指向header，header->_left / header->_right 指向最小/最大节点
+template<class T, class Ref, class Ptr>
+struct __AVLTreeIterator
+{
+	typedef AVLTreeNode<T> Node;
+	typedef __AVLTreeIterator<T, Ref, Ptr> Self;
+	typedef __AVLTreeIterator<T, T&, T*> Iterator;
+	Node* _node;
+
+	__AVLTreeIterator(Node* node)
+		:_node(node)
+	{}
+
+	// 普通迭代器可以转换成const迭代器（模板只匹配Iterator且不是Self，拷贝构造交给编译器）
+	template<class It>
+		requires std::is_same_v<It, Iterator> && (!std::is_same_v<It, Self>)
+	__AVLTreeIterator(const It& it)
+		:_node(it._node)
+	{}
+
+	Ref operator*()
+	{
+		return _node->_data;
+	}
+
+	Ptr operator->()
+	{
+		return &_node->_data;
+	}
+
+	bool operator!=(const Self& s) const
+	{
+		return _node != s._node;
+	}
+
+	bool operator==(const Self& s) const
+	{
+		return _node == s._node;
+	}
+
+	// 中序后继：有右子树就是右子树的最左节点，否则往上找第一个从左边上来的祖先
+	Self& operator++()
+	{
+		if (_node->_right)
+		{
+			Node* cur = _node->_right;
+			while (cur->_left)
+				cur = cur->_left;
+			_node = cur;
+		}
+		else
+		{
+			Node* cur = _node;
+			Node* parent = cur->_parent;
+			while (cur == parent->_right)
+			{
+				cur = parent;
+				parent = parent->_parent;
+			}
+			// 只有根节点且根没有右子树时，会从最大节点走到header再绕回根，这时cur已经是header
+			if (cur->_right != parent)
+				cur = parent;
+			_node = cur;
+		}
+		return *this;
+	}
+
+	// 中序前驱：end()的前一个是最大节点
+	Self& operator--()
+	{
+		if (_node->_bf == Node::kHeaderBf)
+		{
+			_node = _node->_right;
+		}
+		else if (_node->_left)
+		{
+			Node* cur = _node->_left;
+			while (cur->_right)
+				cur = cur->_right;
+			_node = cur;
+		}
+		else
+		{
+			Node* cur = _node;
+			Node* parent = cur->_parent;
+			while (cur == parent->_left)
+			{
+				cur = parent;
+				parent = parent->_parent;
+			}
+			_node = parent;
+		}
+		return *this;
+	}
+
+	Self operator++(int)
+	{
+		Self tmp(*this);
+		++*this;
+		return tmp;
+	}
+
+	Self operator--(int)
+	{
+		Self tmp(*this);
+		--*this;
+		return tmp;
+	}
 };
 
-template<class K, class V>
+// K: 键值类型
+// T: 存储的数据类型（set是K，map是pair<K, V>）
+// KeyOfT: 从T中取出键值的仿函数
+// Compare: 键值比较仿函数，只要求"小于"语义，默认std::less<>
+// Alloc: 元素的分配器，内部rebind成节点的分配器（比如pzh::pool_allocator让节点走内存池）
+template<class K, class T, class KeyOfT, class Compare = std::less<>, class Alloc = std::allocator<T>>
 class AVLTree
 {
-	typedef AVLTreeNode<K, V> Node;
+	typedef AVLTreeNode<T> Node;
+	typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc;
 public:
-	bool Insert(const pair<K, V>& kv)
+	typedef __AVLTreeIterator<T, T&, T*> iterator;
+	typedef __AVLTreeIterator<T, const T&, const T*> const_iterator;
+	typedef ReverseIterator<iterator, T&, T*> reverse_iterator;
+	typedef ReverseIterator<const_iterator, const T&, const T*> const_reverse_iterator;
+
+	AVLTree()
+	{
+		ResetHeader(nullptr);
+	}
+
+	explicit AVLTree(const Compare& comp)
+		:_comp(comp)
 	{
-		if (_root == nullptr)
+		ResetHeader(nullptr);
+	}
+
+	// 拷贝构造：按原树的形状和平衡因子逐个复制节点
+	AVLTree(const AVLTree& t)
+		:_comp(t._comp)
+	{
+		ResetHeader(Copy(t.Root(), &_header));
+		_size = t._size;
+	}
+
+	AVLTree& operator=(AVLTree t)
+	{
+		Swap(t);
+		return *this;
+	}
+
+	~AVLTree()
+	{
+		Destroy(Root());
+	}
+
+	// 头节点在树对象里面，交换两棵树时要把根的父指针改回各自的头节点
+	void Swap(AVLTree& t)
+	{
+		swap(_header._parent, t._header._parent);
+		swap(_header._left, t._header._left);
+		swap(_header._right, t._header._right);
+		swap(_size, t._size);
+		swap(_comp, t._comp);
+		FixHeader();
+		t.FixHeader();
+	}
+
+	iterator begin()
+	{
+		return iterator(_header._left);
+	}
+
+	iterator end()
+	{
+		return iterator(&_header);
+	}
+
+	const_iterator begin() const
+	{
+		return const_iterator(_header._left);
+	}
+
+	const_iterator end() const
+	{
+		return const_iterator(const_cast<Node*>(&_header));
+	}
+
+	reverse_iterator rbegin()
+	{
+		return reverse_iterator(end());
+	}
+
+	reverse_iterator rend()
+	{
+		return reverse_iterator(begin());
+	}
+
+	const_reverse_iterator rbegin() const
+	{
+		return const_reverse_iterator(end());
+	}
+
+	const_reverse_iterator rend() const
+	{
+		return const_reverse_iterator(begin());
+	}
+
+	// 返回pair<迭代器, 是否插入成功>；键值已存在时不分配节点
+	pair<iterator, bool> Insert(const T& data)
+	{
+		KeyOfT kot;
+		return InsertUnique(kot(data), [&]() { return CreateNode(data); });
+	}
+
+	// 右值版本：数据直接移动进新节点
+	pair<iterator, bool> Insert(T&& data)
+	{
+		KeyOfT kot;
+		return InsertUnique(kot(data), [&]() { return CreateNode(std::move(data)); });
+	}
+
+	// 用args就地构造元素，键值已存在时多一次节点的分配和释放
+	template<class... Args>
+	pair<iterator, bool> Emplace(Args&&... args)
+	{
+		KeyOfT kot;
+		Node* node = CreateNode(std::forward<Args>(args)...);
+		pair<iterator, bool> ret = InsertUnique(kot(node->_data), [node]() { return node; });
+		if (!ret.second)
+			DestroyNode(node);
+		return ret;
+	}
+
+	// 只用于T是pair的map：key不存在时才构造节点
+	template<class KeyArg, class... Args>
+	pair<iterator, bool> TryEmplace(KeyArg&& key, Args&&... args)
+	{
+		return InsertUnique(key, [&]() {
+			return CreateNode(std::piecewise_construct,
+				std::forward_as_tuple(std::forward<KeyArg>(key)),
+				std::forward_as_tuple(std::forward<Args>(args)...));
+		});
+	}
+
+	// 查找：先找第一个不小于key的节点（每层比较一次），再比较一次确认是否相等
+	template<class KeyLike>
+	iterator Find(const KeyLike& key)
+	{
+		KeyOfT kot;
+		iterator it = LowerBound(key);
+		if (it == end() || _comp(key, kot(*it)))
+			return end();
+		return it;
+	}
+
+	// 第一个键值不小于key的元素
+	template<class KeyLike>
+	iterator LowerBound(const KeyLike& key)
+	{
+		Node* cur = Root();
+		Node* ret = &_header;
+		KeyOfT kot;
+		while (cur)
 		{
-			_root = new Node(kv);
-			return true;
+			if (_comp(kot(cur->_data), key))
+			{
+				cur = cur->_right;
+			}
+			else
+			{
+				ret = cur;
+				cur = cur->_left;
+			}
 		}
-		Node* parent = nullptr;
-		Node* cur = _root;
+		return iterator(ret);
+	}
+
+	// 第一个键值大于key的元素
+	template<class KeyLike>
+	iterator UpperBound(const KeyLike& key)
+	{
+		Node* cur = Root();
+		Node* ret = &_header;
+		KeyOfT kot;
 		while (cur)
 		{
-			// 当前节点的键值小于要插入的键值，向右子树查找
-			if (cur->_kv.first < kv.first)
+			if (_comp(key, kot(cur->_data)))
+			{
+				ret = cur;
+				cur = cur->_left;
+			}
+			else
 			{
-				parent = cur;
 				cur = cur->_right;
 			}
-			// 当前节点的键值大于要插入的键值，向左子树查找
-			else if (cur->_kv.first > kv.first)
+		}
+		return iterator(ret);
+	}
+
+	template<class KeyLike>
+	pair<iterator, iterator> EqualRange(const KeyLike& key)
+	{
+		return make_pair(LowerBound(key), UpperBound(key));
+	}
+
+	// 删除键值为key的节点，返回是否删除成功
+	bool Erase(const K& key)
+	{
+		iterator it = Find(key);
+		if (it == end())
+			return false;
+		EraseNode(it._node);
+		return true;
+	}
+
+	// 删除pos指向的节点，返回它的中序后继；其他节点只改链接，指向它们的迭代器仍然有效
+	iterator Erase(const_iterator pos)
+	{
+		iterator next(pos._node);
+		++next;
+		EraseNode(pos._node);
+		return next;
+	}
+
+	size_t Size()
+	{
+		return _size;
+	}
+
+	int Height()
+	{
+		return _Height(Root());
+	}
+
+private:
+	// 插入的公共部分：按key找位置，key不存在时才调用makeNode()拿到新节点
+	template<class KeyLike, class MakeNode>
+	pair<iterator, bool> InsertUnique(const KeyLike& key, MakeNode&& makeNode)
+	{
+		if (Root() == nullptr)
+		{
+			ResetHeader(makeNode());
+			_size = 1;
+			return make_pair(iterator(Root()), true);
+		}
+		KeyOfT kot;
+		// 每层只调用一次_comp：key < cur往左，否则往右并记下cur（cur <= key）。
+		// 走到空位后，最后一个记下的节点要么等于key，要么小于key，再比一次就能判重
+		Node* parent = nullptr;
+		Node* cur = Root();
+		Node* notGreater = nullptr;
+		bool goLeft = false;
+		while (cur)
+		{
+			parent = cur;
+			goLeft = _comp(key, kot(cur->_data));
+			if (goLeft)
 			{
-				parent = cur;
 				cur = cur->_left;
 			}
 			else
 			{
-				return false;
+				notGreater = cur;
+				cur = cur->_right;
 			}
 		}
+		if (notGreater && !_comp(kot(notGreater->_data), key))
+		{
+			return make_pair(iterator(notGreater), false);
+		}
 
-		// 为新插入的值创建节点
-		cur = new Node(kv);
-		if (parent->_kv.first < kv.first)
+		// 为新插入的值创建节点，挂在下降时最后走的方向上，不用再比较
+		// 挂在最大节点右边/最小节点左边时，新节点成为新的最大/最小节点
+		cur = makeNode();
+		Node* newnode = cur;
+		if (goLeft)
 		{
-			parent->_right = cur;
-			cur->_parent = parent;
+			parent->_left = cur;
+			if (parent == _header._left)
+				_header._left = cur;
 		}
 		else
 		{
-			parent->_left = cur;
-			cur->_parent = parent;
+			parent->_right = cur;
+			if (parent == _header._right)
+				_header._right = cur;
 		}
+		cur->_parent = parent;
+		++_size;
 
-		// 调整节点的平衡因子，从插入点的父节点开始向上调整
-		while (parent)
+		// 调整节点的平衡因子，从插入点的父节点开始向上调整，到头节点为止
+		while (parent != &_header)
 		{
 			if (cur == parent->_left)
 			{
@@ -131,9 +504,10 @@ public:
 				assert(false);  // 触发断言，程序终止
 			}
 		}
-		return true;
+		return make_pair(iterator(newnode), true);
 	}
 
+public:
 	// 左单旋（处理右右不平衡情况）
 	void RotateL(Node* parent)
 	{
@@ -195,10 +569,10 @@ public:
 	         /  \
 	        A   subRL
 	    ================================ */
-	    if (_root == parent)           // parent是整棵树的根节点
+	    if (Root() == parent)          // parent是整棵树的根节点
 	    {
-	        _root = subR;              // 更新根节点为subR
-	        subR->_parent = nullptr;   // 根节点的父节点为空
+	        Root() = subR;             // 更新根节点为subR
+	        subR->_parent = &_header;  // 根节点的父节点是头节点
 	    }
 	    else  // parent不是根节点
 	    {
@@ -277,10 +651,10 @@ public:
 	                 /    \
 	             subLR     A
 	    ================================ */
-	    if (_root == parent)            // 父节点是根节点
+	    if (Root() == parent)           // 父节点是根节点
 	    {
-	        _root = subL;               // 更新根节点为subL
-	        subL->_parent = nullptr;    // 根节点的父节点为空
+	        Root() = subL;              // 更新根节点为subL
+	        subL->_parent = &_header;   // 根节点的父节点是头节点
 	    }
 	    else  // 不是根节点
 	    {
@@ -501,7 +875,7 @@ public:
     // 中序遍历（外部接口）
     void InOrder()
     {
-        _InOrder(_root);        // 调用内部递归函数
+        _InOrder(Root());        // 调用内部递归函数
         cout << endl;
     }
 
@@ -511,7 +885,8 @@ public:
 		if (root == nullptr)
 			return;
 		_InOrder(root->_left);
-		cout << root->_kv.first << " ";
+		KeyOfT kot;
+		cout << kot(root->_data) << " ";
 		_InOrder(root->_right);
 	}
 
@@ -526,9 +901,25 @@ public:
 	}
 
 	// 检查AVL树是否平衡（外部接口）
+	// 同时检查头节点记录的最小/最大节点、根的父指针和元素个数
 	bool IsBalance()
 	{
-		return _IsBalance(_root);
+		if (Root() == nullptr)
+			return _size == 0 && _header._left == &_header;
+		if (_header._left != Leftmost(Root()) || _header._right != Rightmost(Root()) || Root()->_parent != &_header)
+		{
+			cout << "错误：头节点记录的最小/最大节点不正确" << endl;
+			return false;
+		}
+		size_t count = 0;
+		for (iterator it = begin(); it != end(); ++it)
+			++count;
+		if (count != _size)
+		{
+			cout << "错误：元素个数不正确" << endl;
+			return false;
+		}
+		return _IsBalance(Root());
 	}
 
 	// 检查AVL树是否平衡（内部递归实现）
@@ -540,7 +931,13 @@ public:
 		int rightHeight = _Height(root->_right);
 		if (rightHeight - leftHeight != root->_bf)
 		{
-			cout << root->_kv.first << "平衡因子异常" << endl;
+			KeyOfT kot;
+			cout << kot(root->_data) << "平衡因子异常" << endl;
+			return false;
+		}
+		if ((root->_left && root->_left->_parent != root) || (root->_right && root->_right->_parent != root))
+		{
+			cout << "错误：父指针和孩子指针不一致" << endl;
 			return false;
 		}
 		return abs(rightHeight - leftHeight) < 2
@@ -549,5 +946,232 @@ public:
 	}
 
 private:
-	Node* _root = nullptr;
+	template<class... Args>
+	Node* CreateNode(Args&&... args)
+	{
+		return pzh::__AllocateNode(_alloc, std::in_place, std::forward<Args>(args)...);
+	}
+
+	void DestroyNode(Node* node)
+	{
+		node->_data.~T();
+		pzh::__DestroyNode(_alloc, node);
+	}
+
+	// 后序释放整棵树
+	void Destroy(Node* root)
+	{
+		if (root == nullptr)
+			return;
+		Destroy(root->_left);
+		Destroy(root->_right);
+		DestroyNode(root);
+	}
+
+	Node* Copy(Node* root, Node* parent)
+	{
+		if (root == nullptr)
+			return nullptr;
+		Node* newRoot = CreateNode(root->_data);
+		newRoot->_bf = root->_bf;
+		newRoot->_parent = parent;
+		newRoot->_left = Copy(root->_left, newRoot);
+		newRoot->_right = Copy(root->_right, newRoot);
+		return newRoot;
+	}
+
+	Node*& Root()
+	{
+		return _header._parent;
+	}
+
+	Node* Root() const
+	{
+		return _header._parent;
+	}
+
+	// 换上一棵新树（可以为空），重新记录根的父节点和最小/最大节点
+	void ResetHeader(Node* root)
+	{
+		_header._parent = root;
+		if (root)
+		{
+			root->_parent = &_header;
+			_header._left = Leftmost(root);
+			_header._right = Rightmost(root);
+		}
+		else
+		{
+			_header._left = _header._right = &_header;
+		}
+	}
+
+	// Swap之后头节点里是对方的链接，只修正根的父指针（空树时链接指回自己）
+	void FixHeader()
+	{
+		if (Root())
+			Root()->_parent = &_header;
+		else
+			_header._left = _header._right = &_header;
+	}
+
+	static Node* Leftmost(Node* root)
+	{
+		while (root->_left)
+			root = root->_left;
+		return root;
+	}
+
+	static Node* Rightmost(Node* root)
+	{
+		while (root->_right)
+			root = root->_right;
+		return root;
+	}
+
+	// 用v替换u在树中的位置（只改u父节点的链接）
+	void Transplant(Node* u, Node* v)
+	{
+		if (u == Root())
+			Root() = v;
+		else if (u == u->_parent->_left)
+			u->_parent->_left = v;
+		else
+			u->_parent->_right = v;
+		if (v)
+			v->_parent = u->_parent;
+	}
+
+	// 删除节点z
+	/*
+	 * 1. z最多一个孩子：孩子直接顶替z，z的父节点那一侧变矮
+	 * 2. z有两个孩子：右子树的最左节点y（中序后继）顶替z并继承z的平衡因子，
+	 *    y原来的右孩子顶替y，变矮的是y原来的父节点的左侧（y就是z的右孩子时是y自己的右侧）
+	 * 只改链接不搬数据，所以指向其他节点的迭代器不会失效
+	 */
+	void EraseNode(Node* z)
+	{
+		if (z == _header._left)
+			_header._left = z->_right ? Leftmost(z->_right) : z->_parent;
+		if (z == _header._right)
+			_header._right = z->_left ? Rightmost(z->_left) : z->_parent;
+		Node* parent = nullptr;  // 子树变矮的节点
+		bool fromLeft = false;   // 变矮的是parent的左子树还是右子树
+		if (z->_left == nullptr || z->_right == nullptr)
+		{
+			Node* child = z->_left ? z->_left : z->_right;
+			parent = z->_parent;
+			fromLeft = parent != &_header && parent->_left == z;
+			Transplant(z, child);
+		}
+		else
+		{
+			Node* y = Leftmost(z->_right);
+			if (y->_parent == z)
+			{
+				parent = y;
+				fromLeft = false;
+			}
+			else
+			{
+				parent = y->_parent;
+				fromLeft = true;
+				Transplant(y, y->_right);
+				y->_right = z->_right;
+				y->_right->_parent = y;
+			}
+			Transplant(z, y);
+			y->_left = z->_left;
+			y->_left->_parent = y;
+			y->_bf = z->_bf;
+		}
+		DestroyNode(z);
+		--_size;
+		EraseFixup(parent, fromLeft);
+	}
+
+	// parent的一侧子树矮了1，从parent开始往上更新平衡因子
+	/*
+	 * 更新后：
+	 *   -1/1：原来是0，parent的高度没变，结束
+	 *   0：原来高的一侧被删矮了，parent整体矮了1，继续往上
+	 *   -2/2：另一侧高出2，以高的孩子sub为轴旋转：
+	 *     sub的平衡因子是0：单旋后高度不变（旋转函数会把两个平衡因子置0，这里改回来），结束
+	 *     和parent同向：单旋，整体矮了1，继续往上
+	 *     和parent反向：双旋，整体矮了1，继续往上
+	 */
+	void EraseFixup(Node* parent, bool fromLeft)
+	{
+		while (parent != &_header)
+		{
+			if (fromLeft)
+				parent->_bf++;
+			else
+				parent->_bf--;
+
+			if (parent->_bf == 1 || parent->_bf == -1)
+				break;
+
+			Node* top = parent;  // 这棵子树调整后的根
+			if (parent->_bf == 2 || parent->_bf == -2)
+			{
+				Node* sub = parent->_bf == 2 ? parent->_right : parent->_left;
+				if (sub->_bf == 0)
+				{
+					if (parent->_bf == 2)
+					{
+						RotateL(parent);
+						parent->_bf = 1;
+						sub->_bf = -1;
+					}
+					else
+					{
+						RotateR(parent);
+						parent->_bf = -1;
+						sub->_bf = 1;
+					}
+					break;
+				}
+				if (parent->_bf == 2 && sub->_bf == 1)
+				{
+					RotateL(parent);
+					top = sub;
+				}
+				else if (parent->_bf == -2 && sub->_bf == -1)
+				{
+					RotateR(parent);
+					top = sub;
+				}
+				else if (parent->_bf == 2)
+				{
+					top = sub->_left;
+					RotateRL(parent);
+				}
+				else
+				{
+					top = sub->_right;
+					RotateLR(parent);
+				}
+			}
+			// top这棵子树矮了1，继续调整它的父节点
+			parent = top->_parent;
+			fromLeft = parent != &_header && parent->_left == top;
+		}
+	}
+
+private:
+	Node _header;      // 头节点：_parent是根，_left/_right是最小/最大节点
+	size_t _size = 0;
+	[[no_unique_address]] NodeAlloc _alloc;
+	[[no_unique_address]] Compare _comp;
 };
+
+namespace pzh
+{
+	// pzh::map/pzh::set的底层选AVL树：比红黑树矮，查找更快；插入删除时旋转更多
+	struct avl_tree_policy
+	{
+		template<class K, class T, class KeyOfT, class Compare, class Alloc>
+		using Tree = AVLTree<K, T, KeyOfT, Compare, Alloc>;
+	};
+}
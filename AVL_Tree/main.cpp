@@ -1,12 +1,91 @@
 #include<iostream>
 #include<vector>
+#include<set>
 using namespace std;
 #include"AVLTree.h"
 
+// pairȡkey
+struct PairKeyOfT
+{
+	const int& operator()(const pair<int, int>& kv)
+	{
+		return kv.first;
+	}
+};
+
+// /ɾstd::setģÿһ֮ƽӣ˫˶
+void test_AVLTree_erase()
+{
+	AVLTree<int, pair<int, int>, PairKeyOfT> t;
+	set<int> ref;
+	bool ok = true;
+	srand(12345);
+	for (int i = 0; i < 20000; i++)
+	{
+		int key = rand() % 2000;
+		if (rand() % 3 == 0)
+		{
+			ok = ok && t.Erase(key) == (ref.erase(key) == 1);
+		}
+		else
+		{
+			ok = ok && t.Insert(make_pair(key, i)).second == ref.insert(key).second;
+		}
+		if (i % 1000 == 0)
+			ok = ok && t.IsBalance();
+	}
+	ok = ok && t.IsBalance() && t.Size() == ref.size();
+
+	// 򡢷
+	auto rit = ref.begin();
+	for (auto it = t.begin(); it != t.end(); ++it, ++rit)
+		ok = ok && it->first == *rit;
+	auto rrit = ref.rbegin();
+	for (auto it = t.rbegin(); it != t.rend(); ++it, ++rrit)
+		ok = ok && (*it).first == *rrit;
+
+	// Һ½
+	for (int key = -1; key <= 2001; key++)
+	{
+		auto it = t.Find(key);
+		ok = ok && (it == t.end()) == (ref.count(key) == 0);
+		auto lb = t.LowerBound(key);
+		auto rlb = ref.lower_bound(key);
+		ok = ok && (lb == t.end() ? rlb == ref.end() : rlb != ref.end() && lb->first == *rlb);
+	}
+
+	// ߱ɾEraseغ
+	for (auto it = t.begin(); it != t.end();)
+	{
+		if (it->first % 2 == 0)
+			it = t.Erase(it);
+		else
+			++it;
+	}
+	for (auto rit = ref.begin(); rit != ref.end();)
+	{
+		if (*rit % 2 == 0)
+			rit = ref.erase(rit);
+		else
+			++rit;
+	}
+	ok = ok && t.IsBalance() && t.Size() == ref.size();
+
+	// ȫɾ
+	AVLTree<int, pair<int, int>, PairKeyOfT> seq;
+	for (int i = 0; i < 100000; i++)
+		seq.Insert(make_pair(i, i));
+	ok = ok && seq.IsBalance() && seq.Height() <= 18;
+	for (int i = 0; i < 100000; i++)
+		ok = ok && seq.Erase(i);
+	ok = ok && seq.Size() == 0 && seq.begin() == seq.end() && seq.IsBalance();
+	cout << "AVLɾ/:" << (ok ? "ok" : "error") << endl;
+}
+
 int main()
 {
 	int a[] = { 4, 2, 6, 1, 3, 5, 15, 7, 16, 14 };
-	AVLTree<int, int> t;
+	AVLTree<int, pair<int, int>, PairKeyOfT> t;
 	for (auto e : a)
 	{
 		// ʹmake_pairֵԲ
@@ -29,7 +108,7 @@ int main()
 		cout << v.back() << endl;
 	}
 
-	AVLTree<int, int> t1;
+	AVLTree<int, pair<int, int>, PairKeyOfT> t1;
 	for (auto e : v)  // vе
 	{
 		// ΪֵԲt1
@@ -38,5 +117,7 @@ int main()
 		cout << "Insert:" << e << "->" << t1.IsBalance() << endl;
 	}
 	cout << t1.IsBalance() << endl;
+
+	test_AVLTree_erase();
 	return 0;
 }
\ No newline at end of file
@@ -1,8 +1,169 @@
 #include<iostream>
+#include<memory>
+#include<vector>
+#include<cmath>
+#include"../Memory_management/PoolAllocator.h"
 using namespace std;
 
 namespace pzh
 {
+    // 下面是pzh::BSTree和kv::BSTree共用的算法，两种节点都有_left/_right/_key
+    // 全部是循环或显式栈，有序数据插出来的退化树（深度等于节点数）上也不会爆栈
+
+    // 中序遍历，栈放在堆上
+    template <class Node, class Fn>
+    void __BSTreeInOrder(Node* root, Fn fn)
+    {
+        std::vector<Node*> st;
+        Node* cur = root;
+        while (cur != nullptr || !st.empty())
+        {
+            while (cur != nullptr)
+            {
+                st.push_back(cur);
+                cur = cur->_left;
+            }
+            cur = st.back();
+            st.pop_back();
+            fn(cur);
+            cur = cur->_right;
+        }
+    }
+
+    // 销毁整棵树：有左孩子就右旋把左孩子转上来，没有左孩子就删掉根往右走
+    // 每个节点最多被转上来一次，O(n)，不要额外内存
+    template <class Node, class Destroyer>
+    void __BSTreeDestroy(Node* root, Destroyer destroy)
+    {
+        while (root != nullptr)
+        {
+            if (root->_left != nullptr)
+            {
+                Node* subL = root->_left;
+                root->_left = subL->_right;
+                subL->_right = root;
+                root = subL;
+            }
+            else
+            {
+                Node* right = root->_right;
+                destroy(root);
+                root = right;
+            }
+        }
+    }
+
+    template <class Node>
+    size_t __BSTreeCount(Node* root)
+    {
+        size_t n = 0;
+        __BSTreeInOrder(root, [&n](Node*) { ++n; });
+        return n;
+    }
+
+    // 树高（节点层数），层序遍历
+    template <class Node>
+    size_t __BSTreeHeight(Node* root)
+    {
+        size_t height = 0;
+        std::vector<Node*> level;
+        std::vector<Node*> next;
+        if (root != nullptr)
+            level.push_back(root);
+        while (!level.empty())
+        {
+            ++height;
+            next.clear();
+            for (Node* node : level)
+            {
+                if (node->_left)
+                    next.push_back(node->_left);
+                if (node->_right)
+                    next.push_back(node->_right);
+            }
+            level.swap(next);
+        }
+        return height;
+    }
+
+    // 用中序排好的n个节点建完全平衡的树，递归深度只有log n
+    template <class Node>
+    Node* __BSTreeBuild(Node** nodes, size_t n)
+    {
+        if (n == 0)
+            return nullptr;
+        size_t mid = n / 2;
+        Node* root = nodes[mid];
+        root->_left = __BSTreeBuild(nodes, mid);
+        root->_right = __BSTreeBuild(nodes + mid + 1, n - mid - 1);
+        return root;
+    }
+
+    // 把以root为根、共n个节点的子树原地重建成完全平衡的，只改指针不重新分配节点
+    template <class Node>
+    Node* __BSTreeRebuild(Node* root, size_t n)
+    {
+        std::vector<Node*> nodes;
+        nodes.reserve(n);
+        __BSTreeInOrder(root, [&nodes](Node* node) { nodes.push_back(node); });
+        return __BSTreeBuild(nodes.data(), nodes.size());
+    }
+
+    // 替罪羊树（alpha = 2/3）：新节点深度超过log_{3/2}(size)时，
+    // 插入路径上一定有某个节点的一侧子树超过它自己的2/3，找到最低的这样一个节点把它的子树重建
+    inline size_t __ScapegoatDepthLimit(size_t size)
+    {
+        return static_cast<size_t>(std::log(static_cast<double>(size)) / std::log(1.5));
+    }
+
+    // depth: 新节点的深度（根为0），size: 插入后的节点数
+    template <class Node, class K>
+    void __ScapegoatInsertFixup(Node*& root, const K& key, size_t depth, size_t size)
+    {
+        if (depth <= __ScapegoatDepthLimit(size))
+            return;
+        // 超深的插入很少，这时才从根再走一遍记下路径
+        std::vector<Node*> path;
+        Node* cur = root;
+        while (cur->_key < key || cur->_key > key)
+        {
+            path.push_back(cur);
+            cur = cur->_key < key ? cur->_right : cur->_left;
+        }
+        Node* child = cur;
+        size_t childSize = 1;
+        for (size_t i = path.size(); i-- > 0;)
+        {
+            Node* parent = path[i];
+            Node* sibling = parent->_left == child ? parent->_right : parent->_left;
+            size_t parentSize = childSize + 1 + __BSTreeCount(sibling);
+            if (childSize * 3 > parentSize * 2)  // parent就是替罪羊
+            {
+                Node* rebuilt = __BSTreeRebuild(parent, parentSize);
+                if (i == 0)
+                    root = rebuilt;
+                else if (path[i - 1]->_left == parent)
+                    path[i - 1]->_left = rebuilt;
+                else
+                    path[i - 1]->_right = rebuilt;
+                return;
+            }
+            child = parent;
+            childSize = parentSize;
+        }
+    }
+
+    // 删除后节点数降到历史最大值的2/3以下就整棵重建
+    template <class Node>
+    void __ScapegoatEraseFixup(Node*& root, size_t size, size_t& maxSize)
+    {
+        if (size * 3 < maxSize * 2)
+        {
+            root = __BSTreeRebuild(root, size);
+            maxSize = size;
+        }
+    }
+
     template <class K>
     struct BSTreeNode
     {
@@ -18,24 +179,30 @@ namespace pzh
         {}
     };
 
-    template <class K>
+    // Alloc: 键的分配器，内部rebind成节点的分配器（比如pzh::pool_allocator让节点走内存池）
+    // Balanced: true时按替罪羊树维护平衡，有序插入树高也是O(log n)；false时就是普通二叉搜索树
+    template <class K, class Alloc = std::allocator<K>, bool Balanced = false>
     class BSTree
     {
         typedef BSTreeNode<K> Node;
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc;
 
     public:
         bool Insert(const K& key) //插入函数
         {
             if (_root == nullptr)
             {
-                _root = new Node(key);
+                _root = CreateNode(key);
+                AfterInsert(key, 0);
                 return true;
             }
             Node* parent = nullptr;
             Node* cur = _root;  // 当前节点从根开始
+            size_t depth = 0;   // 新节点的深度
             while (cur != nullptr)
             {
                 parent = cur;
+                ++depth;
                 if (cur->_key < key)  // 插入的值大于当前值
                 {
                     cur = cur->_right;  // 向右子树移动
@@ -49,7 +216,7 @@ namespace pzh
                     return false;  // 关键值已存在，插入失败
                 }
             }
-            cur = new Node(key);
+            cur = CreateNode(key);
             if (parent->_key < key)  // 将新节点连接到父节点
             {
                 parent->_right = cur;
@@ -58,6 +225,7 @@ namespace pzh
             {
                 parent->_left = cur;
             }
+            AfterInsert(key, depth);
             return true;
         }
 
@@ -119,7 +287,7 @@ namespace pzh
                                 parent->_right = cur->_right;
                             }
                         }
-                        delete cur;
+                        DestroyNode(cur);
                     }
                     else if (cur->_right == nullptr)  // 情况2：删除的节点右子节点为空
                     {
@@ -138,7 +306,7 @@ namespace pzh
                                 parent->_right = cur->_left;
                             }
                         }
-                        delete cur;
+                        DestroyNode(cur);
                     }
                     else  // 情况3：节点左右子节点都不为空
                     {
@@ -158,14 +326,25 @@ namespace pzh
                             parent->_left = subLeft->_right;
                         else
                             parent->_right = subLeft->_right;
-                        delete subLeft;
+                        DestroyNode(subLeft);
                     }
+                    AfterErase();
                     return true;
                 }
             }
             return false;
         }
 
+        size_t Size() const
+        {
+            return _size;
+        }
+
+        size_t Height() const
+        {
+            return __BSTreeHeight(_root);
+        }
+
         //类外面无法传根，类里面可以（c++写递归函数的逻辑）
         void InOrder()
         {
@@ -173,19 +352,52 @@ namespace pzh
             cout << endl;
         }
 
-        bool FindR(const K& key) // R代表递归版本
+        // R版本：不记父节点，拿着“父节点里指向当前节点的那根指针”往下走，改它就是改父节点的链接
+        // 原来是递归传Node*&，这里换成循环里的Node**，退化成链表的树上也不会爆栈
+        bool FindR(const K& key)
         {
-            return _FindR(_root, key);
+            return *FindLink(key) != nullptr;
         }
 
         bool InsertR(const K& key)
         {
-            return _InsertR(_root, key);
+            size_t depth = 0;
+            Node** link = FindLink(key, &depth);
+            if (*link != nullptr)
+                return false;
+            *link = CreateNode(key);
+            AfterInsert(key, depth);
+            return true;
         }
 
         bool EraseR(const K& key)
         {
-            return _EraseR(_root, key);
+            Node** link = FindLink(key);
+            Node* del = *link;
+            if (del == nullptr)
+                return false;
+            if (del->_left == nullptr)  // 情况1：节点左子节点为空
+            {
+                *link = del->_right;
+            }
+            else if (del->_right == nullptr)  // 情况2：节点右子节点为空
+            {
+                *link = del->_left;
+            }
+            else  // 情况3：左右都不为空，和右子树的最小节点换key，再摘掉那个节点（它没有左孩子）
+            {
+                Node** minLink = &del->_right;
+                while ((*minLink)->_left)
+                {
+                    minLink = &(*minLink)->_left;
+                }
+                swap(del->_key, (*minLink)->_key);
+                del = *minLink;
+                *minLink = del->_right;
+            }
+            DestroyNode(del);
+            AfterErase();
+            return true;
         }
 
         ///////////////////////////////////////////////////////////////
@@ -198,135 +410,124 @@ namespace pzh
         }
 
         // 拷贝构造函数（深拷贝）
-        BSTree(const BSTree<K>& t)
+        BSTree(const BSTree& t)
         {
             _root = Copy(t._root);  // 复制整棵树
+            _size = t._size;
+            _maxSize = t._size;
         }
 
         // t1 = t3
         // 赋值运算符重载（采用拷贝交换）
-        BSTree<K>& operator=(BSTree<K> t)
+        BSTree& operator=(BSTree t)
         {
             swap(_root, t._root);
+            swap(_size, t._size);
+            swap(_maxSize, t._maxSize);
             return *this;
         }
 
     private:
-        // 删除函数（递归实现）
-        bool _EraseR(Node*& root, const K& key)
+        // 返回指向key所在节点的那根链接（_root或者父节点的_left/_right）；key不存在时就是新节点该挂的那根空链接
+        // depth不为空时带出经过的节点数，也就是新节点的深度，替罪羊树要用
+        Node** FindLink(const K& key, size_t* depth = nullptr)
         {
-            if (root == nullptr)
-                return false;
-            // 递归查找要删除的节点
-            if (root->_key < key)
-            {
-                return _EraseR(root->_right, key);
-            }
-            else if (root->_key > key)
+            Node** link = &_root;
+            while (*link != nullptr)
             {
-                return _EraseR(root->_left, key);
-            }
-            else   // 找到要删除的节点，分三种情况处理
-            {
-                if (root->_left == nullptr)  // 情况1：节点左子节点为空
-                {
-                    Node* del = root;
-                    root = root->_right;
-                    delete del;
-                    return true;
-                }
-                else if (root->_right == nullptr)  // 情况2：节点右子节点为空
-                {
-                    Node* del = root;
-                    root = root->_left;
-                    delete del;
-                    return true;
-                }
-                else  // 情况3：节点左右子节点都不为空
-                {
-                    Node* subLeft = root->_right;
-                    while (subLeft->_left)
-                    {
-                        subLeft = subLeft->_left;
-                    }
-                    swap(root->_key, subLeft->_key);
-                    // 递归删除右子树中的后继节点
-                    return _EraseR(root->_right, key);
-                }
+                if ((*link)->_key < key)
+                    link = &(*link)->_right;
+                else if ((*link)->_key > key)
+                    link = &(*link)->_left;
+                else
+                    break;
+                if (depth)
+                    ++*depth;
             }
+            return link;
         }
 
-        bool _InsertR(Node*& root, const K& key)
+        void _InOrder(Node* root) //中序遍历函数
         {
-            if (root == nullptr)
-            {
-                root = new Node(key);
-                return true;
-            }
-            // 递归寻找插入位置
-            if (root->_key < key)
-                return _InsertR(root->_right, key);
-            else if (root->_key > key)
-                return _InsertR(root->_left, key);
-            else
-                return false;
+            __BSTreeInOrder(root, [](Node* node) { cout << node->_key << " "; });
         }
 
-        bool _FindR(Node* root, const K& key)
+        // 插入成功后调用：计数，平衡模式下检查新节点深度，必要时重建替罪羊子树
+        void AfterInsert(const K& key, size_t depth)
         {
-            if (root == nullptr)
+            ++_size;
+            if constexpr (Balanced)
             {
-                return false;
+                if (_size > _maxSize)
+                    _maxSize = _size;
+                __ScapegoatInsertFixup(_root, key, depth, _size);
             }
-            if (root->_key < key)
+        }
+
+        void AfterErase()
+        {
+            --_size;
+            if constexpr (Balanced)
             {
-                return _FindR(root->_right, key);
+                __ScapegoatEraseFixup(_root, _size, _maxSize);
             }
-            else if (root->_key > key)
+        }
+
+        ///////////////////////////////////////////////////////////////
+        // 复制树（深拷贝），显式栈
+        Node* Copy(Node* root)
+        {
+            Node* newRoot = nullptr;
+            std::vector<pair<Node*, Node**>> st;  // （源节点，新节点要挂的位置）
+            st.push_back({root, &newRoot});
+            try
             {
-                return _FindR(root->_left, key);
+                while (!st.empty())
+                {
+                    auto [src, slot] = st.back();
+                    st.pop_back();
+                    if (src == nullptr)
+                        continue;
+                    *slot = CreateNode(src->_key);
+                    st.push_back({src->_right, &(*slot)->_right});
+                    st.push_back({src->_left, &(*slot)->_left});
+                }
             }
-            else
+            catch (...)
             {
-                return true;
+                Destroy(newRoot);  // 已经复制的部分本身是一棵完整的树
+                throw;
             }
+            return newRoot;
         }
 
-        void _InOrder(Node* root) //中序遍历函数
+        // 销毁树
+        void Destroy(Node*& root)
         {
-            if (root == nullptr)
-                return;
-            _InOrder(root->_left);
-            cout << root->_key << " ";
-            _InOrder(root->_right);
+            __BSTreeDestroy(root, [this](Node* node) { DestroyNode(node); });
+            root = nullptr;
         }
 
-        ///////////////////////////////////////////////////////////////
-        // 复制树（深拷贝）
-        Node* Copy(Node* root)
+        Node* CreateNode(const K& key)
         {
-            if (root == nullptr)
-                return nullptr;
-            Node* newRoot = new Node(root->_key);
-            newRoot->_left = Copy(root->_left);
-            newRoot->_right = Copy(root->_right);
-            return newRoot;
+            return pzh::__AllocateNode(_alloc, key);
         }
 
-        // 销毁树（后序遍历释放内存）
-        void Destroy(Node*& root)
+        void DestroyNode(Node* node)
         {
-            if (root == nullptr)
-                return;
-            Destroy(root->_left);
-            Destroy(root->_right);
-            delete root;
-            root = nullptr;
+            pzh::__DestroyNode(_alloc, node);
         }
 
     private:
         Node* _root = nullptr;
+        size_t _size = 0;
+        size_t _maxSize = 0;  // 上次整棵重建以来的最大节点数，替罪羊树删除时用
+        [[no_unique_address]] NodeAlloc _alloc;
     };
+
+    // 替罪羊树
+    template <class K, class Alloc = std::allocator<K>>
+    using ScapegoatTree = BSTree<K, Alloc, true>;
 }
 
 // 键值对版本的二叉搜索树命名空间
@@ -348,25 +549,38 @@ namespace kv
         {}
     };
 
-    // 键值对二叉搜索树模板类
-    template <class K, class V>
+    // 键值对二叉搜索树模板类，Balanced同pzh::BSTree
+    template <class K, class V, class Alloc = std::allocator<pair<K, V>>, bool Balanced = false>
     class BSTree
     {
         typedef BSTreeNode<K, V> Node;
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc;
 
     public:
+        BSTree() = default;
+        BSTree(const BSTree&) = delete;
+        BSTree& operator=(const BSTree&) = delete;
+
+        ~BSTree()
+        {
+            Destroy(_root);
+        }
+
         bool Insert(const K& key, const V& value)
         {
             if (_root == nullptr)
             {
-                _root = new Node(key, value);
+                _root = CreateNode(key, value);
+                AfterInsert(key, 0);
                 return true;
             }
             Node* parent = nullptr;
             Node* cur = _root;
+            size_t depth = 0;
             while (cur != nullptr)
             {
                 parent = cur;
+                ++depth;
                 if (cur->_key < key)
                 {
                     cur = cur->_right;
@@ -381,7 +595,7 @@ namespace kv
                 }
             }
             // 创建新节点并连接到父节点
-            cur = new Node(key, value);
+            cur = CreateNode(key, value);
             if (parent->_key < key)
             {
                 parent->_right = cur;
@@ -390,6 +604,7 @@ namespace kv
             {
                 parent->_left = cur;
             }
+            AfterInsert(key, depth);
             return true;
         }
 
@@ -451,6 +666,7 @@ namespace kv
                                 parent->_right = cur->_right;
                             }
                         }
+                        DestroyNode(cur);
                     }
                     else if (cur->_right == nullptr)  // 情况2：右子节点为空
                     {
@@ -469,6 +685,7 @@ namespace kv
                                 parent->_right = cur->_left;
                             }
                         }
+                        DestroyNode(cur);
                     }
                     else    // 情况3：左右子节点都不为空
                     {
@@ -480,18 +697,32 @@ namespace kv
                             parent = subLeft;
                             subLeft = subLeft->_left;
                         }
+                        // 键和值要一起换，否则cur留下的是后继的键配被删节点的值
                         swap(cur->_key, subLeft->_key);
+                        swap(cur->_value, subLeft->_value);
                         if (subLeft == parent->_left)
                             parent->_left = subLeft->_right;
                         else
                             parent->_right = subLeft->_right;
+                        DestroyNode(subLeft);
                     }
+                    AfterErase();
                     return true;
                 }
             }
             return false;   // 未找到要删除的键
         }
 
+        size_t Size() const
+        {
+            return _size;
+        }
+
+        size_t Height() const
+        {
+            return pzh::__BSTreeHeight(_root);
+        }
+
         void InOrder()
         {
             _InOrder(_root);
@@ -501,14 +732,49 @@ namespace kv
     private:
         void _InOrder(Node* root)
         {
-            if (root == nullptr)
-                return;
-            _InOrder(root->_left);
-            cout << root->_key << ":" << root->_value << endl;
-            _InOrder(root->_right);
+            pzh::__BSTreeInOrder(root, [](Node* node) { cout << node->_key << ":" << node->_value << endl; });
+        }
+
+        void AfterInsert(const K& key, size_t depth)
+        {
+            ++_size;
+            if constexpr (Balanced)
+            {
+                if (_size > _maxSize)
+                    _maxSize = _size;
+                pzh::__ScapegoatInsertFixup(_root, key, depth, _size);
+            }
+        }
+
+        void AfterErase()
+        {
+            --_size;
+            if constexpr (Balanced)
+            {
+                pzh::__ScapegoatEraseFixup(_root, _size, _maxSize);
+            }
+        }
+
+        Node* CreateNode(const K& key, const V& value)
+        {
+            return pzh::__AllocateNode(_alloc, key, value);
+        }
+
+        void DestroyNode(Node* node)
+        {
+            pzh::__DestroyNode(_alloc, node);
+        }
+
+        // 销毁树
+        void Destroy(Node* root)
+        {
+            pzh::__BSTreeDestroy(root, [this](Node* node) { DestroyNode(node); });
         }
 
     private:
         Node* _root = nullptr;
+        size_t _size = 0;
+        size_t _maxSize = 0;
+        [[no_unique_address]] NodeAlloc _alloc;
     };
 }
@@ -1,6 +1,163 @@
 #include"BinarySearchTree.h"
+#include<set>
+#include<vector>
+#include<ctime>
+#include<algorithm>
+#include<random>
+
+// kv::BSTreeɾҶʱֵҪһ𻻵ɾλ
+void test_kv_erase()
+{
+    kv::BSTree<int, int> t;
+    int a[] = {8, 3, 1, 10, 6, 4, 7, 14, 13};
+    for (auto e : a)
+    {
+        t.Insert(e, e * 100);
+    }
+    bool ok = t.Erase(3) && t.Erase(8) && !t.Erase(8) && t.Size() == 7;
+    for (auto e : a)
+    {
+        kv::BSTreeNode<int, int>* ret = t.Find(e);
+        if (e == 3 || e == 8)
+            ok = ok && ret == nullptr;
+        else
+            ok = ok && ret != nullptr && ret->_value == e * 100;
+    }
+    cout << "test_kv_erase: " << (ok ? "ok" : "FAILED") << endl;
+}
+
+// ɾstd::setģ߲log_{3/2}(n) + 1
+void test_scapegoat()
+{
+    pzh::ScapegoatTree<int> t;
+    set<int> ref;
+    bool ok = true;
+    srand(12345);
+    for (int i = 0; i < 50000; i++)
+    {
+        int key = rand() % 5000;
+        switch (rand() % 4)
+        {
+        case 0:
+            ok = ok && t.Erase(key) == (ref.erase(key) == 1);
+            break;
+        case 1:
+            ok = ok && t.EraseR(key) == (ref.erase(key) == 1);
+            break;
+        case 2:
+            ok = ok && t.InsertR(key) == ref.insert(key).second;
+            break;
+        default:
+            ok = ok && t.Insert(key) == ref.insert(key).second;
+            break;
+        }
+        if (i % 1000 == 0)
+            ok = ok && t.Height() <= pzh::__ScapegoatDepthLimit(max<size_t>(ref.size(), 1)) + 1;
+    }
+    ok = ok && t.Size() == ref.size();
+    for (int key = -1; key <= 5000; key++)
+    {
+        ok = ok && t.Find(key) == (ref.count(key) == 1) && t.FindR(key) == (ref.count(key) == 1);
+    }
+
+    // ͸ֵ֮Զ
+    pzh::ScapegoatTree<int> copy(t);
+    pzh::ScapegoatTree<int> assigned;
+    assigned = t;
+    t.Erase(*ref.begin());
+    ok = ok && copy.Size() == ref.size() && copy.Find(*ref.begin()) && assigned.Find(*ref.begin());
+
+    // 100Ȼƽģݹ汾Ҳᱬջ
+    kv::BSTree<int, int, std::allocator<pair<int, int>>, true> big;
+    const int n = 1000000;
+    for (int i = 0; i < n; i++)
+    {
+        big.Insert(i, i);
+    }
+    ok = ok && big.Size() == n && big.Height() <= pzh::__ScapegoatDepthLimit(n) + 1 && big.Find(n - 1)->_value == n - 1;
+    cout << "test_scapegoat: " << (ok ? "ok" : "FAILED") << " height(1e6 sorted) = " << big.Height() << endl;
+}
+
+// R汾˻ϣߵڽڵInsertR/FindR/EraseRѭռջ
+void test_R_degenerate()
+{
+    const int n = 20000;
+    pzh::BSTree<int> t;
+    bool ok = true;
+    for (int i = 0; i < n; i++)
+    {
+        ok = ok && t.InsertR(i);
+    }
+    ok = ok && t.Height() == n && !t.InsertR(n - 1);
+    for (int i = 0; i < n; i++)
+    {
+        ok = ok && t.FindR(i);
+    }
+    ok = ok && !t.FindR(n) && !t.FindR(-1);
+    // һɾһÿζҪߵĩβ
+    for (int i = n - 1; i >= 0; i -= 2)
+    {
+        ok = ok && t.EraseR(i);
+    }
+    ok = ok && t.Size() == n / 2 && !t.EraseR(n - 1) && t.FindR(n - 2);
+    cout << "test_R_degenerate: " << (ok ? "ok" : "FAILED") << endl;
+}
+
+template <class Tree>
+void BenchBSTree(const char* name, const vector<int>& keys)
+{
+    clock_t begin = clock();
+    {
+        Tree t;
+        for (int key : keys)
+        {
+            t.Insert(key);
+        }
+        clock_t inserted = clock();
+        size_t found = 0;
+        for (int key : keys)
+        {
+            found += t.Find(key);
+        }
+        clock_t searched = clock();
+        cout << "  " << name << ": insert " << inserted - begin << " find " << searched - inserted
+            << " height " << t.Height() << (found == keys.size() ? "" : " FAILED") << endl;
+        begin = clock();
+    }
+    // ѭ˻Ҳᱬջ
+    cout << "    destroy " << clock() - begin << endl;
+}
+
+// ͨĶԱ
+// ͨ˻O(n^2)n̫
+void test_BSTree_bench()
+{
+    const int n = 20000;
+    vector<int> sorted(n);
+    for (int i = 0; i < n; i++)
+    {
+        sorted[i] = i;
+    }
+    vector<int> reversed(sorted.rbegin(), sorted.rend());
+    vector<int> shuffled(sorted);
+    shuffle(shuffled.begin(), shuffled.end(), mt19937(42));
+
+    pair<const char*, const vector<int>*> inputs[] = {{"sorted", &sorted}, {"reversed", &reversed}, {"random", &shuffled}};
+    for (auto& [name, keys] : inputs)
+    {
+        cout << name << " n = " << n << endl;
+        BenchBSTree<pzh::BSTree<int>>("BSTree", *keys);
+        BenchBSTree<pzh::ScapegoatTree<int>>("ScapegoatTree", *keys);
+    }
+}
+
 int main()
 {
+    test_kv_erase();
+    test_scapegoat();
+    test_R_degenerate();
+    test_BSTree_bench();
+
     int a1[] = {8, 3, 1, 10, 6, 4, 7, 14, 13};
     // 
     pzh::BSTree<int> tr1;
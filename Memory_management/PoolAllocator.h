@@ -0,0 +1,298 @@
+#pragma once
+#include<cstddef>
+#include<cstdlib>
+#include<new>
+#include<mutex>
+#include<memory>
+#include<utility>
+
+// 定长内存池：给链表/树/哈希桶这类“一次只要一个节点”的容器用
+//   1. 按16字节对齐的块大小分档，同一档的节点共享一个池
+//   2. 每个线程有自己的空闲链表，分配和释放都不加锁
+//   3. 线程缓存空了，先去全局仓库批量取；仓库也空了，再向系统要一整块slab切开
+//   4. 线程缓存太多时，批量还给仓库；线程退出时，剩下的全部还给仓库
+//   5. slab一旦申请就不再还给系统，同一个slab切出来的节点在内存里是连续的
+namespace pzh_pool
+{
+    static const size_t kAlign = 16;          // 块大小按16字节对齐（malloc至少保证这个对齐）
+    static const size_t kMaxBlockSize = 256;  // 超过这个大小的节点不走内存池
+    static const size_t kSlabBytes = 64 * 1024;
+    static const size_t kBatch = 64;          // 线程缓存和仓库之间一次搬运的块数
+
+    template<size_t BlockSize>
+    class FixedPool
+    {
+        struct FreeNode
+        {
+            FreeNode* _next;
+        };
+
+        // 全局仓库：一条一条的批次挂在一起，取还都是整批操作
+        struct Depot
+        {
+            std::mutex _mtx;
+            FreeNode* _batches = nullptr;  // 每个批次的头节点，批次之间用BatchHead::_nextBatch串起来
+        };
+
+        // 批次头节点里额外存下一批次的指针（块大小至少16字节，放得下两个指针）
+        struct BatchHead
+        {
+            FreeNode* _next;
+            BatchHead* _nextBatch;
+        };
+
+        struct ThreadCache
+        {
+            FreeNode* _free = nullptr;
+            size_t _count = 0;
+
+            ~ThreadCache()
+            {
+                CacheDestroyed() = true;
+                // 线程退出：剩下的块按批次还给仓库，其他线程还能接着用
+                while (_count > 0)
+                    FixedPool::ReleaseBatch(*this, _count < kBatch ? _count : kBatch);
+            }
+        };
+
+        static_assert(BlockSize % kAlign == 0 && BlockSize >= sizeof(BatchHead), "bad block size");
+
+        // 仓库故意不析构：线程缓存可能在静态对象析构之后才退出
+        static Depot& GetDepot()
+        {
+            static Depot* depot = new Depot;
+            return *depot;
+        }
+
+        // 线程缓存析构后的标记，bool没有析构函数，线程退出的全过程都能安全访问
+        static bool& CacheDestroyed()
+        {
+            thread_local bool destroyed = false;
+            return destroyed;
+        }
+
+        static ThreadCache& GetCache()
+        {
+            thread_local ThreadCache cache;
+            return cache;
+        }
+
+        // 从线程缓存的链表头摘下count个块，作为一个批次挂到仓库上
+        static void ReleaseBatch(ThreadCache& cache, size_t count)
+        {
+            FreeNode* head = cache._free;
+            FreeNode* tail = head;
+            for (size_t i = 1; i < count; ++i)
+                tail = tail->_next;
+            cache._free = tail->_next;
+            cache._count -= count;
+            tail->_next = nullptr;
+
+            Depot& depot = GetDepot();
+            std::lock_guard<std::mutex> lock(depot._mtx);
+            BatchHead* batch = (BatchHead*)head;
+            batch->_nextBatch = (BatchHead*)depot._batches;
+            depot._batches = head;
+        }
+
+        // 线程缓存空了：优先从仓库拿一批，否则切一个新slab
+        static void Refill(ThreadCache& cache)
+        {
+            Depot& depot = GetDepot();
+            {
+                std::lock_guard<std::mutex> lock(depot._mtx);
+                if (depot._batches)
+                {
+                    BatchHead* batch = (BatchHead*)depot._batches;
+                    depot._batches = (FreeNode*)batch->_nextBatch;
+                    FreeNode* node = (FreeNode*)batch;
+                    size_t count = 0;
+                    for (FreeNode* cur = node; cur; cur = cur->_next)
+                        ++count;
+                    cache._free = node;
+                    cache._count = count;
+                    return;
+                }
+            }
+
+            cache._free = NewSlab();
+            cache._count = kSlabBytes / BlockSize;
+        }
+
+        // 向系统要一整块slab，切成kSlabBytes / BlockSize个块串成链表
+        static FreeNode* NewSlab()
+        {
+            char* slab = (char*)malloc(kSlabBytes);
+            if (slab == nullptr)
+                throw std::bad_alloc();
+            // 按地址从低到高串起来，连续分配出去的节点在内存里也是连续的
+            FreeNode* head = nullptr;
+            for (size_t i = kSlabBytes / BlockSize; i > 0; --i)
+            {
+                FreeNode* node = (FreeNode*)(slab + (i - 1) * BlockSize);
+                node->_next = head;
+                head = node;
+            }
+            return head;
+        }
+
+        // 线程缓存已经析构时的分配：直接从仓库的第一个批次里取一块，剩下的仍是一个批次
+        static void* AllocateFromDepot()
+        {
+            Depot& depot = GetDepot();
+            std::lock_guard<std::mutex> lock(depot._mtx);
+            if (depot._batches == nullptr)
+            {
+                depot._batches = NewSlab();
+                ((BatchHead*)depot._batches)->_nextBatch = nullptr;
+            }
+            BatchHead* batch = (BatchHead*)depot._batches;
+            FreeNode* node = depot._batches;
+            if (node->_next)
+            {
+                ((BatchHead*)node->_next)->_nextBatch = batch->_nextBatch;
+                depot._batches = node->_next;
+            }
+            else
+            {
+                depot._batches = (FreeNode*)batch->_nextBatch;
+            }
+            return node;
+        }
+
+    public:
+        static void* Allocate()
+        {
+            // 线程退出阶段（线程缓存已经析构）还在分配，不能再碰GetCache()
+            if (CacheDestroyed())
+                return AllocateFromDepot();
+            ThreadCache& cache = GetCache();
+            if (cache._free == nullptr)
+                Refill(cache);
+            FreeNode* node = cache._free;
+            cache._free = node->_next;
+            --cache._count;
+            return node;
+        }
+
+        // 可以在任意线程释放：块挂到当前线程的缓存里
+        static void Deallocate(void* p)
+        {
+            FreeNode* node = (FreeNode*)p;
+            if (CacheDestroyed())
+            {
+                // 线程缓存已经析构（比如静态容器在退出阶段释放节点），直接作为单块批次还给仓库
+                node->_next = nullptr;
+                Depot& depot = GetDepot();
+                std::lock_guard<std::mutex> lock(depot._mtx);
+                ((BatchHead*)node)->_nextBatch = (BatchHead*)depot._batches;
+                depot._batches = node;
+                return;
+            }
+            ThreadCache& cache = GetCache();
+            node->_next = cache._free;
+            cache._free = node;
+            ++cache._count;
+            // 缓存超过一个slab再多两批时还一批给仓库，避免只释放不分配的线程一直攒着
+            if (cache._count >= 2 * kBatch + kSlabBytes / BlockSize)
+                ReleaseBatch(cache, kBatch);
+        }
+    };
+
+    inline constexpr size_t RoundUp(size_t bytes)
+    {
+        return (bytes + kAlign - 1) & ~(kAlign - 1);
+    }
+}
+
+namespace pzh
+{
+    // 符合标准库Allocator要求的节点分配器，可以直接作为各容器的Alloc模板参数
+    // 单个对象的分配走内存池，数组分配（n > 1）和大对象仍然交给operator new（按缓存行对齐的节点走对齐版本）
+    template<class T>
+    class pool_allocator
+    {
+    public:
+        typedef T value_type;
+
+        pool_allocator() noexcept = default;
+
+        template<class U>
+        pool_allocator(const pool_allocator<U>&) noexcept
+        {}
+
+        T* allocate(size_t n)
+        {
+            if constexpr (UsePool())
+            {
+                if (n == 1)
+                    return (T*)pzh_pool::FixedPool<pzh_pool::RoundUp(sizeof(T))>::Allocate();
+            }
+            if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                return (T*)::operator new(n * sizeof(T), std::align_val_t(alignof(T)));
+            return (T*)::operator new(n * sizeof(T));
+        }
+
+        void deallocate(T* p, size_t n) noexcept
+        {
+            if constexpr (UsePool())
+            {
+                if (n == 1)
+                {
+                    pzh_pool::FixedPool<pzh_pool::RoundUp(sizeof(T))>::Deallocate(p);
+                    return;
+                }
+            }
+            if constexpr (alignof(T) > __STDCPP_DEFAULT_NEW_ALIGNMENT__)
+                ::operator delete(p, std::align_val_t(alignof(T)));
+            else
+                ::operator delete(p);
+        }
+
+        // 无状态：任意两个pool_allocator分配的内存都可以互相释放
+        template<class U>
+        bool operator==(const pool_allocator<U>&) const noexcept
+        {
+            return true;
+        }
+
+        template<class U>
+        bool operator!=(const pool_allocator<U>&) const noexcept
+        {
+            return false;
+        }
+
+    private:
+        static constexpr bool UsePool()
+        {
+            return sizeof(T) <= pzh_pool::kMaxBlockSize && alignof(T) <= pzh_pool::kAlign;
+        }
+    };
+
+    // 链表/树/哈希桶分配单个节点：allocate + construct，构造抛异常时把内存还回去，不会泄漏
+    template<class NodeAlloc, class... Args>
+    typename std::allocator_traits<NodeAlloc>::value_type* __AllocateNode(NodeAlloc& alloc, Args&&... args)
+    {
+        typedef std::allocator_traits<NodeAlloc> Traits;
+        typename Traits::value_type* node = Traits::allocate(alloc, 1);
+        try
+        {
+            Traits::construct(alloc, node, std::forward<Args>(args)...);
+        }
+        catch (...)
+        {
+            Traits::deallocate(alloc, node, 1);
+            throw;
+        }
+        return node;
+    }
+
+    // 与__AllocateNode配对：destroy + deallocate
+    template<class NodeAlloc>
+    void __DestroyNode(NodeAlloc& alloc, typename std::allocator_traits<NodeAlloc>::value_type* node)
+    {
+        typedef std::allocator_traits<NodeAlloc> Traits;
+        Traits::destroy(alloc, node);
+        Traits::deallocate(alloc, node, 1);
+    }
+}
@@ -2,8 +2,15 @@
 #include <cstdlib>   // for malloc, calloc, realloc, free
 #include <new>       // for placement new, bad_alloc
 #include <exception> // for exception
+#include <vector>
+#include <list>
+#include <map>
+#include <thread>
+#include <ctime>
 using namespace std;
 
+#include "PoolAllocator.h"
+
 
 // C/C++ 内存分布
 namespace Memory_Layout
@@ -278,6 +285,142 @@ namespace LowLevel
     }
 }
 
+// 定长内存池 (pzh::pool_allocator)
+namespace Pool_Allocation
+{
+    struct Node32
+    {
+        char _buf[32];
+    };
+
+    // 节点churn：反复插入删除，对比默认分配器和内存池
+    template<class List>
+    size_t ListChurn(size_t n, int rounds)
+    {
+        size_t begin = clock();
+        List lt;
+        for (int r = 0; r < rounds; ++r)
+        {
+            for (size_t i = 0; i < n; ++i)
+                lt.push_back((int)i);
+            for (size_t i = 0; i < n; ++i)
+                lt.pop_front();
+        }
+        return clock() - begin;
+    }
+
+    template<class Map>
+    size_t MapChurn(const vector<int>& keys)
+    {
+        size_t begin = clock();
+        Map m;
+        for (auto e : keys)
+            m[e] = e;
+        for (size_t i = 0; i < keys.size(); i += 2)
+            m.erase(keys[i]);
+        for (auto e : keys)
+            m[e] = e;
+        return clock() - begin;
+    }
+
+    // 线程退出阶段才分配/释放：构造顺序在线程缓存之前，析构时线程缓存已经没了
+    struct ExitTimeUser
+    {
+        bool* _ok = nullptr;
+
+        ~ExitTimeUser()
+        {
+            pzh::pool_allocator<Node32> a;
+            Node32* node = a.allocate(1);
+            node->_buf[0] = 'x';
+            *_ok = node->_buf[0] == 'x';
+            a.deallocate(node, 1);
+        }
+    };
+
+    void Test()
+    {
+        cout << "--------------------------------------------------------" << endl;
+        cout << "[Pool_Allocation] Testing pool_allocator..." << endl;
+
+        // 1. 同一个slab切出来的块是连续的
+        pzh::pool_allocator<Node32> alloc;
+        Node32* p[4];
+        for (auto& e : p)
+            e = alloc.allocate(1);
+        cout << "连续分配的地址间隔: " << (char*)p[1] - (char*)p[0] << " "
+             << (char*)p[2] - (char*)p[1] << " " << (char*)p[3] - (char*)p[2] << endl;
+        // 释放后再分配，拿回的是最后释放的块
+        alloc.deallocate(p[3], 1);
+        cout << "释放后复用: " << (alloc.allocate(1) == p[3] ? "ok" : "error") << endl;
+        for (auto e : p)
+            alloc.deallocate(e, 1);
+
+        // 2. 多线程：一个线程分配、另一个线程释放，块会在线程缓存和全局仓库之间流转
+        const int kThreads = 4;
+        const size_t kPerThread = 100000;
+        vector<vector<Node32*>> blocks(kThreads);
+        vector<thread> threads;
+        for (int t = 0; t < kThreads; ++t)
+        {
+            threads.emplace_back([&, t]() {
+                pzh::pool_allocator<Node32> a;
+                for (size_t i = 0; i < kPerThread; ++i)
+                {
+                    Node32* node = a.allocate(1);
+                    node->_buf[0] = (char)t;
+                    blocks[t].push_back(node);
+                }
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+        threads.clear();
+        bool ok = true;
+        for (int t = 0; t < kThreads; ++t)
+        {
+            // 线程t释放线程(t+1)分配的块
+            threads.emplace_back([&, t]() {
+                pzh::pool_allocator<Node32> a;
+                int owner = (t + 1) % kThreads;
+                for (auto node : blocks[owner])
+                {
+                    if (node->_buf[0] != (char)owner)
+                        ok = false;
+                    a.deallocate(node, 1);
+                }
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+        cout << "跨线程分配/释放: " << (ok ? "ok" : "error") << endl;
+
+        bool exitOk = false;
+        thread([&]() {
+            thread_local ExitTimeUser user;
+            user._ok = &exitOk;
+            pzh::pool_allocator<Node32> a;
+            a.deallocate(a.allocate(1), 1);
+        }).join();
+        cout << "线程缓存析构后分配: " << (exitOk ? "ok" : "error") << endl;
+
+        // 3. 性能对比
+        const size_t N = 100000;
+        size_t t1 = ListChurn<list<int>>(N, 20);
+        size_t t2 = ListChurn<list<int, pzh::pool_allocator<int>>>(N, 20);
+        cout << "list churn  std::allocator:" << t1 << " pool_allocator:" << t2 << endl;
+
+        vector<int> keys;
+        srand(time(0));
+        for (size_t i = 0; i < 1000000; ++i)
+            keys.push_back(rand() % (1 << 30) + (int)i);
+        size_t t3 = MapChurn<map<int, int>>(keys);
+        size_t t4 = MapChurn<map<int, int, less<int>, pzh::pool_allocator<pair<const int, int>>>>(keys);
+        cout << "map churn   std::allocator:" << t3 << " pool_allocator:" << t4 << endl;
+        cout << "[Pool_Allocation] Test finished." << endl;
+    }
+}
+
 int main()
 {
     // 1. 内存分布展示
@@ -295,5 +438,8 @@ int main()
     // 5. 底层内存操作 (Placement New)
     LowLevel::Test();
 
+    // 6. 定长内存池
+    Pool_Allocation::Test();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,976 @@
+#pragma once
+#include <iostream>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <utility>
+#include <type_traits>
+#include <tuple>
+#include <algorithm>
+#include <functional>
+#include "../Template_Advanced/reverse_iterator.h"
+
+// B+树：pzh::map / pzh::set 的另一种底层实现
+//   1. 一个节点放几十个元素，节点按缓存行对齐，查找时每层只碰一两个缓存行，树高只有红黑树的几分之一
+//   2. 元素只放在叶子里，内部节点只存分隔key和孩子指针，扇出尽量大
+//   3. 叶子之间用双向链表串起来，中序遍历就是顺着链表扫数组
+// 与RBTree的区别：插入、删除会在节点内挪动元素，之后原来的迭代器/指针全部失效
+
+// 节点内的定长数组：只开存储不构造，前n个槽位有效（n由所在节点记录），不要求T能默认构造
+template<class T, size_t N>
+struct BPlusSlots
+{
+    alignas(T) unsigned char _buf[N * sizeof(T)];
+
+    T* Data()
+    {
+        return reinterpret_cast<T*>(_buf);
+    }
+
+    T& operator[](size_t i)
+    {
+        return Data()[i];
+    }
+
+    // 在n个有效元素的第i个位置插入，[i, n)整体后移一位
+    template<class U>
+    void InsertAt(size_t n, size_t i, U&& value)
+    {
+        T* a = Data();
+        if (i == n)
+        {
+            new (a + n) T(std::forward<U>(value));
+            return;
+        }
+        new (a + n) T(std::move(a[n - 1]));
+        std::move_backward(a + i, a + n - 1, a + n);
+        a[i] = std::forward<U>(value);
+    }
+
+    // 删掉n个有效元素中的第i个，(i, n)整体前移一位
+    void EraseAt(size_t n, size_t i)
+    {
+        T* a = Data();
+        std::move(a + i + 1, a + n, a + i);
+        a[n - 1].~T();
+    }
+
+    // 把[first, n)搬到dst的第at个位置开始（dst从at往后是空槽位），搬走的槽位随即析构
+    void MoveTo(size_t first, size_t n, BPlusSlots& dst, size_t at = 0)
+    {
+        T* a = Data();
+        T* b = dst.Data() + at;
+        for (size_t i = first; i < n; ++i)
+        {
+            new (b + i - first) T(std::move(a[i]));
+            a[i].~T();
+        }
+    }
+
+    void Destroy(size_t n)
+    {
+        T* a = Data();
+        for (size_t i = 0; i < n; ++i)
+            a[i].~T();
+    }
+};
+
+// B+树迭代器：叶子指针 + 叶子内下标
+// end()是最后一个叶子的“最后一个元素之后”，所以从end()也能往回走；空树时begin()和end()都是(nullptr, 0)
+template<class T, class Ref, class Ptr, class Leaf>
+struct __BPlusTreeIterator
+{
+    typedef __BPlusTreeIterator<T, Ref, Ptr, Leaf> Self;
+    typedef __BPlusTreeIterator<T, T&, T*, Leaf> Iterator;
+    Leaf* _leaf;
+    size_t _i;
+
+    __BPlusTreeIterator(Leaf* leaf = nullptr, size_t i = 0)
+        : _leaf(leaf)
+        , _i(i)
+    {}
+
+    // 普通迭代器转const迭代器（叶子指针和下标原样带过去）；排除Self是为了不和隐式拷贝构造撞上
+    template<class It>
+        requires std::is_same_v<It, Iterator> && (!std::is_same_v<It, Self>)
+    __BPlusTreeIterator(const It& it)
+        : _leaf(it._leaf)
+        , _i(it._i)
+    {}
+
+    Ref operator*()
+    {
+        return _leaf->_slots[_i];
+    }
+
+    Ptr operator->()
+    {
+        return &_leaf->_slots[_i];
+    }
+
+    bool operator!=(const Self& s) const
+    {
+        return _leaf != s._leaf || _i != s._i;
+    }
+
+    bool operator==(const Self& s) const
+    {
+        return _leaf == s._leaf && _i == s._i;
+    }
+
+    // 叶子内往后挪一格，走到头就跳到下一个叶子；最后一个叶子走到头就停在end()
+    Self& operator++()
+    {
+        if (++_i == _leaf->_n && _leaf->_next)
+        {
+            _leaf = _leaf->_next;
+            _i = 0;
+        }
+        return *this;
+    }
+
+    Self& operator--()
+    {
+        if (_i > 0)
+        {
+            --_i;
+        }
+        else
+        {
+            _leaf = _leaf->_prev;
+            _i = _leaf->_n - 1;
+        }
+        return *this;
+    }
+
+    Self operator++(int)
+    {
+        Self tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+    Self operator--(int)
+    {
+        Self tmp(*this);
+        --*this;
+        return tmp;
+    }
+};
+
+// K: 键值类型
+// T: 存储的数据类型 (Set是K, Map是pair<K,V>)
+// KeyOfT: 仿函数，用于从T中提取键值K
+// Compare: 键值的比较仿函数，同RBTree
+// Alloc: 元素的分配器，内部分别rebind成叶子和内部节点的分配器
+// NodeBytes: 每个节点的目标大小，按它算出叶子能放几个元素、内部节点能有几个孩子
+template<class K, class T, class KeyOfT, class Compare = std::less<>, class Alloc = std::allocator<T>, size_t NodeBytes = 512>
+class BPlusTree
+{
+    struct NodeBase
+    {
+        uint32_t _n;  // 叶子：元素个数；内部节点：分隔key个数（孩子数为_n + 1）
+        bool _leaf;
+
+        NodeBase(bool leaf)
+            : _n(0)
+            , _leaf(leaf)
+        {}
+    };
+
+    static constexpr size_t kCacheLine = 64;
+    // 节点头之外的空间全部给元素/（key+孩子指针），至少保证4个，分裂时两边都不为空
+    static constexpr size_t kLeafMax = std::max<size_t>(4, (NodeBytes - sizeof(NodeBase) - 2 * sizeof(void*)) / sizeof(T));
+    static constexpr size_t kInnerMax = std::max<size_t>(4, (NodeBytes - sizeof(NodeBase) - sizeof(void*)) / (sizeof(K) + sizeof(void*)));
+    // 扇出至少为5，64层足够放下任意多的元素，插入时用定长数组记录下降路径
+    static constexpr size_t kMaxHeight = 64;
+    // 删除后少于一半就向兄弟借或者和兄弟合并；插入时的分裂不保证这个下限，所以只在删除时用
+    static constexpr size_t kLeafMin = kLeafMax / 2;
+    static constexpr size_t kInnerMin = kInnerMax / 2;
+
+    struct alignas(kCacheLine) Leaf : NodeBase
+    {
+        Leaf* _prev;
+        Leaf* _next;
+        BPlusSlots<T, kLeafMax> _slots;
+
+        Leaf()
+            : NodeBase(true)
+            , _prev(nullptr)
+            , _next(nullptr)
+        {}
+    };
+
+    // 分隔key _keys[i] 等于 _children[i + 1] 这棵子树里最小的key
+    struct alignas(kCacheLine) Inner : NodeBase
+    {
+        BPlusSlots<K, kInnerMax> _keys;
+        NodeBase* _children[kInnerMax + 1];
+
+        Inner()
+            : NodeBase(false)
+        {}
+    };
+
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Leaf> LeafAlloc;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Inner> InnerAlloc;
+    typedef std::allocator_traits<LeafAlloc> LeafTraits;
+    typedef std::allocator_traits<InnerAlloc> InnerTraits;
+public:
+    typedef __BPlusTreeIterator<T, T&, T*, Leaf> iterator;
+    typedef __BPlusTreeIterator<T, const T&, const T*, Leaf> const_iterator;
+    typedef ReverseIterator<iterator, T&, T*> reverse_iterator;
+    typedef ReverseIterator<const_iterator, const T&, const T*> const_reverse_iterator;
+
+    BPlusTree() = default;
+
+    explicit BPlusTree(const Compare& comp)
+        : _comp(comp)
+    {}
+
+    // 拷贝构造：按顺序逐个插入，顺序插入时叶子是填满的，比原树更紧凑
+    BPlusTree(const BPlusTree& t)
+        : _comp(t._comp)
+    {
+        for (Leaf* leaf = t._head; leaf; leaf = leaf->_next)
+        {
+            for (size_t i = 0; i < leaf->_n; ++i)
+                Insert(leaf->_slots[i]);
+        }
+    }
+
+    BPlusTree& operator=(BPlusTree t)
+    {
+        std::swap(_root, t._root);
+        std::swap(_head, t._head);
+        std::swap(_tail, t._tail);
+        std::swap(_size, t._size);
+        std::swap(_comp, t._comp);
+        return *this;
+    }
+
+    ~BPlusTree()
+    {
+        Destroy(_root);
+        _root = nullptr;
+    }
+
+    // 最左的叶子直接记着，不用从根往下找
+    iterator begin()
+    {
+        return iterator(_head, 0);
+    }
+
+    iterator end()
+    {
+        return _tail ? iterator(_tail, _tail->_n) : iterator();
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(_head, 0);
+    }
+
+    const_iterator end() const
+    {
+        return _tail ? const_iterator(_tail, _tail->_n) : const_iterator();
+    }
+
+    reverse_iterator rbegin()
+    {
+        return reverse_iterator(end());
+    }
+
+    reverse_iterator rend()
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    pair<iterator, bool> Insert(const T& data)
+    {
+        KeyOfT kot;
+        return InsertUnique(kot(data), [&]() -> const T& { return data; });
+    }
+
+    pair<iterator, bool> Insert(T&& data)
+    {
+        KeyOfT kot;
+        return InsertUnique(kot(data), [&]() -> T&& { return std::move(data); });
+    }
+
+    // 元素放在叶子的数组里，没有单独的节点可以先构造，所以先在栈上构造出来再移动进去
+    template<class... Args>
+    pair<iterator, bool> Emplace(Args&&... args)
+    {
+        KeyOfT kot;
+        T data(std::forward<Args>(args)...);
+        return InsertUnique(kot(data), [&]() -> T&& { return std::move(data); });
+    }
+
+    // 只用于T是pair的map：key不存在时才构造元素，存在时key和args都不会被移走
+    template<class KeyArg, class... Args>
+    pair<iterator, bool> TryEmplace(KeyArg&& key, Args&&... args)
+    {
+        return InsertUnique(key, [&]() {
+            return T(std::piecewise_construct,
+                     std::forward_as_tuple(std::forward<KeyArg>(key)),
+                     std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+    }
+
+private:
+    // 插入的公共部分：按key找位置，key不存在时才调用make()取要放进槽位的元素
+    template<class KeyLike, class Make>
+    pair<iterator, bool> InsertUnique(const KeyLike& key, Make&& make)
+    {
+        KeyOfT kot;
+        if (_root == nullptr) // 空树：根就是一个叶子
+        {
+            Leaf* leaf = CreateLeaf();
+            leaf->_slots.InsertAt(0, 0, make());
+            leaf->_n = 1;
+            _root = _head = _tail = leaf;
+            _size = 1;
+            return make_pair(iterator(leaf, 0), true);
+        }
+
+        // 往下走到叶子，记录经过的内部节点和走的是第几个孩子，分裂时沿原路往上插分隔key
+        Inner* path[kMaxHeight];
+        size_t slot[kMaxHeight];
+        size_t depth = 0;
+        NodeBase* cur = _root;
+        while (!cur->_leaf)
+        {
+            Inner* inner = static_cast<Inner*>(cur);
+            size_t i = InnerUpperBound(inner, key);
+            path[depth] = inner;
+            slot[depth] = i;
+            ++depth;
+            cur = inner->_children[i];
+        }
+
+        Leaf* leaf = static_cast<Leaf*>(cur);
+        size_t i = LeafLowerBound(leaf, key);
+        if (i < leaf->_n && !_comp(key, kot(leaf->_slots[i]))) // 键值已存在，插入失败
+            return make_pair(iterator(leaf, i), false);
+
+        ++_size;
+        if (leaf->_n < kLeafMax) // 叶子还有空位，直接插
+        {
+            leaf->_slots.InsertAt(leaf->_n, i, make());
+            ++leaf->_n;
+            return make_pair(iterator(leaf, i), true);
+        }
+
+        // 叶子满了：分裂成两个，右半边搬到新叶子
+        // 在最右叶子的末尾追加（升序插入）时左边保持全满，在最左叶子的开头插入（降序插入）时右边保持全满，
+        // 其他情况对半分
+        size_t n = leaf->_n;
+        size_t keep = (n + 1) / 2;
+        if (i == n && leaf->_next == nullptr)
+            keep = n;
+        else if (i == 0 && leaf->_prev == nullptr)
+            keep = 0;
+
+        Leaf* right = CreateLeaf();
+        leaf->_slots.MoveTo(keep, n, right->_slots);
+        right->_n = n - keep;
+        leaf->_n = keep;
+        right->_next = leaf->_next;
+        if (right->_next)
+            right->_next->_prev = right;
+        else
+            _tail = right;
+        right->_prev = leaf;
+        leaf->_next = right;
+
+        iterator ret;
+        if (keep < n && i <= keep)
+        {
+            leaf->_slots.InsertAt(leaf->_n, i, make());
+            ++leaf->_n;
+            ret = iterator(leaf, i);
+        }
+        else
+        {
+            right->_slots.InsertAt(right->_n, i - keep, make());
+            ++right->_n;
+            ret = iterator(right, i - keep);
+        }
+
+        InsertIntoParent(path, slot, depth, kot(right->_slots[0]), right);
+        return make_pair(ret, true);
+    }
+
+public:
+
+    // 查找操作：返回指向元素的迭代器，找不到返回end()
+    template<class KeyLike>
+    iterator Find(const KeyLike& key)
+    {
+        if (_root == nullptr)
+            return end();
+        KeyOfT kot;
+        Leaf* leaf = FindLeaf(key);
+        size_t i = LeafLowerBound(leaf, key);
+        if (i < leaf->_n && !_comp(key, kot(leaf->_slots[i])))
+            return iterator(leaf, i);
+        return end();
+    }
+
+    // 第一个不小于key的元素，范围扫描从这里开始顺着叶子链表往后走
+    template<class KeyLike>
+    iterator LowerBound(const KeyLike& key)
+    {
+        if (_root == nullptr)
+            return end();
+        Leaf* leaf = FindLeaf(key);
+        size_t i = LeafLowerBound(leaf, key);
+        if (i == leaf->_n && leaf->_next) // 这个叶子里都比key小，答案是下一个叶子的第一个
+            return iterator(leaf->_next, 0);
+        return iterator(leaf, i);
+    }
+
+    // 第一个大于key的元素
+    template<class KeyLike>
+    iterator UpperBound(const KeyLike& key)
+    {
+        if (_root == nullptr)
+            return end();
+        KeyOfT kot;
+        Leaf* leaf = FindLeaf(key);
+        size_t i = LeafLowerBound(leaf, key);
+        if (i < leaf->_n && !_comp(key, kot(leaf->_slots[i])))
+            ++i;
+        if (i == leaf->_n && leaf->_next) // 这个叶子里都比key小，答案是下一个叶子的第一个
+            return iterator(leaf->_next, 0);
+        return iterator(leaf, i);
+    }
+
+    template<class KeyLike>
+    pair<iterator, iterator> EqualRange(const KeyLike& key)
+    {
+        return make_pair(LowerBound(key), UpperBound(key));
+    }
+
+    // 删除key，不存在返回false
+    // 叶子删完少于一半时先找同一个父节点下的兄弟：两个加起来放得下就合并，放不下就借一个过来；
+    // 合并会从父节点删掉一个分隔key，父节点不够一半时同样借或合并，一直到根，根只剩一个孩子时树矮一层
+    bool Erase(const K& key)
+    {
+        if (_root == nullptr)
+            return false;
+        KeyOfT kot;
+        Inner* path[kMaxHeight];
+        size_t slot[kMaxHeight];
+        size_t depth = 0;
+        NodeBase* cur = _root;
+        while (!cur->_leaf)
+        {
+            Inner* inner = static_cast<Inner*>(cur);
+            size_t i = InnerUpperBound(inner, key);
+            path[depth] = inner;
+            slot[depth] = i;
+            ++depth;
+            cur = inner->_children[i];
+        }
+
+        Leaf* leaf = static_cast<Leaf*>(cur);
+        size_t i = LeafLowerBound(leaf, key);
+        if (i == leaf->_n || _comp(key, kot(leaf->_slots[i])))
+            return false;
+
+        leaf->_slots.EraseAt(leaf->_n, i);
+        --leaf->_n;
+        --_size;
+        if (depth == 0) // 根就是叶子，删空了树就空了
+        {
+            if (leaf->_n == 0)
+            {
+                DestroyLeaf(leaf);
+                _root = _head = _tail = nullptr;
+            }
+            return true;
+        }
+
+        if (leaf->_n >= kLeafMin)
+        {
+            if (i == 0) // 删的是叶子里最小的，上面以它为分隔key的地方要换成新的最小key
+                UpdateSeparator(path, slot, depth, kot(leaf->_slots[0]));
+            return true;
+        }
+        RebalanceLeaf(path, slot, depth, leaf);
+        return true;
+    }
+
+    // 返回被删元素的下一个位置。删除时元素会在节点间挪动，所以按key重新找一次
+    iterator Erase(const_iterator pos)
+    {
+        KeyOfT kot;
+        K key = kot(*pos);
+        Erase(key);
+        return LowerBound(key);
+    }
+
+    size_t Size()
+    {
+        return _size;
+    }
+
+    // 所有叶子在同一层，沿最左边走一遍就是高度
+    int Height()
+    {
+        int h = 0;
+        for (NodeBase* cur = _root; cur; ++h)
+        {
+            if (cur->_leaf)
+                cur = nullptr;
+            else
+                cur = static_cast<Inner*>(cur)->_children[0];
+        }
+        return h;
+    }
+
+    // 验证B+树性质：叶子同层、节点内key有序、分隔key正确划分子树且等于右子树的最小key、叶子链表与树一致
+    bool IsValid()
+    {
+        if (_root == nullptr)
+            return _size == 0 && _head == nullptr && _tail == nullptr;
+        int leafDepth = -1;
+        Leaf* prevLeaf = nullptr;
+        size_t count = 0;
+        if (!Check(_root, nullptr, nullptr, 0, leafDepth, prevLeaf, count))
+            return false;
+        if (prevLeaf->_next != nullptr || prevLeaf != _tail || count != _size)
+        {
+            cout << "错误：叶子链表或元素个数不一致" << endl;
+            return false;
+        }
+        return true;
+    }
+
+private:
+    NodeBase* _root = nullptr;
+    Leaf* _head = nullptr;   // 最左的叶子
+    Leaf* _tail = nullptr;   // 最右的叶子，end()和反向遍历从这里开始
+    size_t _size = 0;
+    [[no_unique_address]] LeafAlloc _leafAlloc;
+    [[no_unique_address]] InnerAlloc _innerAlloc;
+    [[no_unique_address]] Compare _comp;
+
+    Leaf* CreateLeaf()
+    {
+        Leaf* leaf = LeafTraits::allocate(_leafAlloc, 1);
+        LeafTraits::construct(_leafAlloc, leaf);
+        return leaf;
+    }
+
+    Inner* CreateInner()
+    {
+        Inner* inner = InnerTraits::allocate(_innerAlloc, 1);
+        InnerTraits::construct(_innerAlloc, inner);
+        return inner;
+    }
+
+    void DestroyLeaf(Leaf* leaf)
+    {
+        leaf->_slots.Destroy(leaf->_n);
+        LeafTraits::destroy(_leafAlloc, leaf);
+        LeafTraits::deallocate(_leafAlloc, leaf, 1);
+    }
+
+    // 只释放这一个节点，孩子由调用者处理
+    void DestroyInner(Inner* inner)
+    {
+        inner->_keys.Destroy(inner->_n);
+        InnerTraits::destroy(_innerAlloc, inner);
+        InnerTraits::deallocate(_innerAlloc, inner, 1);
+    }
+
+    void Destroy(NodeBase* node)
+    {
+        if (node == nullptr)
+            return;
+        if (node->_leaf)
+        {
+            DestroyLeaf(static_cast<Leaf*>(node));
+        }
+        else
+        {
+            Inner* inner = static_cast<Inner*>(node);
+            for (size_t i = 0; i <= inner->_n; ++i)
+                Destroy(inner->_children[i]);
+            DestroyInner(inner);
+        }
+    }
+
+    template<class KeyLike>
+    Leaf* FindLeaf(const KeyLike& key)
+    {
+        NodeBase* cur = _root;
+        while (!cur->_leaf)
+        {
+            Inner* inner = static_cast<Inner*>(cur);
+            cur = inner->_children[InnerUpperBound(inner, key)];
+        }
+        return static_cast<Leaf*>(cur);
+    }
+
+    // 叶子内二分：第一个不小于key的位置
+    template<class KeyLike>
+    size_t LeafLowerBound(Leaf* leaf, const KeyLike& key)
+    {
+        KeyOfT kot;
+        size_t lo = 0, hi = leaf->_n;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (_comp(kot(leaf->_slots[mid]), key))
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+        return lo;
+    }
+
+    // 内部节点内二分：第一个大于key的分隔key的位置，也就是该往哪个孩子走
+    template<class KeyLike>
+    size_t InnerUpperBound(Inner* inner, const KeyLike& key)
+    {
+        size_t lo = 0, hi = inner->_n;
+        while (lo < hi)
+        {
+            size_t mid = (lo + hi) / 2;
+            if (_comp(key, inner->_keys[mid]))
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        return lo;
+    }
+
+    // 分隔key放在第pos个，新孩子放在它右边
+    void InsertKeyChild(Inner* inner, size_t pos, K&& key, NodeBase* child)
+    {
+        size_t n = inner->_n;
+        inner->_keys.InsertAt(n, pos, std::move(key));
+        for (size_t j = n + 1; j > pos + 1; --j)
+            inner->_children[j] = inner->_children[j - 1];
+        inner->_children[pos + 1] = child;
+        ++inner->_n;
+    }
+
+    // 子节点分裂出了child，沿记录的路径往上插分隔key；父节点满了就继续分裂，一直分到根就长高一层
+    void InsertIntoParent(Inner** path, size_t* slot, size_t depth, K sep, NodeBase* child)
+    {
+        while (depth > 0)
+        {
+            --depth;
+            Inner* inner = path[depth];
+            size_t pos = slot[depth];
+            if (inner->_n < kInnerMax)
+            {
+                InsertKeyChild(inner, pos, std::move(sep), child);
+                return;
+            }
+
+            // 内部节点满了：插入后共kInnerMax + 1个key，第mid个提到上一层，左右各留一半
+            size_t n = inner->_n;
+            size_t mid = n / 2;
+            Inner* right = CreateInner();
+            if (pos < mid) // 新key落在左半边，上提原来的第mid - 1个
+            {
+                inner->_keys.MoveTo(mid, n, right->_keys);
+                for (size_t j = mid; j <= n; ++j)
+                    right->_children[j - mid] = inner->_children[j];
+                right->_n = n - mid;
+                K up = std::move(inner->_keys[mid - 1]);
+                inner->_keys[mid - 1].~K();
+                inner->_n = mid - 1;
+                InsertKeyChild(inner, pos, std::move(sep), child);
+                sep = std::move(up);
+            }
+            else if (pos == mid) // 新key正好在中间，直接上提，新孩子成为右节点的第一个孩子
+            {
+                inner->_keys.MoveTo(mid, n, right->_keys);
+                right->_children[0] = child;
+                for (size_t j = mid + 1; j <= n; ++j)
+                    right->_children[j - mid] = inner->_children[j];
+                right->_n = n - mid;
+                inner->_n = mid;
+            }
+            else // 新key落在右半边，上提原来的第mid个
+            {
+                K up = std::move(inner->_keys[mid]);
+                inner->_keys[mid].~K();
+                inner->_keys.MoveTo(mid + 1, n, right->_keys);
+                for (size_t j = mid + 1; j <= n; ++j)
+                    right->_children[j - mid - 1] = inner->_children[j];
+                right->_n = n - mid - 1;
+                inner->_n = mid;
+                InsertKeyChild(right, pos - mid - 1, std::move(sep), child);
+                sep = std::move(up);
+            }
+            child = right;
+        }
+
+        // 根节点分裂：新建一个只有一个分隔key的根
+        Inner* root = CreateInner();
+        root->_keys.InsertAt(0, 0, std::move(sep));
+        root->_children[0] = _root;
+        root->_children[1] = child;
+        root->_n = 1;
+        _root = root;
+    }
+
+    // 第pos个分隔key和它右边的孩子一起删掉
+    void RemoveKeyChild(Inner* inner, size_t pos)
+    {
+        size_t n = inner->_n;
+        inner->_keys.EraseAt(n, pos);
+        for (size_t j = pos + 1; j < n; ++j)
+            inner->_children[j] = inner->_children[j + 1];
+        --inner->_n;
+    }
+
+    // 下降路径上depth这一层的子树最小key变成了key：往上找第一个不是从最左孩子下来的节点，改它左边的分隔key
+    void UpdateSeparator(Inner** path, size_t* slot, size_t depth, const K& key)
+    {
+        while (depth > 0)
+        {
+            --depth;
+            if (slot[depth] > 0)
+            {
+                path[depth]->_keys[slot[depth] - 1] = key;
+                return;
+            }
+        }
+    }
+
+    // right并到left的末尾，从叶子链表里摘掉并释放
+    void MergeLeaf(Leaf* left, Leaf* right)
+    {
+        right->_slots.MoveTo(0, right->_n, left->_slots, left->_n);
+        left->_n += right->_n;
+        right->_n = 0;
+        left->_next = right->_next;
+        if (left->_next)
+            left->_next->_prev = left;
+        else
+            _tail = left;
+        DestroyLeaf(right);
+    }
+
+    // 父节点第k个分隔key拉下来放在中间，right的key和孩子接到left后面，释放right
+    void MergeInner(Inner* left, Inner* parent, size_t k, Inner* right)
+    {
+        size_t n = left->_n;
+        left->_keys.InsertAt(n, n, std::move(parent->_keys[k]));
+        right->_keys.MoveTo(0, right->_n, left->_keys, n + 1);
+        for (size_t j = 0; j <= right->_n; ++j)
+            left->_children[n + 1 + j] = right->_children[j];
+        left->_n = n + 1 + right->_n;
+        right->_n = 0;
+        DestroyInner(right);
+    }
+
+    // 叶子不到一半：优先和左兄弟，最左的孩子才找右兄弟
+    void RebalanceLeaf(Inner** path, size_t* slot, size_t depth, Leaf* leaf)
+    {
+        KeyOfT kot;
+        Inner* parent = path[depth - 1];
+        size_t s = slot[depth - 1];
+        if (s > 0)
+        {
+            Leaf* left = static_cast<Leaf*>(parent->_children[s - 1]);
+            if (left->_n + leaf->_n <= kLeafMax)
+            {
+                MergeLeaf(left, leaf);
+                RemoveKeyChild(parent, s - 1);
+                RebalanceInner(path, slot, depth - 1);
+                return;
+            }
+            // 借左兄弟最大的一个，它成了leaf的最小key
+            leaf->_slots.InsertAt(leaf->_n, 0, std::move(left->_slots[left->_n - 1]));
+            ++leaf->_n;
+            left->_slots[left->_n - 1].~T();
+            --left->_n;
+            parent->_keys[s - 1] = kot(leaf->_slots[0]);
+            return;
+        }
+
+        Leaf* right = static_cast<Leaf*>(parent->_children[1]);
+        bool merge = leaf->_n + right->_n <= kLeafMax;
+        if (merge)
+        {
+            MergeLeaf(leaf, right);
+            RemoveKeyChild(parent, 0);
+        }
+        else
+        {
+            // 借右兄弟最小的一个，右兄弟的分隔key换成它新的最小key
+            leaf->_slots.InsertAt(leaf->_n, leaf->_n, std::move(right->_slots[0]));
+            ++leaf->_n;
+            right->_slots.EraseAt(right->_n, 0);
+            --right->_n;
+            parent->_keys[0] = kot(right->_slots[0]);
+        }
+        // 删的可能是leaf的第一个元素（或者leaf被删空了），leaf是最左的孩子，要改更上面的分隔key
+        UpdateSeparator(path, slot, depth, kot(leaf->_slots[0]));
+        if (merge)
+            RebalanceInner(path, slot, depth - 1);
+    }
+
+    // path[d]刚被删掉一个分隔key：不到一半就借或合并，合并又会让上一层少一个key，所以一路往上
+    void RebalanceInner(Inner** path, size_t* slot, size_t d)
+    {
+        while (d > 0)
+        {
+            Inner* node = path[d];
+            if (node->_n >= kInnerMin)
+                return;
+            Inner* parent = path[d - 1];
+            size_t s = slot[d - 1];
+            if (s > 0)
+            {
+                Inner* left = static_cast<Inner*>(parent->_children[s - 1]);
+                if (left->_n + node->_n + 1 <= kInnerMax)
+                {
+                    MergeInner(left, parent, s - 1, node);
+                    RemoveKeyChild(parent, s - 1);
+                    --d;
+                    continue;
+                }
+                // 右旋：父节点的分隔key下来，左兄弟的最后一个key上去，最后一个孩子跟着过来
+                size_t n = node->_n;
+                node->_keys.InsertAt(n, 0, std::move(parent->_keys[s - 1]));
+                for (size_t j = n + 1; j > 0; --j)
+                    node->_children[j] = node->_children[j - 1];
+                node->_children[0] = left->_children[left->_n];
+                node->_n = n + 1;
+                parent->_keys[s - 1] = std::move(left->_keys[left->_n - 1]);
+                left->_keys[left->_n - 1].~K();
+                --left->_n;
+                return;
+            }
+
+            Inner* right = static_cast<Inner*>(parent->_children[1]);
+            if (node->_n + right->_n + 1 <= kInnerMax)
+            {
+                MergeInner(node, parent, 0, right);
+                RemoveKeyChild(parent, 0);
+                --d;
+                continue;
+            }
+            // 左旋：父节点的分隔key下来，右兄弟的第一个key上去，第一个孩子跟着过来
+            size_t n = node->_n;
+            node->_keys.InsertAt(n, n, std::move(parent->_keys[0]));
+            node->_children[n + 1] = right->_children[0];
+            node->_n = n + 1;
+            parent->_keys[0] = std::move(right->_keys[0]);
+            right->_keys.EraseAt(right->_n, 0);
+            for (size_t j = 0; j < right->_n; ++j)
+                right->_children[j] = right->_children[j + 1];
+            --right->_n;
+            return;
+        }
+
+        // 根只剩一个孩子：孩子当新根，树矮一层
+        Inner* root = path[0];
+        if (root->_n == 0)
+        {
+            _root = root->_children[0];
+            DestroyInner(root);
+        }
+    }
+
+    // 子树里的key必须落在[lo, hi)内（空指针表示没有边界）
+    bool Check(NodeBase* node, const K* lo, const K* hi, int depth, int& leafDepth, Leaf*& prevLeaf, size_t& count)
+    {
+        KeyOfT kot;
+        if (node->_n == 0)
+        {
+            cout << "错误：出现空节点" << endl;
+            return false;
+        }
+        if (node->_leaf)
+        {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            if (leafDepth == -1)
+                leafDepth = depth;
+            if (depth != leafDepth)
+            {
+                cout << "错误：叶子不在同一层" << endl;
+                return false;
+            }
+            if (leaf->_prev != prevLeaf || (prevLeaf ? prevLeaf->_next != leaf : _head != leaf))
+            {
+                cout << "错误：叶子链表断开" << endl;
+                return false;
+            }
+            for (size_t i = 0; i < leaf->_n; ++i)
+            {
+                const K& key = kot(leaf->_slots[i]);
+                if ((lo && _comp(key, *lo)) || (hi && !_comp(key, *hi)) || (i > 0 && !_comp(kot(leaf->_slots[i - 1]), key)))
+                {
+                    cout << "错误：叶子内的key越界或无序" << endl;
+                    return false;
+                }
+            }
+            prevLeaf = leaf;
+            count += leaf->_n;
+            return true;
+        }
+
+        Inner* inner = static_cast<Inner*>(node);
+        for (size_t i = 0; i <= inner->_n; ++i)
+        {
+            const K* childLo = i == 0 ? lo : &inner->_keys[i - 1];
+            const K* childHi = i == inner->_n ? hi : &inner->_keys[i];
+            if (i > 0 && i < inner->_n && !_comp(inner->_keys[i - 1], inner->_keys[i]))
+            {
+                cout << "错误：分隔key无序" << endl;
+                return false;
+            }
+            if (i > 0) // 分隔key等于右边子树最小的key，删除时要跟着改
+            {
+                NodeBase* first = inner->_children[i];
+                while (!first->_leaf)
+                    first = static_cast<Inner*>(first)->_children[0];
+                Leaf* leaf = static_cast<Leaf*>(first);
+                if (leaf->_n > 0 && (_comp(kot(leaf->_slots[0]), inner->_keys[i - 1]) || _comp(inner->_keys[i - 1], kot(leaf->_slots[0]))))
+                {
+                    cout << "错误：分隔key不是右子树的最小key" << endl;
+                    return false;
+                }
+            }
+            if (!Check(inner->_children[i], childLo, childHi, depth + 1, leafDepth, prevLeaf, count))
+                return false;
+        }
+        return true;
+    }
+};
+
+namespace pzh
+{
+    // 选择B+树作为map/set的底层，NodeBytes是单个节点的目标字节数
+    template<size_t NodeBytes = 512>
+    struct basic_bplus_tree_policy
+    {
+        template<class K, class T, class KeyOfT, class Compare, class Alloc>
+        using Tree = BPlusTree<K, T, KeyOfT, Compare, Alloc, NodeBytes>;
+    };
+
+    typedef basic_bplus_tree_policy<> bplus_tree_policy;
+}
@@ -0,0 +1,394 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <utility>
+#include "../hash/RcuHashTable.h"
+
+namespace pzh
+{
+    // 无锁跳表实现的并发有序map
+    /*
+     * 每个节点随机取一个层数（每高一层概率1/4），第i层链表把所有层数大于i的节点按key串起来，
+     * 第0层是完整的有序链表，查找从最高层往下走，期望O(logN)
+     *
+     * 插入：在第0层CAS成功就算插入完成，再逐层往上挂（上层只是加速用的索引）
+     * 删除：先把节点所有层的next指针打上删除标记（指针最低位），第0层打标记成功的线程就是删除者；
+     *      打了标记的next不会再被修改，之后任何线程路过都会顺手把它从链表上摘掉
+     * 回收：读者可能还拿着刚摘下来的节点，所以节点摘干净之后交给pzh_rcu的epoch回收，
+     *      等所有可能看到它的线程都离开读临界区再释放；每个操作都在一个ReadGuard里进行
+     *
+     * 和pzh::map的区别：没有迭代器（节点随时可能被其他线程删除），
+     * find/lower_bound返回元素的拷贝，遍历用for_each在读临界区里回调；插入后value不能修改
+     */
+    template<class K, class V, class Compare = std::less<>>
+    class concurrent_map
+    {
+    public:
+        typedef std::pair<K, V> value_type;
+
+    private:
+        static const int kMaxLevel = 20;   // 4^20个元素以内期望层数够用
+
+        struct Node
+        {
+            // 插入者挂完所有层、删除者打完标记各置一位，后置位的那个线程负责摘链和回收
+            static const uint32_t kLinked = 1;
+            static const uint32_t kRemoved = 2;
+
+            std::atomic<uint32_t> _flags{0};
+            int _level;                 // 层数，next数组的长度
+            union
+            {
+                value_type _data;       // 头节点不构造
+            };
+
+            // next数组紧跟在节点后面，和节点一起分配
+            std::atomic<Node*>* Next()
+            {
+                return reinterpret_cast<std::atomic<Node*>*>(this + 1);
+            }
+
+            // 头节点：只有next数组，不构造数据
+            explicit Node(int level)
+                :_level(level)
+            {
+                for (int i = 0; i < level; i++)
+                    new (&Next()[i]) std::atomic<Node*>(nullptr);
+            }
+
+            template<class... Args>
+            explicit Node(int level, Args&&... args)
+                :_level(level)
+                , _data(std::forward<Args>(args)...)
+            {
+                for (int i = 0; i < level; i++)
+                    new (&Next()[i]) std::atomic<Node*>(nullptr);
+            }
+
+            template<class... Args>
+            static Node* Create(int level, Args&&... args)
+            {
+                void* mem = ::operator new(sizeof(Node) + level * sizeof(std::atomic<Node*>));
+                try
+                {
+                    return new (mem) Node(level, std::forward<Args>(args)...);
+                }
+                catch (...)
+                {
+                    ::operator delete(mem);
+                    throw;
+                }
+            }
+
+            // 头节点没有数据，不走析构函数
+            static void DestroyHead(Node* head)
+            {
+                ::operator delete(head);
+            }
+
+            // pzh_rcu::RetireList用delete回收
+            ~Node()
+            {
+                _data.~value_type();
+            }
+
+            static void operator delete(void* p)
+            {
+                ::operator delete(p);
+            }
+        };
+
+        // next指针的最低位做删除标记
+        static bool IsMarked(Node* p)
+        {
+            return reinterpret_cast<uintptr_t>(p) & 1;
+        }
+
+        static Node* Marked(Node* p)
+        {
+            return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(p) | 1);
+        }
+
+        static Node* Unmarked(Node* p)
+        {
+            return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t>(p) & ~uintptr_t(1));
+        }
+
+    public:
+        concurrent_map()
+            :_head(Node::Create(kMaxLevel))
+        {}
+
+        explicit concurrent_map(const Compare& comp)
+            :_head(Node::Create(kMaxLevel))
+            , _comp(comp)
+        {}
+
+        concurrent_map(const concurrent_map&) = delete;
+        concurrent_map& operator=(const concurrent_map&) = delete;
+
+        // 析构时不能再有其他线程访问；已经摘下的节点由_retired析构时释放
+        ~concurrent_map()
+        {
+            Node* cur = Unmarked(_head->Next()[0].load(std::memory_order_relaxed));
+            while (cur)
+            {
+                Node* next = Unmarked(cur->Next()[0].load(std::memory_order_relaxed));
+                delete cur;
+                cur = next;
+            }
+            Node::DestroyHead(_head);
+        }
+
+        // key不存在时插入，返回是否插入成功
+        bool insert(const value_type& kv)
+        {
+            return try_emplace(kv.first, kv.second);
+        }
+
+        template<class... Args>
+        bool try_emplace(const K& key, Args&&... args)
+        {
+            pzh_rcu::ReadGuard guard;
+            Node* preds[kMaxLevel];
+            Node* succs[kMaxLevel];
+            if (Find(key, preds, succs))
+                return false;
+            int level = RandomLevel();
+            Node* node = Node::Create(level, std::piecewise_construct, std::forward_as_tuple(key),
+                                      std::forward_as_tuple(std::forward<Args>(args)...));
+            // 第0层：CAS成功即插入完成
+            while (true)
+            {
+                for (int i = 0; i < level; i++)
+                    node->Next()[i].store(succs[i], std::memory_order_relaxed);
+                Node* succ = succs[0];
+                if (preds[0]->Next()[0].compare_exchange_strong(succ, node, std::memory_order_release, std::memory_order_relaxed))
+                    break;
+                if (Find(key, preds, succs)) // 别的线程抢先插入了同一个key
+                {
+                    delete node;
+                    return false;
+                }
+            }
+            _size.fetch_add(1, std::memory_order_relaxed);
+            LinkUpperLevels(node, key, preds, succs);
+            if (node->_flags.fetch_or(Node::kLinked, std::memory_order_acq_rel) & Node::kRemoved)
+                UnlinkAndRetire(node); // 挂上层的过程中已经被删了，删除者把摘链留给了这里
+            return true;
+        }
+
+        // 返回value的拷贝
+        std::optional<V> find(const K& key) const
+        {
+            pzh_rcu::ReadGuard guard;
+            Node* node = LowerBoundNode(key);
+            if (node == nullptr || _comp(key, node->_data.first))
+                return std::nullopt;
+            return node->_data.second;
+        }
+
+        bool contains(const K& key) const
+        {
+            return find(key).has_value();
+        }
+
+        // 第一个key不小于参数的元素的拷贝
+        std::optional<value_type> lower_bound(const K& key) const
+        {
+            pzh_rcu::ReadGuard guard;
+            Node* node = LowerBoundNode(key);
+            if (node == nullptr)
+                return std::nullopt;
+            return node->_data;
+        }
+
+        bool erase(const K& key)
+        {
+            pzh_rcu::ReadGuard guard;
+            Node* preds[kMaxLevel];
+            Node* succs[kMaxLevel];
+            if (!Find(key, preds, succs))
+                return false;
+            Node* node = succs[0];
+            // 从上往下给每层的next打标记，上层被别人打过也没关系
+            for (int i = node->_level - 1; i >= 1; i--)
+            {
+                Node* next = node->Next()[i].load(std::memory_order_relaxed);
+                while (!IsMarked(next))
+                    node->Next()[i].compare_exchange_weak(next, Marked(next), std::memory_order_acq_rel, std::memory_order_relaxed);
+            }
+            // 第0层打标记成功的线程才是删除者
+            Node* next = node->Next()[0].load(std::memory_order_relaxed);
+            while (true)
+            {
+                if (IsMarked(next))
+                    return false;
+                if (node->Next()[0].compare_exchange_weak(next, Marked(next), std::memory_order_acq_rel, std::memory_order_relaxed))
+                    break;
+            }
+            _size.fetch_sub(1, std::memory_order_relaxed);
+            if (node->_flags.fetch_or(Node::kRemoved, std::memory_order_acq_rel) & Node::kLinked)
+                UnlinkAndRetire(node);
+            return true;
+        }
+
+        // 按key升序对每个元素调用fn(const value_type&)；遍历期间其他线程的修改可能看得到也可能看不到
+        template<class Fn>
+        void for_each(Fn fn) const
+        {
+            pzh_rcu::ReadGuard guard;
+            for (Node* cur = Unmarked(_head->Next()[0].load(std::memory_order_acquire)); cur;)
+            {
+                Node* next = cur->Next()[0].load(std::memory_order_acquire);
+                if (!IsMarked(next))
+                    fn(static_cast<const value_type&>(cur->_data));
+                cur = Unmarked(next);
+            }
+        }
+
+        // 只遍历[lo, hi)
+        template<class Fn>
+        void for_each(const K& lo, const K& hi, Fn fn) const
+        {
+            pzh_rcu::ReadGuard guard;
+            for (Node* cur = LowerBoundNode(lo); cur && _comp(cur->_data.first, hi);)
+            {
+                Node* next = cur->Next()[0].load(std::memory_order_acquire);
+                if (!IsMarked(next))
+                    fn(static_cast<const value_type&>(cur->_data));
+                cur = Unmarked(next);
+            }
+        }
+
+        // 并发修改时只是一个近似值
+        size_t size() const
+        {
+            return _size.load(std::memory_order_relaxed);
+        }
+
+        bool empty() const
+        {
+            return size() == 0;
+        }
+
+    private:
+        // 每层找到key的前驱preds[i]和后继succs[i]（第一个不小于key的节点），路过的已删除节点顺手摘掉
+        // 返回第0层的后继是否就是key
+        bool Find(const K& key, Node** preds, Node** succs)
+        {
+        retry:
+            Node* pred = _head;
+            for (int i = kMaxLevel - 1; i >= 0; i--)
+            {
+                Node* cur = Unmarked(pred->Next()[i].load(std::memory_order_acquire));
+                while (cur)
+                {
+                    Node* next = cur->Next()[i].load(std::memory_order_acquire);
+                    if (IsMarked(next)) // cur已被删除，从这一层摘掉
+                    {
+                        Node* expected = cur;
+                        if (!pred->Next()[i].compare_exchange_strong(expected, Unmarked(next), std::memory_order_acq_rel, std::memory_order_relaxed))
+                            goto retry; // pred也被删了或者后面插入了新节点，从头再来
+                        cur = Unmarked(next);
+                        continue;
+                    }
+                    if (!_comp(cur->_data.first, key))
+                        break;
+                    pred = cur;
+                    cur = next;
+                }
+                preds[i] = pred;
+                succs[i] = cur;
+            }
+            return succs[0] && !_comp(key, succs[0]->_data.first);
+        }
+
+        // 只读查找，不摘链：跳过已删除的节点
+        Node* LowerBoundNode(const K& key) const
+        {
+            Node* pred = _head;
+            Node* cur = nullptr;
+            for (int i = kMaxLevel - 1; i >= 0; i--)
+            {
+                cur = Unmarked(pred->Next()[i].load(std::memory_order_acquire));
+                while (cur)
+                {
+                    Node* next = cur->Next()[i].load(std::memory_order_acquire);
+                    if (IsMarked(next))
+                    {
+                        cur = Unmarked(next);
+                        continue;
+                    }
+                    if (!_comp(cur->_data.first, key))
+                        break;
+                    pred = cur;
+                    cur = next;
+                }
+            }
+            return cur;
+        }
+
+        // 第0层已经挂上，逐层往上挂；节点被删了（第0层有标记）就停下
+        void LinkUpperLevels(Node* node, const K& key, Node** preds, Node** succs)
+        {
+            for (int i = 1; i < node->_level; i++)
+            {
+                while (true)
+                {
+                    if (IsMarked(node->Next()[0].load(std::memory_order_acquire)))
+                        return;
+                    Node* succ = succs[i];
+                    Node* next = node->Next()[i].load(std::memory_order_acquire);
+                    if (IsMarked(next))
+                        return;
+                    // 自己这一层的next先指向最新的后继，被删除者打了标记就会失败
+                    if (next != succ && !node->Next()[i].compare_exchange_strong(next, succ, std::memory_order_acq_rel, std::memory_order_relaxed))
+                        return;
+                    if (preds[i]->Next()[i].compare_exchange_strong(succ, node, std::memory_order_release, std::memory_order_relaxed))
+                        break;
+                    Find(key, preds, succs); // 这一层的前驱变了，重新找位置
+                }
+            }
+        }
+
+        // 节点所有层都不会再有新的链接了：从每一层摘掉它，然后交给epoch回收
+        // 同一个key被删后又插入的新节点，在每一层都排在旧节点后面（插入时的Find会先摘掉路过的旧节点，
+        // 旧节点晚挂上的层也只能挂在新节点前面），所以按key再Find一次就能路过并摘掉旧节点的每一层
+        void UnlinkAndRetire(Node* node)
+        {
+            Node* preds[kMaxLevel];
+            Node* succs[kMaxLevel];
+            Find(node->_data.first, preds, succs);
+            std::lock_guard<std::mutex> lock(_retireMtx);
+            _retired.Retire(node);
+        }
+
+        // 每个线程一个xorshift，层数i的概率是(1/4)^i * 3/4
+        static int RandomLevel()
+        {
+            thread_local uint64_t x = 0x9E3779B97F4A7C15ULL ^ reinterpret_cast<uintptr_t>(&x);
+            x ^= x << 13;
+            x ^= x >> 7;
+            x ^= x << 17;
+            int level = 1;
+            uint64_t r = x;
+            while (level < kMaxLevel && (r & 3) == 0)
+            {
+                ++level;
+                r >>= 2;
+            }
+            return level;
+        }
+
+        Node* _head;
+        std::atomic<size_t> _size{0};
+        [[no_unique_address]] Compare _comp;
+        std::mutex _retireMtx;           // 只保护_retired，只有删除时用到
+        pzh_rcu::RetireList _retired;
+    };
+}
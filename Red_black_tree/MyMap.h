@@ -1,8 +1,15 @@
 #include"RBTree.h"
+#include"BPlusTree.h"
+#include"../AVL_Tree/AVLTree.h"
 
 namespace pzh
 {
-    template<class K, class V>
+    // Compare 键值比较仿函数，默认std::less<>：带is_transparent，find等查找接口可以直接用string_view/const char*
+    // Policy 选择底层的树：rb_tree_policy（红黑树，默认）、avl_tree_policy（AVL树）或 bplus_tree_policy（B+树）
+    //   AVL树和B+树只支持基本操作：插入/try_emplace/operator[]、find/count、erase、lower_bound/upper_bound/equal_range、遍历；
+    //   节点句柄（extract/insert(node)）、sorted_unique建树/assign_sorted、merge、rank/select只有红黑树底层有
+    //   B+树的插入和删除都会挪动节点内的元素，之后原来的迭代器全部失效（erase(iterator)返回的除外）
+    template<class K, class V, class Compare = std::less<>, class Alloc = std::allocator<pair<K, V>>, class Policy = rb_tree_policy>
     class map
     {
     public:
@@ -14,8 +21,31 @@ namespace pzh
             }
         };
 
+        typedef typename Policy::template Tree<K, pair<K, V>, MapKeyOfT, Compare, Alloc> Tree;
         // 对类模板取内嵌类型，加typename告诉编译器这里是类型
-        typedef typename RBTree<K, pair<K, V>, MapKeyOfT>::iterator iterator;
+        typedef typename Tree::iterator iterator;
+        typedef typename Tree::const_iterator const_iterator;
+        typedef typename Tree::reverse_iterator reverse_iterator;
+        typedef typename Tree::const_reverse_iterator const_reverse_iterator;
+        // 节点句柄，只有红黑树底层支持
+        typedef typename __TreeNodeTypes<Tree>::node_type node_type;
+        typedef typename __TreeNodeTypes<Tree>::insert_return_type insert_return_type;
+        // 增强树（augmented_rb_tree_policy）的iterator就是const_iterator：value改了聚合值要跟着改，
+        // 所以没有operator[]，改value用insert_or_assign或update
+        static constexpr bool kAugmented = std::is_same_v<iterator, const_iterator>;
+
+        map() = default;
+
+        explicit map(const Compare& comp)
+            : _t(comp)
+        {}
+
+        // 从按键值严格递增的区间直接建树：map(pzh::sorted_unique, v.begin(), v.end())
+        template<class InputIterator>
+        map(sorted_unique_t, InputIterator first, InputIterator last)
+        {
+            _t.AssignSorted(first, last);
+        }
 
         iterator begin()
         {
@@ -27,17 +57,250 @@ namespace pzh
             return _t.end();
         }
 
-        V& operator[](const K& key)
+        const_iterator begin() const
+        {
+            return _t.begin();
+        }
+
+        const_iterator end() const
+        {
+            return _t.end();
+        }
+
+        reverse_iterator rbegin()
+        {
+            return _t.rbegin();
+        }
+
+        reverse_iterator rend()
         {
-            pair<iterator, bool> ret = insert(make_pair(key, V()));
-            return ret.first->second;
+            return _t.rend();
+        }
+
+        const_reverse_iterator rbegin() const
+        {
+            return _t.rbegin();
+        }
+
+        const_reverse_iterator rend() const
+        {
+            return _t.rend();
+        }
+
+        // key已存在时只查找，不构造V()，也不拷贝key
+        V& operator[](const K& key) requires (!kAugmented)
+        {
+            return _t.TryEmplace(key).first->second;
+        }
+
+        V& operator[](K&& key) requires (!kAugmented)
+        {
+            return _t.TryEmplace(std::move(key)).first->second;
         }
 
         pair<iterator, bool> insert(const pair<K, V>& kv)
         {
             return _t.Insert(kv);
         }
+
+        pair<iterator, bool> insert(pair<K, V>&& kv)
+        {
+            return _t.Insert(std::move(kv));
+        }
+
+        // 用args就地构造pair<K, V>
+        template<class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        {
+            return _t.Emplace(std::forward<Args>(args)...);
+        }
+
+        // key不存在时才用args构造value；key已存在时什么都不做，args不会被移走
+        template<class... Args>
+        pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+        {
+            return _t.TryEmplace(key, std::forward<Args>(args)...);
+        }
+
+        template<class... Args>
+        pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+        {
+            return _t.TryEmplace(std::move(key), std::forward<Args>(args)...);
+        }
+
+        // 把元素连同节点一起摘下来，可以改key或者插到另一个map里，不分配也不拷贝
+        node_type extract(const K& key)
+        {
+            return _t.Extract(key);
+        }
+
+        node_type extract(const_iterator pos)
+        {
+            return _t.Extract(pos);
+        }
+
+        // 插入失败（key已存在）时节点在返回值的node里
+        insert_return_type insert(node_type&& nh)
+        {
+            return _t.Insert(std::move(nh));
+        }
+
+        size_t size()
+        {
+            return _t.Size();
+        }
+
+        bool empty()
+        {
+            return _t.Size() == 0;
+        }
+
+        iterator find(const K& key)
+        {
+            return _t.Find(key);
+        }
+
+        // 异构查找：Compare带is_transparent时，find("abc")不会先构造K
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        iterator find(const KeyLike& key)
+        {
+            return _t.Find(key);
+        }
+
+        size_t count(const K& key)
+        {
+            return _t.Find(key) != _t.end() ? 1 : 0;
+        }
+
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        size_t count(const KeyLike& key)
+        {
+            return _t.Find(key) != _t.end() ? 1 : 0;
+        }
+
+        // 返回删除的元素个数（0或1）
+        size_t erase(const K& key)
+        {
+            return _t.Erase(key) ? 1 : 0;
+        }
+
+        // 返回被删元素的下一个位置
+        iterator erase(iterator pos)
+        {
+            return _t.Erase(pos);
+        }
+
+        iterator lower_bound(const K& key)
+        {
+            return _t.LowerBound(key);
+        }
+
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        iterator lower_bound(const KeyLike& key)
+        {
+            return _t.LowerBound(key);
+        }
+
+        iterator upper_bound(const K& key)
+        {
+            return _t.UpperBound(key);
+        }
+
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        iterator upper_bound(const KeyLike& key)
+        {
+            return _t.UpperBound(key);
+        }
+
+        pair<iterator, iterator> equal_range(const K& key)
+        {
+            return _t.EqualRange(key);
+        }
+
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        pair<iterator, iterator> equal_range(const KeyLike& key)
+        {
+            return _t.EqualRange(key);
+        }
+
+        // 用严格递增的区间替换全部内容，O(n)
+        template<class InputIterator>
+        void assign_sorted(InputIterator first, InputIterator last)
+        {
+            _t.AssignSorted(first, last);
+        }
+
+        // 把other里本容器没有的key搬过来，重复的key留在other中，O(n + m)
+        void merge(map& other)
+        {
+            _t.Merge(other._t);
+        }
+
+        // 小于key的元素个数，比如算key所在的百分位
+        size_t rank(const K& key)
+        {
+            return _t.Rank(key);
+        }
+
+        // 第k小的元素（从0开始），比如分页时直接定位到第k条
+        iterator select(size_t k)
+        {
+            return _t.Select(k);
+        }
+
+        // key不存在时插入，存在时赋值；增强树的聚合值同时更新
+        template<class M>
+        pair<iterator, bool> insert_or_assign(const K& key, M&& value)
+        {
+            pair<iterator, bool> ret = _t.TryEmplace(key, std::forward<M>(value));
+            if (!ret.second)
+            {
+                UpdateValue(ret.first, [&](V& v) { v = std::forward<M>(value); });
+            }
+            return ret;
+        }
+
+        // key存在时用fn(V&)原地修改value并返回true，比如m.update(k, [](long long& v) { v += 5; })
+        template<class Fn>
+        bool update(const K& key, Fn&& fn)
+        {
+            iterator it = _t.Find(key);
+            if (it == _t.end())
+                return false;
+            UpdateValue(it, fn);
+            return true;
+        }
+
+        // 下面只有Policy是augmented_rb_tree_policy<Monoid>时可用
+
+        // 键在[lo, hi)里的value按Monoid合并的结果，比如时间窗口内的和/最小/最大值，O(logN)
+        template<class KeyLike1, class KeyLike2>
+        auto aggregate(const KeyLike1& lo, const KeyLike2& hi)
+        {
+            return _t.Aggregate(lo, hi);
+        }
+
+        // 所有value的聚合，O(1)
+        auto aggregate()
+        {
+            return _t.Aggregate();
+        }
     private:
-        RBTree<K, pair<K, V>, MapKeyOfT> _t;
+        // 增强树要经过Update，改完顺带重算聚合值
+        template<class Fn>
+        void UpdateValue(iterator pos, Fn&& fn)
+        {
+            if constexpr (kAugmented)
+                _t.Update(pos, [&](pair<K, V>& kv) { fn(kv.second); });
+            else
+                fn(pos->second);
+        }
+
+        Tree _t;
     };
 }
@@ -1,8 +1,11 @@
 #include"RBTree.h"
+#include"BPlusTree.h"
+#include"../AVL_Tree/AVLTree.h"
 
 namespace pzh
 {
-    template<class K>
+    // Policy 选择底层的树，同pzh::map（AVL树和B+树底层支持的操作子集也同pzh::map）
+    template<class K, class Compare = std::less<>, class Alloc = std::allocator<K>, class Policy = rb_tree_policy>
     class set
     {
     public:
@@ -14,24 +17,191 @@ namespace pzh
             }
         };
 
-        typedef typename RBTree<K, K, SetKeyOfT>::iterator iterator;
+        typedef typename Policy::template Tree<K, K, SetKeyOfT, Compare, Alloc> Tree;
+        // set里的元素就是key，改了会破坏树的有序性，所以普通迭代器也是const迭代器
+        typedef typename Tree::const_iterator iterator;
+        typedef typename Tree::const_iterator const_iterator;
+        typedef typename Tree::const_reverse_iterator reverse_iterator;
+        typedef typename Tree::const_reverse_iterator const_reverse_iterator;
+        // 节点句柄，只有红黑树底层支持
+        typedef typename __TreeNodeTypes<Tree>::node_type node_type;
+        typedef typename __TreeNodeTypes<Tree>::insert_return_type insert_return_type;
 
-        iterator begin()
+        set() = default;
+
+        explicit set(const Compare& comp)
+            : _t(comp)
+        {}
+
+        // 从按键值严格递增的区间直接建树：set(pzh::sorted_unique, v.begin(), v.end())
+        template<class InputIterator>
+        set(sorted_unique_t, InputIterator first, InputIterator last)
+        {
+            _t.AssignSorted(first, last);
+        }
+
+        iterator begin() const
         {
             return _t.begin();
         }
 
-        iterator end()
+        iterator end() const
         {
             return _t.end();
         }
 
+        reverse_iterator rbegin() const
+        {
+            return _t.rbegin();
+        }
+
+        reverse_iterator rend() const
+        {
+            return _t.rend();
+        }
+
         pair<iterator, bool> insert(const K& key)
         {
             return _t.Insert(key);
         }
 
+        pair<iterator, bool> insert(K&& key)
+        {
+            return _t.Insert(std::move(key));
+        }
+
+        template<class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        {
+            return _t.Emplace(std::forward<Args>(args)...);
+        }
+
+        // 把元素连同节点一起摘下来，可以插到另一个set里，不分配也不拷贝
+        node_type extract(const K& key)
+        {
+            return _t.Extract(key);
+        }
+
+        node_type extract(const_iterator pos)
+        {
+            return _t.Extract(pos);
+        }
+
+        // 插入失败（key已存在）时节点在返回值的node里
+        insert_return_type insert(node_type&& nh)
+        {
+            return _t.Insert(std::move(nh));
+        }
+
+        size_t size()
+        {
+            return _t.Size();
+        }
+
+        bool empty()
+        {
+            return _t.Size() == 0;
+        }
+
+        iterator find(const K& key)
+        {
+            return _t.Find(key);
+        }
+
+        // 异构查找：Compare带is_transparent时，find("abc")不会先构造K
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        iterator find(const KeyLike& key)
+        {
+            return _t.Find(key);
+        }
+
+        size_t count(const K& key)
+        {
+            return _t.Find(key) != _t.end() ? 1 : 0;
+        }
+
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        size_t count(const KeyLike& key)
+        {
+            return _t.Find(key) != _t.end() ? 1 : 0;
+        }
+
+        // 返回删除的元素个数（0或1）
+        size_t erase(const K& key)
+        {
+            return _t.Erase(key) ? 1 : 0;
+        }
+
+        // 返回被删元素的下一个位置
+        iterator erase(iterator pos)
+        {
+            return _t.Erase(pos);
+        }
+
+        iterator lower_bound(const K& key)
+        {
+            return _t.LowerBound(key);
+        }
+
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        iterator lower_bound(const KeyLike& key)
+        {
+            return _t.LowerBound(key);
+        }
+
+        iterator upper_bound(const K& key)
+        {
+            return _t.UpperBound(key);
+        }
+
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        iterator upper_bound(const KeyLike& key)
+        {
+            return _t.UpperBound(key);
+        }
+
+        pair<iterator, iterator> equal_range(const K& key)
+        {
+            return _t.EqualRange(key);
+        }
+
+        template<class KeyLike>
+            requires requires { typename Compare::is_transparent; }
+        pair<iterator, iterator> equal_range(const KeyLike& key)
+        {
+            return _t.EqualRange(key);
+        }
+
+        // 用严格递增的区间替换全部内容，O(n)
+        template<class InputIterator>
+        void assign_sorted(InputIterator first, InputIterator last)
+        {
+            _t.AssignSorted(first, last);
+        }
+
+        // 把other里本容器没有的key搬过来，重复的key留在other中，O(n + m)
+        void merge(set& other)
+        {
+            _t.Merge(other._t);
+        }
+
+        // 小于key的元素个数，比如算key所在的百分位
+        size_t rank(const K& key)
+        {
+            return _t.Rank(key);
+        }
+
+        // 第k小的元素（从0开始），比如分页时直接定位到第k条
+        iterator select(size_t k)
+        {
+            return _t.Select(k);
+        }
+
     private:
-        RBTree<K, K, SetKeyOfT> _t;
+        Tree _t;
     };
 }
\ No newline at end of file
@@ -0,0 +1,487 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <utility>
+#include "../Memory_management/PoolAllocator.h"
+
+namespace pzh
+{
+    // 持久化（写时复制）的有序map
+    /*
+     * 和pzh::map的区别：节点没有父指针，也没有头节点，一个节点可以同时挂在好几个版本的树上
+     *   snapshot()（或者拷贝构造）只是让新对象也指向同一个根，根的引用计数+1，O(1)
+     *   修改时从根往下走，引用计数为1的节点只有自己在用，直接原地改；
+     *   大于1说明有快照共享，复制一份（孩子的引用计数+1）再改，所以每次修改最多复制O(logN)个路径上的节点
+     *   没有快照时所有节点的引用计数都是1，修改和普通的树一样不复制
+     * 平衡用AVL的高度：递归插入/删除返回新的子树根，路径复制只需要在回溯时把链接改成新节点
+     *
+     * 线程：一个版本（一个persistent_map对象）同一时间只能有一个线程修改；
+     * 快照交给别的线程只读是安全的，引用计数是原子的，写线程不会改到快照能看到的节点
+     */
+    template<class K, class V, class Compare = std::less<>, class Alloc = std::allocator<std::pair<K, V>>>
+    class persistent_map
+    {
+    public:
+        typedef std::pair<K, V> value_type;
+
+    private:
+        struct Node
+        {
+            Node* _left;
+            Node* _right;
+            value_type _data;
+            int _height;                   // 以该节点为根的子树高度，叶子是1
+            std::atomic<uint32_t> _ref;    // 指向该节点的链接个数（父节点或者某个版本的根）
+
+            template<class... Args>
+            explicit Node(Node* left, Node* right, int height, Args&&... args)
+                :_left(left)
+                , _right(right)
+                , _data(std::forward<Args>(args)...)
+                , _height(height)
+                , _ref(1)
+            {}
+        };
+
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc;
+
+        // AVL树高约1.44logN，64层足够任何内存放得下的树
+        static const int kMaxHeight = 64;
+
+    public:
+        // 只读迭代器：没有父指针，用一个栈记录从根到当前节点还没访问的祖先
+        // 迭代期间它所属的版本要一直存在
+        class const_iterator
+        {
+            friend class persistent_map;
+
+        public:
+            const_iterator() = default;
+
+            const value_type& operator*() const
+            {
+                return _stack[_top - 1]->_data;
+            }
+
+            const value_type* operator->() const
+            {
+                return &_stack[_top - 1]->_data;
+            }
+
+            // 中序后继：弹出当前节点，再把右子树的左链压栈
+            const_iterator& operator++()
+            {
+                const Node* cur = _stack[--_top];
+                PushLeft(cur->_right);
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator tmp(*this);
+                ++*this;
+                return tmp;
+            }
+
+            bool operator==(const const_iterator& it) const
+            {
+                return _top == it._top && (_top == 0 || _stack[_top - 1] == it._stack[it._top - 1]);
+            }
+
+            bool operator!=(const const_iterator& it) const
+            {
+                return !(*this == it);
+            }
+
+        private:
+            void PushLeft(const Node* cur)
+            {
+                while (cur)
+                {
+                    _stack[_top++] = cur;
+                    cur = cur->_left;
+                }
+            }
+
+            const Node* _stack[kMaxHeight];
+            int _top = 0;
+        };
+
+        typedef const_iterator iterator;
+
+        persistent_map() = default;
+
+        explicit persistent_map(const Compare& comp, const Alloc& alloc = Alloc())
+            :_alloc(alloc)
+            , _comp(comp)
+        {}
+
+        // 拷贝就是快照：共享整棵树，O(1)
+        persistent_map(const persistent_map& m)
+            :_root(m._root)
+            , _size(m._size)
+            , _alloc(m._alloc)
+            , _comp(m._comp)
+        {
+            Retain(_root);
+        }
+
+        persistent_map(persistent_map&& m) noexcept
+            :_root(m._root)
+            , _size(m._size)
+            , _alloc(m._alloc)
+            , _comp(m._comp)
+        {
+            m._root = nullptr;
+            m._size = 0;
+        }
+
+        persistent_map& operator=(persistent_map m)
+        {
+            std::swap(_root, m._root);
+            std::swap(_size, m._size);
+            std::swap(_alloc, m._alloc);
+            std::swap(_comp, m._comp);
+            return *this;
+        }
+
+        ~persistent_map()
+        {
+            Release(_root);
+        }
+
+        // 当前版本的只读快照，之后对*this的修改不会影响它
+        persistent_map snapshot() const
+        {
+            return *this;
+        }
+
+        const_iterator begin() const
+        {
+            const_iterator it;
+            it.PushLeft(_root);
+            return it;
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator();
+        }
+
+        size_t size() const
+        {
+            return _size;
+        }
+
+        bool empty() const
+        {
+            return _size == 0;
+        }
+
+        template<class KeyLike>
+        const_iterator find(const KeyLike& key) const
+        {
+            // 第一个不小于key的节点，路径上往左拐的节点（还没访问的祖先）都留在栈里
+            const_iterator it;
+            const Node* cur = _root;
+            while (cur)
+            {
+                if (_comp(cur->_data.first, key))
+                {
+                    cur = cur->_right;
+                }
+                else
+                {
+                    it._stack[it._top++] = cur;
+                    cur = cur->_left;
+                }
+            }
+            if (it._top == 0 || _comp(key, (*it).first))
+                return end();
+            return it;
+        }
+
+        template<class KeyLike>
+        size_t count(const KeyLike& key) const
+        {
+            return FindNode(key) ? 1 : 0;
+        }
+
+        // 返回是否新插入；key已存在时什么都不复制
+        bool insert(const value_type& kv)
+        {
+            return InsertUnique(kv.first, [&]() { return CreateNode(kv); });
+        }
+
+        bool insert(value_type&& kv)
+        {
+            return InsertUnique(kv.first, [&]() { return CreateNode(std::move(kv)); });
+        }
+
+        template<class... Args>
+        bool try_emplace(const K& key, Args&&... args)
+        {
+            return InsertUnique(key, [&]() {
+                return CreateNode(std::piecewise_construct, std::forward_as_tuple(key),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+            });
+        }
+
+        // key不存在就插入，存在就覆盖value；返回是否新插入
+        template<class M>
+        bool insert_or_assign(const K& key, M&& value)
+        {
+            if (try_emplace(key, std::forward<M>(value)))
+                return true;
+            UniquePath(key)->_data.second = std::forward<M>(value);
+            return false;
+        }
+
+        // 返回的引用在下一次snapshot()之前有效：之后再写它会改到快照共享的节点
+        V& operator[](const K& key)
+        {
+            try_emplace(key);
+            return UniquePath(key)->_data.second;
+        }
+
+        size_t erase(const K& key)
+        {
+            if (FindNode(key) == nullptr)
+                return 0;
+            _root = EraseRec(_root, key);
+            --_size;
+            return 1;
+        }
+
+        // 检查AVL的高度和平衡、key的顺序以及元素个数
+        bool IsValid() const
+        {
+            size_t count = 0;
+            const value_type* prev = nullptr;
+            return Check(_root, prev, count) >= 0 && count == _size;
+        }
+
+    private:
+        template<class KeyLike>
+        const Node* FindNode(const KeyLike& key) const
+        {
+            const Node* cur = _root;
+            while (cur)
+            {
+                if (_comp(key, cur->_data.first))
+                    cur = cur->_left;
+                else if (_comp(cur->_data.first, key))
+                    cur = cur->_right;
+                else
+                    return cur;
+            }
+            return nullptr;
+        }
+
+        template<class KeyLike, class MakeNode>
+        bool InsertUnique(const KeyLike& key, MakeNode&& makeNode)
+        {
+            // 先确认key不存在，避免白白复制一条路径
+            if (FindNode(key))
+                return false;
+            _root = InsertRec(_root, key, makeNode);
+            ++_size;
+            return true;
+        }
+
+        // 下面的递归函数都“接管”参数node上的一个引用，返回的新子树根带着一个引用交还给调用者的链接
+
+        template<class KeyLike, class MakeNode>
+        Node* InsertRec(Node* node, const KeyLike& key, MakeNode& makeNode)
+        {
+            if (node == nullptr)
+                return makeNode();
+            node = Mutable(node);
+            if (_comp(key, node->_data.first))
+                node->_left = InsertRec(node->_left, key, makeNode);
+            else
+                node->_right = InsertRec(node->_right, key, makeNode);
+            return Rebalance(node);
+        }
+
+        // key一定存在
+        Node* EraseRec(Node* node, const K& key)
+        {
+            node = Mutable(node);
+            if (_comp(key, node->_data.first))
+            {
+                node->_left = EraseRec(node->_left, key);
+            }
+            else if (_comp(node->_data.first, key))
+            {
+                node->_right = EraseRec(node->_right, key);
+            }
+            else
+            {
+                Node* left = node->_left;
+                Node* right = node->_right;
+                node->_left = node->_right = nullptr;  // 孩子上的引用转给顶替它的节点
+                Release(node);
+                if (left == nullptr)
+                    return right;
+                if (right == nullptr)
+                    return left;
+                // 两个孩子：右子树的最小节点顶替被删的节点
+                Node* min = nullptr;
+                right = EraseMin(right, min);
+                min->_left = left;
+                min->_right = right;
+                node = min;
+            }
+            return Rebalance(node);
+        }
+
+        // 摘下子树的最小节点，通过min交出去（已经是可修改的）
+        Node* EraseMin(Node* node, Node*& min)
+        {
+            node = Mutable(node);
+            if (node->_left == nullptr)
+            {
+                min = node;
+                Node* right = node->_right;
+                node->_right = nullptr;
+                return right;
+            }
+            node->_left = EraseMin(node->_left, min);
+            return Rebalance(node);
+        }
+
+        // 从根到key所在节点的路径全部变成独占的，返回该节点（key一定存在）
+        Node* UniquePath(const K& key)
+        {
+            Node** link = &_root;
+            while (true)
+            {
+                Node* cur = *link = Mutable(*link);
+                if (_comp(key, cur->_data.first))
+                    link = &cur->_left;
+                else if (_comp(cur->_data.first, key))
+                    link = &cur->_right;
+                else
+                    return cur;
+            }
+        }
+
+        // 父节点已经是独占的前提下：引用计数为1说明只有这一条链接指向它，可以原地修改；
+        // 否则复制一份换到这条链接上，原节点少一个引用
+        Node* Mutable(Node* node)
+        {
+            if (node->_ref.load(std::memory_order_acquire) == 1)
+                return node;
+            Node* copy = CreateNode(node->_data);
+            copy->_left = node->_left;
+            copy->_right = node->_right;
+            copy->_height = node->_height;
+            Retain(copy->_left);
+            Retain(copy->_right);
+            Release(node);
+            return copy;
+        }
+
+        static int Height(const Node* node)
+        {
+            return node ? node->_height : 0;
+        }
+
+        static void Update(Node* node)
+        {
+            int lh = Height(node->_left);
+            int rh = Height(node->_right);
+            node->_height = (lh > rh ? lh : rh) + 1;
+        }
+
+        // node已独占；旋转会改到的孩子先变成独占
+        Node* RotateL(Node* node)
+        {
+            Node* subR = Mutable(node->_right);
+            node->_right = subR->_left;
+            subR->_left = node;
+            Update(node);
+            Update(subR);
+            return subR;
+        }
+
+        Node* RotateR(Node* node)
+        {
+            Node* subL = Mutable(node->_left);
+            node->_left = subL->_right;
+            subL->_right = node;
+            Update(node);
+            Update(subL);
+            return subL;
+        }
+
+        // 左右子树高度差超过1时旋转，返回这棵子树新的根
+        Node* Rebalance(Node* node)
+        {
+            Update(node);
+            int bf = Height(node->_right) - Height(node->_left);
+            if (bf == 2)
+            {
+                if (Height(node->_right->_right) < Height(node->_right->_left))
+                    node->_right = RotateR(Mutable(node->_right));  // 右左：先对右孩子右旋
+                return RotateL(node);
+            }
+            if (bf == -2)
+            {
+                if (Height(node->_left->_left) < Height(node->_left->_right))
+                    node->_left = RotateL(Mutable(node->_left));    // 左右：先对左孩子左旋
+                return RotateR(node);
+            }
+            return node;
+        }
+
+        template<class... Args>
+        Node* CreateNode(Args&&... args)
+        {
+            return pzh::__AllocateNode(_alloc, nullptr, nullptr, 1, std::forward<Args>(args)...);
+        }
+
+        static void Retain(Node* node)
+        {
+            if (node)
+                node->_ref.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // 少一个引用，最后一个引用没了就释放节点，再对两个孩子各少一个引用
+        void Release(Node* node)
+        {
+            while (node && node->_ref.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                Node* left = node->_left;
+                Node* right = node->_right;
+                pzh::__DestroyNode(_alloc, node);
+                Release(left);
+                node = right;  // 右孩子循环处理，只在左边递归
+            }
+        }
+
+        // 返回子树高度，出错返回-1
+        int Check(const Node* node, const value_type*& prev, size_t& count) const
+        {
+            if (node == nullptr)
+                return 0;
+            int lh = Check(node->_left, prev, count);
+            if (lh < 0 || (prev && !_comp(prev->first, node->_data.first)))
+                return -1;
+            prev = &node->_data;
+            ++count;
+            int rh = Check(node->_right, prev, count);
+            if (rh < 0 || lh - rh > 1 || rh - lh > 1 || node->_height != (lh > rh ? lh : rh) + 1)
+                return -1;
+            return node->_height;
+        }
+
+        Node* _root = nullptr;
+        size_t _size = 0;
+        [[no_unique_address]] NodeAlloc _alloc;
+        [[no_unique_address]] Compare _comp;
+    };
+}
@@ -2,6 +2,16 @@
 #include <iostream>
 #include <vector>
 #include <cassert>
+#include <memory>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+#include <concepts>
+#include "../Template_Advanced/reverse_iterator.h"
+#include "../Memory_management/PoolAllocator.h"
 
 using namespace std;
 
@@ -12,32 +22,69 @@ enum Colour
     BLACK
 };
 
+// 增强树：每个节点多存一份子树的聚合值，Monoid为void时是空基类，不占空间
+template<class Monoid>
+struct __RBTreeAugment
+{
+    typename Monoid::value_type _agg;  // 以该节点为根的子树里所有元素按中序合并的结果
+};
+
+template<>
+struct __RBTreeAugment<void>
+{};
+
 // 红黑树节点定义 (泛型T)
-template<class T>
-struct RBTreeNode
+template<class T, class Monoid = void>
+struct RBTreeNode : __RBTreeAugment<Monoid>
 {
-    RBTreeNode<T>* _left;
-    RBTreeNode<T>* _right;
-    RBTreeNode<T>* _parent;
-    T _data;                // 节点数据，T可能是Key，也可能是pair<K, V>
+    RBTreeNode* _left;
+    RBTreeNode* _right;
+    RBTreeNode* _parent;
+    union
+    {
+        T _data;            // 节点数据，T可能是Key，也可能是pair<K, V>；头节点不构造它
+    };
     Colour _col;
+    size_t _subsize;        // 以该节点为根的子树的节点个数，用于O(1)的Size和O(logN)的排名查询
+
+    // 头节点用：只有链接，没有数据
+    RBTreeNode()
+        :_left(nullptr)
+        , _right(nullptr)
+        , _parent(nullptr)
+        , _col(RED)
+        , _subsize(0)
+    {}
 
-    // 构造函数
-    RBTreeNode(const T& data)
+    // 构造函数：参数原样转发给T的构造函数，就地构造数据（拷贝、移动、emplace都走这里）
+    template<class... Args>
+    explicit RBTreeNode(std::in_place_t, Args&&... args)
         :_left(nullptr)
         , _right(nullptr)
         , _parent(nullptr)
-        , _data(data)      // 初始化节点数据
+        , _data(std::forward<Args>(args)...)      // 初始化节点数据
         , _col(RED)        // 新插入节点默认为红色（红黑树规则）
+        , _subsize(1)
+    {}
+
+    // _data在union里，由RBTree释放节点时显式析构（头节点没有数据，不能析构）
+    ~RBTreeNode()
     {}
 };
 
 // 红黑树迭代器
-template<class T>
+// Ref/Ptr 取 T&/T* 是普通迭代器，取 const T&/const T* 是const迭代器
+/*
+ * 树里有一个头节点header，end()就指向它：
+ *   header->_parent 指向根，根的_parent指向header
+ *   header->_left / header->_right 指向最小/最大节点，begin()和--end()都是O(1)
+ *   header是红色的，并且header->_parent->_parent == header，靠这一点和根节点区分开
+ */
+template<class T, class Ref, class Ptr, class Node = RBTreeNode<T>>
 struct __TreeIterator
 {
-    typedef RBTreeNode<T> Node;   // 节点类型别名
-    typedef __TreeIterator<T> Self; // 迭代器自身类型别名
+    typedef __TreeIterator<T, Ref, Ptr, Node> Self; // 迭代器自身类型别名
+    typedef __TreeIterator<T, T&, T*, Node> Iterator;
     Node* _node;                 // 当前迭代器指向的节点
 
     // 构造函数：用节点指针初始化迭代器
@@ -45,26 +92,33 @@ struct __TreeIterator
         : _node(node)
     {}
 
+    // 普通迭代器可以转换成const迭代器；Self就是Iterator时约束不成立，拷贝走编译器生成的版本，不会触发-Wdeprecated-copy
+    template<class It>
+        requires std::is_same_v<It, Iterator> && (!std::is_same_v<It, Self>)
+    __TreeIterator(const It& it)
+        : _node(it._node)
+    {}
+
     // 解引用操作符：返回节点数据的引用
-    T& operator*()
+    Ref operator*()
     {
         return _node->_data;
     }
 
     // 箭头操作符：返回节点数据的指针
-    T* operator->()
+    Ptr operator->()
     {
         return &_node->_data;
     }
 
     // 不等于操作符：比较两个迭代器是否指向不同节点
-    bool operator!=(const Self& s)
+    bool operator!=(const Self& s) const
     {
         return _node != s._node;
     }
 
     // 等于操作符：比较两个迭代器是否指向相同节点
-    bool operator==(const Self& s)
+    bool operator==(const Self& s) const
     {
         return _node == s._node;
     }
@@ -87,12 +141,15 @@ struct __TreeIterator
             // 向上查找，直到当前节点是父节点的左子节点
             Node* cur = _node;
             Node* parent = cur->_parent;
-            while (parent && cur == parent->_right)
+            while (cur == parent->_right)
             {
                 cur = parent;
                 parent = parent->_parent;
             }
-            _node = parent; // 父节点就是下一个节点
+            // 只有根节点且根没有右子树时，会从最大节点走到header再绕回根，这时cur已经是header
+            if (cur->_right != parent)
+                cur = parent;
+            _node = cur; // 父节点就是下一个节点
         }
         return *this;
     }
@@ -100,14 +157,11 @@ struct __TreeIterator
     // 前置--操作符：迭代器移动到中序前驱节点
     Self& operator--()
     {
-        if (_node == nullptr) // 特殊情况：end()迭代器
+        if (_node->_col == RED && _node->_parent->_parent == _node) // end()迭代器：前一个是最大节点
         {
-            // 这里假设外部能保证不是空树
-            // 实际标准库通常通过header节点处理，这里简化处理
-            return *this;
+            _node = _node->_right;
         }
-
-        if (_node->_left) // 如果当前节点有左子树
+        else if (_node->_left) // 如果当前节点有左子树
         {
             // 前一个节点是左子树的最右节点（左子树中的最大节点）
             Node* cur = _node->_left;
@@ -122,7 +176,7 @@ struct __TreeIterator
             // 向上查找，直到当前节点是父节点的右子节点
             Node* cur = _node;
             Node* parent = cur->_parent;
-            while (parent && cur == parent->_left)
+            while (cur == parent->_left)
             {
                 cur = parent;
                 parent = parent->_parent;
@@ -131,86 +185,401 @@ struct __TreeIterator
         }
         return *this;
     }
+
+    Self operator++(int)
+    {
+        Self tmp(*this);
+        ++*this;
+        return tmp;
+    }
+
+    Self operator--(int)
+    {
+        Self tmp(*this);
+        --*this;
+        return tmp;
+    }
+};
+
+// 节点句柄：Extract从树上摘下来的节点，连同元素一起归句柄所有
+// 可以改key/value之后再Insert回同一棵或另一棵树（分配器相等），全程不分配、不拷贝元素；句柄析构时节点还没插回去就释放掉
+template<class T, class NodeAlloc>
+class __TreeNodeHandle
+{
+    typedef std::allocator_traits<NodeAlloc> NodeTraits;
+    typedef typename NodeTraits::value_type Node;
+    template<class, class, class, class, class, class> friend class RBTree;
+
+    __TreeNodeHandle(Node* node, const NodeAlloc& alloc)
+        :_node(node)
+        , _alloc(alloc)
+    {}
+
+public:
+    __TreeNodeHandle() = default;
+
+    __TreeNodeHandle(__TreeNodeHandle&& nh) noexcept
+        :_node(nh._node)
+        , _alloc(nh._alloc)
+    {
+        nh._node = nullptr;
+    }
+
+    __TreeNodeHandle& operator=(__TreeNodeHandle&& nh) noexcept
+    {
+        if (this != &nh)
+        {
+            Reset();
+            _node = nh._node;
+            _alloc = nh._alloc;
+            nh._node = nullptr;
+        }
+        return *this;
+    }
+
+    ~__TreeNodeHandle()
+    {
+        Reset();
+    }
+
+    bool empty() const
+    {
+        return _node == nullptr;
+    }
+
+    explicit operator bool() const
+    {
+        return _node != nullptr;
+    }
+
+    // set用：元素本身
+    T& value() const
+    {
+        return _node->_data;
+    }
+
+    // map用：节点在树外面，key可以直接改
+    auto& key() const requires requires(T& t) { t.first; }
+    {
+        return _node->_data.first;
+    }
+
+    auto& mapped() const requires requires(T& t) { t.second; }
+    {
+        return _node->_data.second;
+    }
+
+private:
+    void Reset()
+    {
+        if (_node)
+        {
+            _node->_data.~T();
+            pzh::__DestroyNode(_alloc, _node);
+            _node = nullptr;
+        }
+    }
+
+    Node* _node = nullptr;
+    [[no_unique_address]] NodeAlloc _alloc;
 };
 
+// 插入节点句柄的结果：插入失败时句柄原样放在node里还给调用者
+template<class Iterator, class NodeHandle>
+struct __TreeInsertReturn
+{
+    Iterator position;
+    bool inserted;
+    NodeHandle node;
+};
+
+// map/set取底层树的节点句柄类型；B+树的元素放在叶子数组里，没有可以摘下来的节点，
+// 这时类型是个空结构体，extract/insert(node_type&&)只有在调用时才会报错
+struct __NoNodeHandle
+{};
+
+template<class Tree>
+struct __TreeNodeTypes
+{
+    typedef __NoNodeHandle node_type;
+    typedef __NoNodeHandle insert_return_type;
+};
+
+template<class Tree>
+    requires requires { typename Tree::node_type; }
+struct __TreeNodeTypes<Tree>
+{
+    typedef typename Tree::node_type node_type;
+    typedef typename Tree::insert_return_type insert_return_type;
+};
+
+// 增强树里单个元素参与聚合的值：map是value，set是key本身
+template<class T>
+const auto& __AugmentedValue(const T& data)
+{
+    if constexpr (requires { data.second; })
+        return data.second;
+    else
+        return data;
+}
+
 // 红黑树类模板
 // K: 键值类型
 // T: 存储的数据类型 (Set是K, Map是pair<K,V>)
 // KeyOfT: 仿函数，用于从T中提取键值K
-template<class K, class T, class KeyOfT>
+// Compare: 键值的比较仿函数（严格弱序），默认std::less<>，带is_transparent，支持异构查找
+// Alloc: 元素的分配器，内部rebind成节点的分配器（比如pzh::pool_allocator让节点走内存池）
+// Monoid: 不为void时是增强树，每个节点维护子树的聚合值，Aggregate(lo, hi)是O(logN)的区间聚合
+//   要求：value_type、identity()单位元、lift(v)单个元素的值、combine(a, b)满足结合律（见pzh::sum_monoid）
+template<class K, class T, class KeyOfT, class Compare = std::less<>, class Alloc = std::allocator<T>, class Monoid = void>
 class RBTree
 {
-    typedef RBTreeNode<T> Node; // 节点类型别名
+    typedef RBTreeNode<T, Monoid> Node; // 节点类型别名
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc;
+    static constexpr bool kAugmented = !std::is_void_v<Monoid>;
+    // 增强树的元素不能通过迭代器改，否则聚合值不会跟着变；要改走Update
+    typedef std::conditional_t<kAugmented, const T&, T&> IterRef;
+    typedef std::conditional_t<kAugmented, const T*, T*> IterPtr;
 public:
-    typedef __TreeIterator<T> iterator; // 迭代器类型别名
+    typedef __TreeIterator<T, IterRef, IterPtr, Node> iterator; // 迭代器类型别名，增强树上就是const_iterator
+    typedef __TreeIterator<T, const T&, const T*, Node> const_iterator;
+    typedef ReverseIterator<iterator, IterRef, IterPtr> reverse_iterator;
+    typedef ReverseIterator<const_iterator, const T&, const T*> const_reverse_iterator;
+    typedef __TreeNodeHandle<T, NodeAlloc> node_type;
+    typedef __TreeInsertReturn<iterator, node_type> insert_return_type;
+
+    RBTree()
+    {
+        ResetHeader(nullptr);
+    }
+
+    // 带状态的比较器从这里传进来
+    explicit RBTree(const Compare& comp)
+        : _comp(comp)
+    {
+        ResetHeader(nullptr);
+    }
+
+    // 拷贝构造：按原树的形状和颜色逐个复制节点
+    RBTree(const RBTree& t)
+        : _comp(t._comp)
+    {
+        ResetHeader(Copy(t.Root(), &_header));
+    }
+
+    RBTree& operator=(RBTree t)
+    {
+        Swap(t);
+        return *this;
+    }
+
+    ~RBTree()
+    {
+        Destroy(Root());
+    }
 
-    // 返回指向最小元素的迭代器
+    // 头节点在树对象里面，交换两棵树时要把根的父指针改回各自的头节点
+    void Swap(RBTree& t)
+    {
+        swap(_header._parent, t._header._parent);
+        swap(_header._left, t._header._left);
+        swap(_header._right, t._header._right);
+        swap(_comp, t._comp);
+        FixHeader();
+        t.FixHeader();
+    }
+
+    // 返回指向最小元素的迭代器，头节点记着最小节点，O(1)
     iterator begin()
     {
-        Node* cur = _root;
-        // 一直向左走找到最小节点
-        while (cur && cur->_left)
-        {
-            cur = cur->_left;
-        }
-        return iterator(cur);
+        return iterator(_header._left);
     }
 
-    // 返回尾后迭代器
+    // 返回尾后迭代器：头节点
     iterator end()
     {
-        return iterator(nullptr);
+        return iterator(&_header);
     }
 
-    // 插入操作：返回pair<迭代器, 是否插入成功>
+    const_iterator begin() const
+    {
+        return const_iterator(_header._left);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(const_cast<Node*>(&_header));
+    }
+
+    reverse_iterator rbegin()
+    {
+        return reverse_iterator(end());
+    }
+
+    reverse_iterator rend()
+    {
+        return reverse_iterator(begin());
+    }
+
+    const_reverse_iterator rbegin() const
+    {
+        return const_reverse_iterator(end());
+    }
+
+    const_reverse_iterator rend() const
+    {
+        return const_reverse_iterator(begin());
+    }
+
+    // 插入操作：返回pair<迭代器, 是否插入成功>；键值已存在时不分配节点
     pair<iterator, bool> Insert(const T& data)
     {
-        if (_root == nullptr) // 空树情况
+        KeyOfT kot;
+        return InsertUnique(kot(data), [&]() { return CreateNode(data); });
+    }
+
+    // 右值版本：数据直接移动进新节点
+    pair<iterator, bool> Insert(T&& data)
+    {
+        KeyOfT kot;
+        return InsertUnique(kot(data), [&]() { return CreateNode(std::move(data)); });
+    }
+
+    // 用args就地构造元素。要先构造出来才知道键值，所以键值已存在时会多一次节点的分配和释放
+    template<class... Args>
+    pair<iterator, bool> Emplace(Args&&... args)
+    {
+        KeyOfT kot;
+        Node* node = CreateNode(std::forward<Args>(args)...);
+        pair<iterator, bool> ret = InsertUnique(kot(node->_data), [node]() { return node; });
+        if (!ret.second)
+            DestroyNode(node);
+        return ret;
+    }
+
+    // 只用于T是pair的map：先按key查找，不存在时才用(key, V(args...))构造节点；存在时key和args都不会被移走
+    template<class KeyArg, class... Args>
+    pair<iterator, bool> TryEmplace(KeyArg&& key, Args&&... args)
+    {
+        return InsertUnique(key, [&]() {
+            return CreateNode(std::piecewise_construct,
+                              std::forward_as_tuple(std::forward<KeyArg>(key)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+        });
+    }
+
+    // 把节点句柄里的节点挂回树上，不分配、不拷贝；键值已存在时句柄原样交还给调用者
+    insert_return_type Insert(node_type&& nh)
+    {
+        if (nh.empty())
+            return insert_return_type{ end(), false, node_type() };
+        assert(nh._alloc == _alloc);  // 节点是另一个分配器分配的，不能由这棵树释放
+        KeyOfT kot;
+        Node* node = nh._node;
+        pair<iterator, bool> ret = InsertUnique(kot(node->_data), [&]() {
+            nh._node = nullptr;
+            node->_left = node->_right = nullptr;
+            node->_col = RED;
+            node->_subsize = 1;
+            UpdateAggregate(node);  // 在树外面时key/value可能被改过
+            return node;
+        });
+        if (!ret.second)
+            return insert_return_type{ ret.first, false, std::move(nh) };
+        return insert_return_type{ ret.first, true, node_type() };
+    }
+
+    // 把pos指向的节点从树上摘下来交给句柄，元素不拷贝也不释放，可以改key之后插到另一棵树里
+    node_type Extract(const_iterator pos)
+    {
+        Node* node = pos._node;
+        UnlinkNode(node);
+        node->_left = node->_right = node->_parent = nullptr;
+        return node_type(node, _alloc);
+    }
+
+    node_type Extract(iterator pos) requires (!kAugmented)
+    {
+        return Extract(const_iterator(pos));
+    }
+
+    template<class KeyLike>
+    node_type Extract(const KeyLike& key)
+    {
+        iterator it = Find(key);
+        if (it == end())
+            return node_type();
+        return Extract(it);
+    }
+
+private:
+    // 插入的公共部分：按key找位置，key不存在时才调用makeNode()拿到新节点（红色，没有孩子）再挂上去做平衡调整
+    template<class KeyLike, class MakeNode>
+    pair<iterator, bool> InsertUnique(const KeyLike& key, MakeNode&& makeNode)
+    {
+        if (Root() == nullptr) // 空树情况
         {
-            _root = new Node(data);
-            _root->_col = BLACK; // 根节点必须为黑色
-            return make_pair(iterator(_root), true);
+            ResetHeader(makeNode());
+            Root()->_col = BLACK; // 根节点必须为黑色
+            return make_pair(iterator(Root()), true);
         }
-        Node* parent = nullptr;
-        Node* cur = _root;
         KeyOfT kot; // 仿函数对象，用于提取键值
-        // 查找插入位置
+        // 查找插入位置：每层只比较一次 key < 当前节点，决定往左还是往右
+        // 和key相等的节点如果存在，一定是最后一次往右拐的那个节点（不大于key的最大节点），最后再比一次就知道
+        Node* parent = nullptr;
+        Node* cur = Root();
+        Node* notGreater = nullptr; // 最后一次往右拐的节点
+        bool goLeft = false;
         while (cur)
         {
-            if (kot(cur->_data) < kot(data)) // 当前节点键值小于插入键值
+            parent = cur;
+            goLeft = _comp(key, kot(cur->_data));
+            if (goLeft) // 插入键值小于当前节点键值
             {
-                parent = cur;
-                cur = cur->_right;
-            }
-            else if (kot(cur->_data) > kot(data)) // 当前节点键值大于插入键值
-            {
-                parent = cur;
                 cur = cur->_left;
             }
-            else // 键值已存在，插入失败
+            else // 插入键值不小于当前节点键值
             {
-                return make_pair(iterator(cur), false);
+                notGreater = cur;
+                cur = cur->_right;
             }
         }
+        if (notGreater && !_comp(kot(notGreater->_data), key)) // 键值已存在，插入失败
+        {
+            return make_pair(iterator(notGreater), false);
+        }
         // 创建新节点
-        cur = new Node(data);
+        cur = makeNode();
         Node* newnode = cur; // 保存新节点指针用于返回
         cur->_col = RED;     // 新节点颜色为红色
         // 将新节点链接到父节点
-        if (kot(parent->_data) < kot(data))
+        // 挂在最大节点右边/最小节点左边时，新节点成为新的最大/最小节点
+        if (!goLeft)
         {
             parent->_right = cur;
             cur->_parent = parent;
+            if (parent == _header._right)
+                _header._right = cur;
         }
         else
         {
             parent->_left = cur;
             cur->_parent = parent;
+            if (parent == _header._left)
+                _header._left = cur;
+        }
+
+        // 新节点的所有祖先子树都多了一个节点（之后的旋转自己维护_subsize和聚合值）
+        for (Node* p = parent; p != &_header; p = p->_parent)
+        {
+            ++p->_subsize;
+            UpdateAggregate(p);
         }
 
         // 红黑树平衡调整：父节点为红色时需要调整
         // 因为红色节点不能连续出现(规则3)
-        while (parent && parent->_col == RED)
+        // 根的父节点是header（红色），parent是header时说明已经调整到根
+        while (parent != &_header && parent->_col == RED)
         {
             Node* grandfather = parent->_parent; // 祖父节点
             if (parent == grandfather->_left) // 父节点是祖父节点的左孩子
@@ -321,32 +690,95 @@ public:
                 }
             }
         }
-        _root->_col = BLACK; // 确保根节点为黑色（规则2）
+        Root()->_col = BLACK; // 确保根节点为黑色（规则2）
         return make_pair(iterator(newnode), true);
     }
 
-    // 查找操作：根据键值查找节点
-    Node* Find(const K& key)
+public:
+
+    // 下面的查找都是模板：Compare带is_transparent时（比如std::less<>），
+    // 可以直接拿string_view/const char*在string为key的树里查找，不用先构造一个K
+
+    // 查找操作：返回指向键值为key的元素的迭代器，找不到返回end()
+    // 先找第一个不小于key的节点（每层比较一次），再比较一次确认是否相等
+    template<class KeyLike>
+    iterator Find(const KeyLike& key)
     {
-        Node* cur = _root;
         KeyOfT kot;
+        iterator it = LowerBound(key);
+        if (it == end() || _comp(key, kot(*it)))
+            return end(); // 未找到
+        return it;
+    }
 
+    // 第一个键值不小于key的元素
+    template<class KeyLike>
+    iterator LowerBound(const KeyLike& key)
+    {
+        Node* cur = Root();
+        Node* ret = &_header; // 没有满足条件的元素时返回end()
+        KeyOfT kot;
         while (cur)
         {
-            if (kot(cur->_data) < key) // 当前节点键值小于查找键值
+            if (_comp(kot(cur->_data), key))
             {
                 cur = cur->_right;
             }
-            else if (kot(cur->_data) > key) // 当前节点键值大于查找键值
+            else // cur是候选，往左找有没有更小的
+            {
+                ret = cur;
+                cur = cur->_left;
+            }
+        }
+        return iterator(ret);
+    }
+
+    // 第一个键值大于key的元素
+    template<class KeyLike>
+    iterator UpperBound(const KeyLike& key)
+    {
+        Node* cur = Root();
+        Node* ret = &_header; // 没有满足条件的元素时返回end()
+        KeyOfT kot;
+        while (cur)
+        {
+            if (_comp(key, kot(cur->_data)))
             {
+                ret = cur;
                 cur = cur->_left;
             }
-            else // 找到键值相等的节点
+            else
             {
-                return cur;
+                cur = cur->_right;
             }
         }
-        return nullptr; // 未找到
+        return iterator(ret);
+    }
+
+    // 键值等于key的区间[first, second)，key不存在时是一个空区间
+    template<class KeyLike>
+    pair<iterator, iterator> EqualRange(const KeyLike& key)
+    {
+        return make_pair(LowerBound(key), UpperBound(key));
+    }
+
+    // 删除操作：删除键值为key的节点，返回是否删除成功
+    bool Erase(const K& key)
+    {
+        iterator it = Find(key);
+        if (it == end())
+            return false;
+        EraseNode(it._node);
+        return true;
+    }
+
+    // 删除pos指向的节点，返回它的中序后继；其他节点只改链接不搬数据，指向它们的迭代器仍然有效
+    iterator Erase(const_iterator pos)
+    {
+        iterator next(pos._node);
+        ++next;
+        EraseNode(pos._node);
+        return next;
     }
 
     // 左单旋操作
@@ -386,10 +818,10 @@ public:
         subR->_left = parent;
         parent->_parent = subR;
         // 处理subR和原parent父节点的关系
-        if (_root == parent) // parent是根节点
+        if (Root() == parent) // parent是根节点
         {
-            _root = subR;
-            subR->_parent = nullptr;
+            Root() = subR;
+            subR->_parent = &_header;
         }
         else
         {
@@ -403,6 +835,14 @@ public:
             }
             subR->_parent = parentParent;
         }
+        // 只有parent和subR的子树变了：subR接管原来整棵子树，parent重新计算
+        subR->_subsize = parent->_subsize;
+        parent->_subsize = SubSize(parent->_left) + SubSize(parent->_right) + 1;
+        if constexpr (kAugmented)
+        {
+            subR->_agg = parent->_agg;
+            UpdateAggregate(parent);
+        }
     }
 
     // 右单旋操作
@@ -442,10 +882,10 @@ public:
         subL->_right = parent;
         parent->_parent = subL;
         // 处理subL和原parent父节点的关系
-        if (_root == parent) // parent是根节点
+        if (Root() == parent) // parent是根节点
         {
-            _root = subL;
-            subL->_parent = nullptr;
+            Root() = subL;
+            subL->_parent = &_header;
         }
         else
         {
@@ -459,28 +899,93 @@ public:
             }
             subL->_parent = parentParent;
         }
+        subL->_subsize = parent->_subsize;
+        parent->_subsize = SubSize(parent->_left) + SubSize(parent->_right) + 1;
+        if constexpr (kAugmented)
+        {
+            subL->_agg = parent->_agg;
+            UpdateAggregate(parent);
+        }
+    }
+
+    // 用严格递增的序列重建整棵树，O(n)，没有比较和旋转（输入无序或有重复时结果未定义）
+    template<class InputIterator>
+    void AssignSorted(InputIterator first, InputIterator last)
+    {
+        // 先把节点全部建好，中途构造失败时已建的节点能释放干净，原树也不受影响
+        vector<Node*> nodes;
+        try
+        {
+            for (; first != last; ++first)
+            {
+                nodes.push_back(CreateNode(*first));
+            }
+        }
+        catch (...)
+        {
+            for (Node* node : nodes)
+                DestroyNode(node);
+            throw;
+        }
+        Destroy(Root());
+        ResetHeader(BuildFromNodes(nodes));
+    }
+
+    // 把other中键值在本树里不存在的节点搬过来，重复的留在other里（同std::map::merge）
+    // 两棵树中序展开后线性归并，再各自重新建树：O(n + m)，节点直接复用，不分配也不拷贝元素
+    // 节点由对方的分配器分配，要求两边的分配器可以互相释放（无状态的分配器都满足）
+    void Merge(RBTree& other)
+    {
+        if (this == &other || other.Root() == nullptr)
+            return;
+        vector<Node*> mine = Flatten();
+        vector<Node*> theirs = other.Flatten();
+        vector<Node*> merged, left;
+        merged.reserve(mine.size() + theirs.size());
+        KeyOfT kot;
+        size_t i = 0, j = 0;
+        while (i < mine.size() && j < theirs.size())
+        {
+            if (_comp(kot(mine[i]->_data), kot(theirs[j]->_data)))
+            {
+                merged.push_back(mine[i++]);
+            }
+            else if (_comp(kot(theirs[j]->_data), kot(mine[i]->_data)))
+            {
+                merged.push_back(theirs[j++]);
+            }
+            else // 键值重复：保留本树的，对方的留在原处
+            {
+                merged.push_back(mine[i++]);
+                left.push_back(theirs[j++]);
+            }
+        }
+        merged.insert(merged.end(), mine.begin() + i, mine.end());
+        merged.insert(merged.end(), theirs.begin() + j, theirs.end());
+        ResetHeader(BuildFromNodes(merged));
+        other.ResetHeader(other.BuildFromNodes(left));
     }
 
     // 中序遍历打印（需要根据T类型调整打印方式）
     void InOrder()
     {
-        _InOrder(_root);
+        _InOrder(Root());
         cout << endl;
     }
 
     // 验证红黑树是否平衡
     bool IsBalance()
     {
-        if (_root == nullptr) // 空树是平衡的
+        if (Root() == nullptr) // 空树是平衡的
             return true;
-        if (_root->_col == RED) // 根节点必须是黑色
+        if (Root()->_col == RED) // 根节点必须是黑色
         {
             cout << "错误：根节点是红色的" << endl;
             return false;
         }
         // 计算参考值（任意一条路径的黑色节点数）
         int refVal = 0;
-        Node* cur = _root;
+        Node* cur = Root();
         while (cur)
         {
             if (cur->_col == BLACK)
@@ -490,23 +995,476 @@ public:
             cur = cur->_left;  // 一直向左走，计算最左路径的黑色节点数
         }
         int blacknum = 0;
-        return Check(_root, blacknum, refVal);
+        if (_header._left != Leftmost(Root()) || _header._right != Rightmost(Root()) || Root()->_parent != &_header)
+        {
+            cout << "错误：头节点记录的最小/最大节点不正确" << endl;
+            return false;
+        }
+        return Check(Root(), blacknum, refVal);
     }
 
     // 获取树的高度
     int Height()
     {
-        return _Height(_root);
+        return _Height(Root());
     }
 
-    // 获取节点个数
+    // 获取节点个数：根节点的子树大小，O(1)
     size_t Size()
     {
-        return _Size(_root);
+        return SubSize(Root());
+    }
+
+    // 排名：树中键值小于key的元素个数
+    template<class KeyLike>
+    size_t Rank(const KeyLike& key)
+    {
+        size_t rank = 0;
+        Node* cur = Root();
+        KeyOfT kot;
+        while (cur)
+        {
+            if (_comp(kot(cur->_data), key)) // cur和它的左子树都比key小
+            {
+                rank += SubSize(cur->_left) + 1;
+                cur = cur->_right;
+            }
+            else
+            {
+                cur = cur->_left;
+            }
+        }
+        return rank;
+    }
+
+    // 增强树：键值在[lo, hi)里的元素按中序合并的结果，空区间返回单位元，O(logN)
+    /*
+     * 先从根往下找到第一个落在区间里的节点split，lo和hi的查找路径在这里分开：
+     *   split左子树里往下找lo：节点>=lo时，它和它的右子树（都<split<hi）整体在区间里
+     *   split右子树里往下找hi：节点<hi时，它和它的左子树（都>split>=lo）整体在区间里
+     * 每边只走一条路径，合并时保持中序，combine不要求交换律
+     */
+    template<class KeyLike1, class KeyLike2>
+    auto Aggregate(const KeyLike1& lo, const KeyLike2& hi) requires kAugmented
+    {
+        KeyOfT kot;
+        Node* split = Root();
+        while (split)
+        {
+            if (_comp(kot(split->_data), lo))
+                split = split->_right;
+            else if (!_comp(kot(split->_data), hi))
+                split = split->_left;
+            else
+                break;
+        }
+        if (split == nullptr)
+            return Monoid::identity();
+        auto left = Monoid::identity();
+        for (Node* cur = split->_left; cur;)
+        {
+            if (!_comp(kot(cur->_data), lo))
+            {
+                left = Monoid::combine(Monoid::combine(Lift(cur), SubAggregate(cur->_right)), left);
+                cur = cur->_left;
+            }
+            else
+            {
+                cur = cur->_right;
+            }
+        }
+        auto right = Monoid::identity();
+        for (Node* cur = split->_right; cur;)
+        {
+            if (_comp(kot(cur->_data), hi))
+            {
+                right = Monoid::combine(right, Monoid::combine(SubAggregate(cur->_left), Lift(cur)));
+                cur = cur->_right;
+            }
+            else
+            {
+                cur = cur->_left;
+            }
+        }
+        return Monoid::combine(Monoid::combine(left, Lift(split)), right);
+    }
+
+    // 整棵树的聚合值，O(1)
+    auto Aggregate() requires kAugmented
+    {
+        return SubAggregate(Root());
+    }
+
+    // 用fn(T&)原地修改pos指向的元素（不能改键值），然后重算它到根这条路径上的聚合值，O(logN)
+    template<class Fn>
+    void Update(const_iterator pos, Fn&& fn)
+    {
+        fn(pos._node->_data);
+        Refresh(pos);
+    }
+
+    // 重算pos到根这条路径上的聚合值，O(logN)
+    void Refresh(const_iterator pos)
+    {
+        for (Node* p = pos._node; p != &_header; p = p->_parent)
+        {
+            UpdateAggregate(p);
+        }
+    }
+
+    // 第k小的元素（从0开始），k越界返回end()
+    iterator Select(size_t k)
+    {
+        Node* cur = Root();
+        while (cur)
+        {
+            size_t leftSize = SubSize(cur->_left);
+            if (k < leftSize)
+            {
+                cur = cur->_left;
+            }
+            else if (k == leftSize)
+            {
+                return iterator(cur);
+            }
+            else // 跳过左子树和cur自己
+            {
+                k -= leftSize + 1;
+                cur = cur->_right;
+            }
+        }
+        return end();
     }
 
 private:
-    Node* _root = nullptr; // 根节点指针
+    Node _header;  // 头节点：_parent是根，_left/_right是最小/最大节点，空树时_left/_right指向自己
+    [[no_unique_address]] NodeAlloc _alloc;
+    [[no_unique_address]] Compare _comp;    // 键值比较器
+
+    Node*& Root()
+    {
+        return _header._parent;
+    }
+
+    Node* Root() const
+    {
+        return _header._parent;
+    }
+
+    // 换上一棵新树（可以为空），重新记录根的父节点和最小/最大节点
+    void ResetHeader(Node* root)
+    {
+        _header._parent = root;
+        if (root)
+        {
+            root->_parent = &_header;
+            _header._left = Leftmost(root);
+            _header._right = Rightmost(root);
+        }
+        else
+        {
+            _header._left = _header._right = &_header;
+        }
+    }
+
+    // Swap之后头节点里是对方的链接，只修正根的父指针（空树时链接指回自己）
+    void FixHeader()
+    {
+        if (Root())
+            Root()->_parent = &_header;
+        else
+            _header._left = _header._right = &_header;
+    }
+
+    template<class... Args>
+    Node* CreateNode(Args&&... args)
+    {
+        Node* node = pzh::__AllocateNode(_alloc, std::in_place, std::forward<Args>(args)...);
+        UpdateAggregate(node);
+        return node;
+    }
+
+    void DestroyNode(Node* node)
+    {
+        node->_data.~T();
+        pzh::__DestroyNode(_alloc, node);
+    }
+
+    static size_t SubSize(Node* node)
+    {
+        return node ? node->_subsize : 0;
+    }
+
+    static auto Lift(Node* node) requires kAugmented
+    {
+        return Monoid::lift(__AugmentedValue(node->_data));
+    }
+
+    static auto SubAggregate(Node* node) requires kAugmented
+    {
+        return node ? node->_agg : Monoid::identity();
+    }
+
+    // 孩子的聚合值已经是对的，重算node自己的（不是增强树时什么都不做）
+    static void UpdateAggregate(Node* node)
+    {
+        if constexpr (kAugmented)
+        {
+            node->_agg = Monoid::combine(Monoid::combine(SubAggregate(node->_left), Lift(node)), SubAggregate(node->_right));
+        }
+    }
+
+    // 用v替换u在树中的位置（只改u父节点的链接，u自己的孩子不动）
+    void Transplant(Node* u, Node* v)
+    {
+        if (u == Root())
+            Root() = v;
+        else if (u == u->_parent->_left)
+            u->_parent->_left = v;
+        else
+            u->_parent->_right = v;
+        if (v)
+            v->_parent = u->_parent;
+    }
+
+    // 删除节点z
+    /*
+     * 1. z最多一个孩子：孩子直接顶替z
+     * 2. z有两个孩子：用右子树的最左节点y（中序后继）顶替z，y继承z的颜色，y原来的右孩子顶替y
+     * 真正从原位置消失的颜色是“被摘掉的节点”的颜色：
+     *   红色：黑色节点数不变，不用调整
+     *   黑色：顶替它的x所在路径少了一个黑色节点，从x开始向上调整
+     */
+    void EraseNode(Node* z)
+    {
+        UnlinkNode(z);
+        DestroyNode(z);
+    }
+
+    // 把z从树上摘下来并恢复平衡，z本身不释放（Extract交给节点句柄）
+    void UnlinkNode(Node* z)
+    {
+        Node* y = z;              // 从原位置摘掉的节点
+        Colour removedCol = y->_col;
+        Node* x = nullptr;        // 顶替y的节点，可能为空
+        Node* xParent = nullptr;  // x为空时没法通过x->_parent找父节点，单独记下来
+        // 删的是最小节点：它没有左孩子，新的最小节点是右子树的最左节点或者父节点（删光时就是header）
+        if (z == _header._left)
+            _header._left = z->_right ? Leftmost(z->_right) : z->_parent;
+        if (z == _header._right)
+            _header._right = z->_left ? Rightmost(z->_left) : z->_parent;
+        if (z->_left == nullptr)
+        {
+            x = z->_right;
+            xParent = z->_parent;
+            Transplant(z, z->_right);
+        }
+        else if (z->_right == nullptr)
+        {
+            x = z->_left;
+            xParent = z->_parent;
+            Transplant(z, z->_left);
+        }
+        else
+        {
+            y = z->_right;
+            while (y->_left)
+            {
+                y = y->_left;
+            }
+            removedCol = y->_col;
+            x = y->_right;
+            if (y->_parent == z)
+            {
+                xParent = y;
+            }
+            else
+            {
+                xParent = y->_parent;
+                Transplant(y, y->_right);
+                y->_right = z->_right;
+                y->_right->_parent = y;
+            }
+            Transplant(z, y);
+            y->_left = z->_left;
+            y->_left->_parent = y;
+            y->_col = z->_col;
+        }
+
+        // 结构发生变化的只有xParent到根这条路径（两个孩子的情况y也在这条路径上），逐个重算子树大小和聚合值
+        for (Node* p = xParent; p != &_header; p = p->_parent)
+        {
+            p->_subsize = SubSize(p->_left) + SubSize(p->_right) + 1;
+            UpdateAggregate(p);
+        }
+
+        if (removedCol == BLACK)
+            EraseFixup(x, xParent);
+    }
+
+    // x所在的路径少了一个黑色节点：x是红色直接染黑；否则看兄弟w
+    void EraseFixup(Node* x, Node* xParent)
+    {
+        while (x != Root() && (x == nullptr || x->_col == BLACK))
+        {
+            if (x == xParent->_left) // x是左孩子
+            {
+                Node* w = xParent->_right; // 兄弟节点，x这边少一个黑色，兄弟一定存在
+                // 情况1: 兄弟是红色：对父节点左旋，父红兄黑，转成兄弟是黑色的情况
+                if (w->_col == RED)
+                {
+                    w->_col = BLACK;
+                    xParent->_col = RED;
+                    RotateL(xParent);
+                    w = xParent->_right;
+                }
+                // 情况2: 兄弟黑色且两个孩子都是黑色：兄弟染红，两边都少一个黑色，问题上移到父节点
+                if ((w->_left == nullptr || w->_left->_col == BLACK)
+                    && (w->_right == nullptr || w->_right->_col == BLACK))
+                {
+                    w->_col = RED;
+                    x = xParent;
+                    xParent = x->_parent;
+                }
+                else
+                {
+                    // 情况3: 兄弟的右孩子黑、左孩子红：对兄弟右旋，转成情况4
+                    if (w->_right == nullptr || w->_right->_col == BLACK)
+                    {
+                        w->_left->_col = BLACK;
+                        w->_col = RED;
+                        RotateR(w);
+                        w = xParent->_right;
+                    }
+                    // 情况4: 兄弟的右孩子红：对父节点左旋，兄弟接替父节点的颜色，父节点和兄弟的右孩子染黑
+                    w->_col = xParent->_col;
+                    xParent->_col = BLACK;
+                    w->_right->_col = BLACK;
+                    RotateL(xParent);
+                    x = Root();
+                    break;
+                }
+            }
+            else // x是右孩子（对称情况）
+            {
+                Node* w = xParent->_left;
+                if (w->_col == RED)
+                {
+                    w->_col = BLACK;
+                    xParent->_col = RED;
+                    RotateR(xParent);
+                    w = xParent->_left;
+                }
+                if ((w->_left == nullptr || w->_left->_col == BLACK)
+                    && (w->_right == nullptr || w->_right->_col == BLACK))
+                {
+                    w->_col = RED;
+                    x = xParent;
+                    xParent = x->_parent;
+                }
+                else
+                {
+                    if (w->_left == nullptr || w->_left->_col == BLACK)
+                    {
+                        w->_right->_col = BLACK;
+                        w->_col = RED;
+                        RotateL(w);
+                        w = xParent->_left;
+                    }
+                    w->_col = xParent->_col;
+                    xParent->_col = BLACK;
+                    w->_left->_col = BLACK;
+                    RotateR(xParent);
+                    x = Root();
+                    break;
+                }
+            }
+        }
+        if (x)
+            x->_col = BLACK;
+    }
+
+    // 中序展开整棵树的节点
+    vector<Node*> Flatten()
+    {
+        vector<Node*> nodes;
+        nodes.reserve(Size());
+        for (iterator it = begin(); it != end(); ++it)
+        {
+            nodes.push_back(it._node);
+        }
+        return nodes;
+    }
+
+    static Node* Leftmost(Node* root)
+    {
+        while (root->_left)
+            root = root->_left;
+        return root;
+    }
+
+    static Node* Rightmost(Node* root)
+    {
+        while (root->_right)
+            root = root->_right;
+        return root;
+    }
+
+    // 用按键值排好序的节点搭一棵红黑树
+    /*
+     * 每次取中点作根，左右子树大小最多差1，所有空孩子的深度只有L和L+1两种（L = floor(log2(n+1))）：
+     *   深度0..L-1的层是满的，全部染黑；深度L的节点（最后一层不满的部分）染红
+     * 这样每条路径都恰好有L个黑色节点，红色节点都是叶子，不会出现连续红色
+     */
+    Node* BuildFromNodes(vector<Node*>& nodes)
+    {
+        size_t n = nodes.size();
+        size_t redDepth = 0;
+        while (((size_t)1 << (redDepth + 1)) - 1 <= n)
+        {
+            ++redDepth;
+        }
+        return Build(nodes.data(), n, 0, redDepth, &_header);
+    }
+
+    Node* Build(Node** nodes, size_t n, size_t depth, size_t redDepth, Node* parent)
+    {
+        if (n == 0)
+            return nullptr;
+        size_t mid = n / 2;
+        Node* root = nodes[mid];
+        root->_parent = parent;
+        root->_col = depth == redDepth ? RED : BLACK;
+        root->_subsize = n;
+        root->_left = Build(nodes, mid, depth + 1, redDepth, root);
+        root->_right = Build(nodes + mid + 1, n - mid - 1, depth + 1, redDepth, root);
+        UpdateAggregate(root);
+        return root;
+    }
+
+    // 后序释放整棵树
+    void Destroy(Node* root)
+    {
+        if (root == nullptr)
+            return;
+        Destroy(root->_left);
+        Destroy(root->_right);
+        DestroyNode(root);
+    }
+
+    Node* Copy(Node* root, Node* parent)
+    {
+        if (root == nullptr)
+            return nullptr;
+        Node* newRoot = CreateNode(root->_data);
+        newRoot->_col = root->_col;
+        newRoot->_subsize = root->_subsize;
+        newRoot->_parent = parent;
+        newRoot->_left = Copy(root->_left, newRoot);
+        newRoot->_right = Copy(root->_right, newRoot);
+        UpdateAggregate(newRoot);
+        return newRoot;
+    }
 
     // 递归中序遍历
     void _InOrder(Node* root)
@@ -543,6 +1501,31 @@ private:
             return false;
         }
 
+        // 删除时要改父指针，顺带检查父子链接是否一致
+        if ((root->_left && root->_left->_parent != root) || (root->_right && root->_right->_parent != root))
+        {
+            cout << "错误：父指针和孩子指针不一致" << endl;
+            return false;
+        }
+
+        if (root->_subsize != SubSize(root->_left) + SubSize(root->_right) + 1)
+        {
+            cout << "错误：子树大小不正确" << endl;
+            return false;
+        }
+
+        if constexpr (kAugmented)
+        {
+            if constexpr (std::equality_comparable<typename Monoid::value_type>)
+            {
+                if (!(root->_agg == Monoid::combine(Monoid::combine(SubAggregate(root->_left), Lift(root)), SubAggregate(root->_right))))
+                {
+                    cout << "错误：子树聚合值不正确" << endl;
+                    return false;
+                }
+            }
+        }
+
         // 统计黑色节点数
         if (root->_col == BLACK)
         {
@@ -563,13 +1546,68 @@ private:
         int rightHeight = _Height(root->_right);
         return leftHeight > rightHeight ? leftHeight + 1 : rightHeight + 1;
     }
+};
 
-    // 递归计算节点个数
-    size_t _Size(Node* root)
+namespace pzh
+{
+    // 构造函数的标记参数：表示给出的区间已经按键值严格递增，可以直接O(n)建树
+    struct sorted_unique_t
     {
-        if (root == nullptr)
-            return 0;
+        explicit sorted_unique_t() = default;
+    };
+    inline constexpr sorted_unique_t sorted_unique{};
 
-        return _Size(root->_left) + _Size(root->_right) + 1;
-    }
-};
\ No newline at end of file
+    // 选择红黑树作为map/set的底层
+    struct rb_tree_policy
+    {
+        template<class K, class T, class KeyOfT, class Compare, class Alloc>
+        using Tree = RBTree<K, T, KeyOfT, Compare, Alloc>;
+    };
+
+    // 带区间聚合的红黑树：pzh::map<K, V, Compare, Alloc, augmented_rb_tree_policy<sum_monoid<V>>>
+    // 之后map.aggregate(lo, hi)返回键在[lo, hi)里的value之和
+    template<class Monoid>
+    struct augmented_rb_tree_policy
+    {
+        template<class K, class T, class KeyOfT, class Compare, class Alloc>
+        using Tree = RBTree<K, T, KeyOfT, Compare, Alloc, Monoid>;
+    };
+
+    // 常用的幺半群：单位元identity()，单个元素lift(v)，满足结合律的combine(a, b)
+    template<class V>
+    struct sum_monoid
+    {
+        typedef V value_type;
+        static V identity() { return V(); }
+        static V lift(const V& v) { return v; }
+        static V combine(const V& a, const V& b) { return a + b; }
+    };
+
+    template<class V>
+    struct min_monoid
+    {
+        typedef V value_type;
+        static V identity() { return std::numeric_limits<V>::max(); }
+        static V lift(const V& v) { return v; }
+        static V combine(const V& a, const V& b) { return std::min(a, b); }
+    };
+
+    template<class V>
+    struct max_monoid
+    {
+        typedef V value_type;
+        static V identity() { return std::numeric_limits<V>::lowest(); }
+        static V lift(const V& v) { return v; }
+        static V combine(const V& a, const V& b) { return std::max(a, b); }
+    };
+
+    // 区间里的元素个数（和Rank(hi) - Rank(lo)一样，演示不看元素值的幺半群）
+    struct count_monoid
+    {
+        typedef size_t value_type;
+        static size_t identity() { return 0; }
+        template<class V>
+        static size_t lift(const V&) { return 1; }
+        static size_t combine(size_t a, size_t b) { return a + b; }
+    };
+}
@@ -2,11 +2,25 @@
 using namespace std;
 #include<vector>
 #include<string>
+#include<string_view>
+#include<functional>
 #include<ctime>
 #include<cstdlib>
+#include<set>
+#include<algorithm>
+#include<map>
+#include<thread>
+#include<mutex>
+#include<atomic>
+#include<chrono>
+#include<optional>
+#include"../Memory_management/PoolAllocator.h"
 #include"RBTree.h"
+#include"BPlusTree.h"
 #include"MyMap.h"
 #include"MySet.h"
+#include"PersistentMap.h"
+#include"ConcurrentMap.h"
 
 // ΪֱʹRBTreeº
 struct IntKeyOfT {
@@ -67,9 +81,9 @@ void test_RBTree_basic() {
         // Բҹ
         cout << "\nҲ: " << endl;
         for (auto e: a2) {
-            auto node = t2.Find(e);
-            if (node) {
-                cout << "ҵ " << e << ", Ӧֵ: " << node->_data.second << endl;
+            auto it = t2.Find(e);
+            if (it != t2.end()) {
+                cout << "ҵ " << e << ", Ӧֵ: " << it->second << endl;
             } else {
                 cout << "δҵ " << e << endl;
             }
@@ -77,7 +91,7 @@ void test_RBTree_basic() {
 
         // ԲڵԪ
         auto notFound = t2.Find(999);
-        if (!notFound) {
+        if (notFound == t2.end()) {
             cout << "δҵ 999 (ȷ)" << endl;
         }
     }
@@ -408,6 +422,1217 @@ void test_RBTree_balance() {
     }
 }
 
+// /ɾstd::setģÿ޸ĺ󶼼
+void test_RBTree_erase() {
+    cout << "\n========== ԺɾͷΧѯ ==========" << endl;
+    bool ok = true;
+    {
+        RBTree<int, int, IntKeyOfT> t;
+        std::set<int> ref;
+        srand(time(0));
+        for (int i = 0; i < 20000 && ok; i++) {
+            int x = rand() % 1000;
+            if (rand() % 2) {
+                ok = t.Insert(x).second == ref.insert(x).second;
+            } else {
+                ok = t.Erase(x) == (ref.erase(x) == 1);
+            }
+            ok = ok && t.IsBalance();
+            // ÿһȶһݺͱ߽ѯ
+            if (i % 500 == 0) {
+                ok = ok && t.Size() == ref.size() && equal(ref.begin(), ref.end(), t.begin());
+                for (int k = -1; k <= 1000 && ok; k++) {
+                    auto lb = t.LowerBound(k);
+                    auto ub = t.UpperBound(k);
+                    auto rlb = ref.lower_bound(k);
+                    auto rub = ref.upper_bound(k);
+                    ok = (rlb == ref.end() ? lb == t.end() : (lb != t.end() && *lb == *rlb))
+                         && (rub == ref.end() ? ub == t.end() : (ub != t.end() && *ub == *rub))
+                         && (t.Find(k) != t.end()) == (ref.count(k) == 1);
+                }
+            }
+        }
+        // ɾ
+        while (ok && !ref.empty()) {
+            int x = *ref.begin();
+            ref.erase(ref.begin());
+            ok = t.Erase(x) && t.IsBalance();
+        }
+        ok = ok && t.begin() == t.end() && t.Size() == 0;
+        cout << "/ɾ: " << (ok ? "ok" : "error") << endl;
+    }
+    {
+        // ߱ɾerase(iterator)һλ
+        pzh::map<int, int> m;
+        for (int i = 0; i < 1000; i++) {
+            m[i] = i * 10;
+        }
+        for (auto it = m.begin(); it != m.end();) {
+            if (it->first % 2 == 0)
+                it = m.erase(it);
+            else
+                ++it;
+        }
+        int expect = 1;
+        for (auto &kv: m) {
+            ok = ok && kv.first == expect && kv.second == expect * 10;
+            expect += 2;
+        }
+        ok = ok && expect == 1001 && m.count(10) == 0 && m.count(11) == 1 && m.erase(11) == 1 && m.erase(11) == 0;
+
+        // [100, 200)ڵԪ
+        int n = 0;
+        for (auto it = m.lower_bound(100); it != m.lower_bound(200); ++it) {
+            n++;
+        }
+        auto range = m.equal_range(13);
+        auto empty = m.equal_range(14);
+        ok = ok && n == 50 && range.first->first == 13 && range.second->first == 15 && empty.first == empty.second
+             && m.upper_bound(997)->first == 999 && m.upper_bound(999) == m.end() && m.find(500) == m.end();
+        cout << "mapfind/erase/count/bound: " << (ok ? "ok" : "error") << endl;
+    }
+}
+
+// ѯrank/selectźģɾ֮СҲҪȷ
+void test_RBTree_rank() {
+    cout << "\n========== Ժѯ ==========" << endl;
+    bool ok = true;
+    pzh::set<int> s;
+    std::set<int> ref;
+    srand(time(0));
+    for (int i = 0; i < 5000; i++) {
+        int x = rand() % 10000;
+        s.insert(x);
+        ref.insert(x);
+    }
+    for (int i = 0; i < 2000; i++) {
+        int x = rand() % 10000;
+        ok = ok && s.erase(x) == ref.erase(x);
+    }
+    vector<int> sorted(ref.begin(), ref.end());
+    ok = ok && s.size() == sorted.size();
+    for (size_t k = 0; k < sorted.size() && ok; k++) {
+        ok = *s.select(k) == sorted[k] && s.rank(sorted[k]) == k;
+    }
+    for (int x = -1; x <= 10000 && ok; x++) {
+        ok = s.rank(x) == (size_t)(lower_bound(sorted.begin(), sorted.end(), x) - sorted.begin());
+    }
+    ok = ok && s.select(sorted.size()) == s.end();
+    cout << "rank/select: " << (ok ? "ok" : "error") << endl;
+
+    // ٷλͷҳ
+    pzh::map<int, string> scores;
+    for (int i = 1; i <= 100; i++) {
+        scores[i * 7 % 101] = "user" + to_string(i);
+    }
+    size_t n = scores.size();
+    auto p90 = scores.select(n * 90 / 100);
+    cout << " " << n << " 90λ: " << p90->first << " (" << p90->second << ")" << endl;
+    cout << "3ҳ(ÿҳ10): ";
+    auto it = scores.select(20);
+    for (int i = 0; i < 10 && it != scores.end(); i++, ++it) {
+        cout << it->first << " ";
+    }
+    cout << endl;
+    cout << "50ڵ " << scores.rank(50) + 1 << " " << endl;
+}
+
+// ַƴӣ㽻ɣۺǰϲ
+struct ConcatMonoid {
+    typedef string value_type;
+    static string identity() { return string(); }
+    static string lift(const string& v) { return v; }
+    static string combine(const string& a, const string& b) { return a + b; }
+};
+
+template<class Map>
+concept HasSubscript = requires(Map& m) { m[0]; };
+
+// ۺϣstd::mapɨĽ
+void test_RBTree_aggregate() {
+    cout << "\n========== Ժۺ ==========" << endl;
+    typedef pzh::map<int, long long, std::less<>, std::allocator<pair<int, long long>>,
+                     pzh::augmented_rb_tree_policy<pzh::sum_monoid<long long>>> SumMap;
+    typedef pzh::map<int, long long, std::less<>, std::allocator<pair<int, long long>>,
+                     pzh::augmented_rb_tree_policy<pzh::min_monoid<long long>>> MinMap;
+    bool ok = true;
+    SumMap sum;
+    MinMap mn;
+    std::map<int, long long> ref;
+    srand(2024);
+    for (int i = 0; i < 20000; i++) {
+        int key = rand() % 3000;
+        long long value = rand() % 1000 - 500;
+        switch (rand() % 5) {
+        case 0:
+            ok = ok && sum.erase(key) == ref.erase(key);
+            mn.erase(key);
+            break;
+        case 1: {
+            // ժvalueٲȥ
+            auto nh = sum.extract(key);
+            if (nh) {
+                nh.mapped() = value;
+                sum.insert(std::move(nh));
+                ref[key] = value;
+                mn.insert_or_assign(key, value);
+            }
+            break;
+        }
+        case 2: {
+            // updateԭظvalueۺֵͬʱ
+            if (!sum.update(key, [&](long long& v) { v += value; })) {
+                sum.insert(make_pair(key, value));
+            }
+            ref[key] += value;
+            mn.insert_or_assign(key, ref[key]);
+            break;
+        }
+        default:
+            sum.insert_or_assign(key, value);
+            mn.insert_or_assign(key, value);
+            ref[key] = value;
+            break;
+        }
+    }
+    ok = ok && sum.size() == ref.size() && mn.size() == ref.size();
+    for (int i = 0; i < 2000 && ok; i++) {
+        int lo = rand() % 3200 - 100;
+        int hi = lo + rand() % 500;
+        long long s = 0, m = std::numeric_limits<long long>::max();
+        for (auto it = ref.lower_bound(lo); it != ref.end() && it->first < hi; ++it) {
+            s += it->second;
+            m = min(m, it->second);
+        }
+        ok = sum.aggregate(lo, hi) == s && mn.aggregate(lo, hi) == m;
+    }
+    long long total = 0;
+    for (auto& kv : ref) {
+        total += kv.second;
+    }
+    ok = ok && sum.aggregate() == total;
+
+    // ǿƹۺֵvalueûoperator[]ֻ
+    static_assert(!HasSubscript<SumMap> && HasSubscript<pzh::map<int, long long>>);
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(*sum.begin())>>);
+    static_assert(std::is_const_v<std::remove_reference_t<decltype(*sum.find(0))>>);
+    SumMap small;
+    for (int i = 0; i < 10; i++) {
+        small.insert(make_pair(i, 1LL));
+    }
+    small.update(3, [](long long& v) { v += 100; });
+    small.insert_or_assign(7, 50LL);
+    ok = ok && !small.update(42, [](long long& v) { v = 0; }) && small.aggregate() == 8 + 101 + 50
+        && small.aggregate(3, 4) == 101 && small.aggregate(4, 8) == 1 + 1 + 1 + 50;
+    // ͨmapupdateinsert_or_assignֱӸvalue
+    pzh::map<int, int> plain;
+    plain[1] = 1;
+    plain.update(1, [](int& v) { v *= 10; });
+    plain.insert_or_assign(2, 20);
+    ok = ok && plain[1] == 10 && plain[2] == 20;
+
+    // ϲ֮ۺֵҲҪȷ
+    SumMap copy(sum);
+    vector<pair<int, long long>> sorted;
+    for (int i = 0; i < 1000; i++) {
+        sorted.push_back(make_pair(i * 2, (long long)i));
+    }
+    SumMap bulk(pzh::sorted_unique, sorted.begin(), sorted.end());
+    SumMap odd;
+    for (int i = 0; i < 1000; i++) {
+        odd.insert(make_pair(i * 2 + 1, 1LL));
+    }
+    bulk.merge(odd);
+    ok = ok && copy.aggregate(-100, 4000) == total && bulk.aggregate(0, 2000) == 999LL * 1000 / 2 + 1000
+        && bulk.aggregate(10, 20) == 5 + 6 + 7 + 8 + 9 + 5;
+    // ɾеתҪάۺֵIsBalanceڵ
+    RBTree<int, pair<int, int>, PairIntKeyOfT, std::less<>, std::allocator<pair<int, int>>, pzh::sum_monoid<int>> t;
+    for (int i = 0; i < 5000 && ok; i++) {
+        int key = rand() % 1000;
+        if (rand() % 3 == 0) {
+            t.Erase(key);
+        } else {
+            t.Insert(make_pair(key, key));
+        }
+        if (i % 500 == 0) {
+            ok = t.IsBalance();
+        }
+    }
+    ok = ok && t.IsBalance();
+    cout << "sum/minۺ϶: " << (ok ? "ok" : "error") << endl;
+
+    // 㽻ɵ۰ȺҪ˳ƴ
+    pzh::map<int, string, std::less<>, std::allocator<pair<int, string>>,
+             pzh::augmented_rb_tree_policy<ConcatMonoid>> words;
+    string letters = "thequickbrownfoxjumpsoverthelazydog";
+    for (int i = (int)letters.size() - 1; i >= 0; i--) {
+        words.insert(make_pair(i, string(1, letters[i])));
+    }
+    bool concatOk = words.aggregate(3, 8) == "quick" && words.aggregate() == letters && words.aggregate(9, 9).empty();
+    pzh::set<int, std::less<>, std::allocator<int>, pzh::augmented_rb_tree_policy<pzh::count_monoid>> counted;
+    for (int i = 0; i < 100; i++) {
+        counted.insert(i * 3);
+    }
+    concatOk = concatOk && counted.rank(150) == 50;
+    cout << "ϲ: " << (concatOk ? "ok" : "error") << endl;
+
+    // ʱ䴰ͣۺO(logN) vs std::mapɨ贰
+    const int n = 1000000, window = 10000, queries = 2000;
+    SumMap metrics;
+    std::map<int, long long> scan;
+    for (int t = 0; t < n; t++) {
+        metrics.insert(make_pair(t, (long long)(t % 97)));
+        scan.insert(make_pair(t, (long long)(t % 97)));
+    }
+    vector<int> starts(queries);
+    for (auto& st : starts) {
+        st = rand() % (n - window);
+    }
+    long long a = 0, b = 0;
+    clock_t begin = clock();
+    for (int st : starts) {
+        a += metrics.aggregate(st, st + window);
+    }
+    clock_t mid = clock();
+    for (int st : starts) {
+        for (auto it = scan.lower_bound(st); it != scan.end() && it->first < st + window; ++it) {
+            b += it->second;
+        }
+    }
+    clock_t end = clock();
+    cout << queries << "δ(" << window << ") aggregate: " << mid - begin
+         << "  std::mapɨ: " << end - mid << (a == b ? "" : " error") << endl;
+}
+
+// ֱӽԺϲȽϺʱ
+void test_RBTree_bulk_load() {
+    cout << "\n========== Ժͺϲ ==========" << endl;
+    bool ok = true;
+    // ִСı߽磩Ҫ
+    for (int n = 0; n <= 300 && ok; n++) {
+        vector<pair<int, int>> v;
+        for (int i = 0; i < n; i++) {
+            v.push_back(make_pair(i * 2, i));
+        }
+        pzh::map<int, int> m(pzh::sorted_unique, v.begin(), v.end());
+        ok = m.size() == (size_t)n && (n == 0 || (m.select(n / 2)->first == n / 2 * 2 && m.find(n * 2 - 2)->second == n - 1));
+        m[-1] = 0;  // õɾ
+        ok = ok && m.size() == (size_t)n + 1 && m.erase(-1) == 1 && m.size() == (size_t)n;
+
+        vector<int> keys;
+        for (auto &kv: v) {
+            keys.push_back(kv.first);
+        }
+        RBTree<int, int, IntKeyOfT> t;
+        t.AssignSorted(keys.begin(), keys.end());
+        ok = ok && t.IsBalance() && t.Size() == (size_t)n;
+    }
+    {
+        // 3ıϲظ6ıڶԷ
+        pzh::set<int> a, b;
+        vector<int> odd, three;
+        for (int i = 0; i < 3000; i++) {
+            if (i % 2)
+                odd.push_back(i);
+            if (i % 3 == 0)
+                three.push_back(i);
+        }
+        a.assign_sorted(odd.begin(), odd.end());
+        b.assign_sorted(three.begin(), three.end());
+        a.merge(b);
+        std::set<int> ref(odd.begin(), odd.end());
+        ref.insert(three.begin(), three.end());
+        ok = ok && a.size() == ref.size() && equal(ref.begin(), ref.end(), a.begin());
+        size_t dup = 0;
+        for (auto e: b) {
+            ok = ok && e % 2 == 1 && e % 3 == 0;
+            dup++;
+        }
+        ok = ok && dup == b.size() && dup == 500;
+        a.insert(-5);
+        ok = ok && a.erase(3) == 1 && a.count(-5) == 1 && *a.select(0) == -5;
+    }
+    cout << "/ϲ: " << (ok ? "ok" : "error") << endl;
+
+    // ֱRBTree
+    {
+        vector<int> v;
+        for (int i = 0; i < 1000; i++) {
+            v.push_back(i);
+        }
+        RBTree<int, int, IntKeyOfT> t, t2;
+        t.AssignSorted(v.begin(), v.end());
+        vector<int> w;
+        for (int i = 500; i < 1500; i++) {
+            w.push_back(i);
+        }
+        t2.AssignSorted(w.begin(), w.end());
+        t.Merge(t2);
+        cout << "Ƿƽ: " << t.IsBalance() << "ϲڵ: " << t.Size() << "ʣ: " << t2.Size()
+             << "ʣǷƽ: " << t2.IsBalance() << endl;
+    }
+
+    const int N = 1000000;
+    vector<pair<int, int>> sorted;
+    sorted.reserve(N);
+    for (int i = 0; i < N; i++) {
+        sorted.push_back(make_pair(i * 3, i));
+    }
+    size_t begin = clock();
+    {
+        pzh::map<int, int> m;
+        for (auto &kv: sorted) {
+            m.insert(kv);
+        }
+    }
+    size_t insertTime = clock() - begin;
+    begin = clock();
+    {
+        pzh::map<int, int> m(pzh::sorted_unique, sorted.begin(), sorted.end());
+    }
+    size_t buildTime = clock() - begin;
+    cout << N << " Ԫأ+ " << insertTime << "+ " << buildTime << endl;
+
+    // 50Ԫءֵmapϲ
+    vector<pair<int, int>> even, odd;
+    for (int i = 0; i < N; i++) {
+        (i % 2 ? odd : even).push_back(make_pair(i, i));
+    }
+    pzh::map<int, int> a1(pzh::sorted_unique, even.begin(), even.end()), b1(pzh::sorted_unique, odd.begin(), odd.end());
+    pzh::map<int, int> a2(pzh::sorted_unique, even.begin(), even.end()), b2(pzh::sorted_unique, odd.begin(), odd.end());
+    begin = clock();
+    for (auto &kv: b1) {
+        a1.insert(kv);
+    }
+    size_t loopTime = clock() - begin;
+    begin = clock();
+    a2.merge(b2);
+    size_t mergeTime = clock() - begin;
+    cout << "ϲ " << N / 2 << " Ԫصmap " << loopTime << "merge " << mergeTime
+         << "  (" << a1.size() << " / " << a2.size() << ")" << endl;
+}
+
+// ͷڵ㣺end()ߡconst
+void test_RBTree_header() {
+    cout << "\n========== Ժͷڵͷ ==========" << endl;
+    bool ok = true;
+    pzh::map<int, int> m;
+    ok = ok && m.begin() == m.end() && m.rbegin() == m.rend();
+    for (int i = 0; i < 100; i++) {
+        m[i * 7 % 100] = i;
+    }
+    // end()
+    auto it = m.end();
+    int expect = 99;
+    while (it != m.begin()) {
+        --it;
+        ok = ok && it->first == expect--;
+    }
+    ok = ok && expect == -1;
+
+    // 
+    cout << "ǰ5: ";
+    int n = 0;
+    for (auto rit = m.rbegin(); rit != m.rend(); ++rit, ++n) {
+        if (n < 5)
+            cout << rit->first << " ";
+        ok = ok && rit->first == 99 - n;
+    }
+    cout << endl;
+    ok = ok && n == 100;
+
+    // ɾС/Ԫغbegin()rbegin()ű
+    m.erase(0);
+    m.erase(99);
+    ok = ok && m.begin()->first == 1 && m.rbegin()->first == 98 && (--m.end())->first == 98;
+
+    // constֻõconst
+    const pzh::map<int, int> &cm = m;
+    int sum = 0;
+    for (pzh::map<int, int>::const_iterator cit = cm.begin(); cit != cm.end(); ++cit) {
+        sum += cit->first;
+        // cit->second = 0;  // const޸Ԫ
+    }
+    ok = ok && sum == 4950 - 99;
+    pzh::map<int, int>::const_iterator fromMutable = m.find(50);  // ͨתconst
+    ok = ok && fromMutable->first == 50;
+
+    // setĵconst
+    pzh::set<int> s;
+    for (int i = 10; i > 0; i--) {
+        s.insert(i);
+    }
+    int prev = 11;
+    for (auto rit = s.rbegin(); rit != s.rend(); ++rit) {
+        ok = ok && *rit == prev - 1;
+        prev = *rit;
+    }
+    s.erase(s.begin());
+    ok = ok && *s.begin() == 2 && *s.rbegin() == 10;
+
+    // ֻһڵ㡢֮
+    pzh::map<int, int> one, other;
+    one[1] = 1;
+    ok = ok && ++one.begin() == one.end() && --one.end() == one.begin();
+    swap(one, other);
+    ok = ok && one.size() == 0 && one.begin() == one.end() && other.begin()->first == 1 && --other.end() == other.begin();
+    cout << "ͷڵ/: " << (ok ? "ok" : "error") << endl;
+}
+
+// ͳƱȽϴıȽis_transparentstringconst char*/string_viewȽ
+size_t g_compareCount = 0;
+
+struct CountingLess {
+    typedef void is_transparent;
+
+    template<class A, class B>
+    bool operator()(const A &a, const B &b) const {
+        ++g_compareCount;
+        return string_view(a) < string_view(b);
+    }
+};
+
+// ԶȽ칹
+void test_RBTree_compare() {
+    cout << "\n========== ԱȽ칹 ==========" << endl;
+    bool ok = true;
+
+    // map
+    pzh::map<int, int, greater<>> desc;
+    for (int i = 0; i < 10; i++) {
+        desc[i] = i;
+    }
+    int expect = 9;
+    for (auto &kv: desc) {
+        ok = ok && kv.first == expect--;
+    }
+    ok = ok && desc.lower_bound(5)->first == 5 && desc.upper_bound(5)->first == 4 && desc.erase(3) == 1;
+
+    // stringΪkeyֱconst char*/string_viewңstring
+    pzh::map<string, int> dict;
+    dict["apple"] = 1;
+    dict["banana"] = 2;
+    dict["cherry"] = 3;
+    string_view sv = "banana-split";
+    ok = ok && dict.find("apple")->second == 1 && dict.find(sv.substr(0, 6))->second == 2
+         && dict.count("durian") == 0 && dict.lower_bound("b")->first == "banana";
+
+    // ÿֻȽһΣҵıȽϴԼ+1
+    pzh::map<string, int, CountingLess> words;
+    const int N = 100000;
+    vector<string> keys;
+    for (int i = 0; i < N; i++) {
+        keys.push_back("key" + to_string(i * 7919 % N));
+        words[keys.back()] = i;
+    }
+    g_compareCount = 0;
+    for (auto &k: keys) {
+        ok = ok && words.find(k.c_str()) != words.end();
+    }
+    double perFind = (double)g_compareCount / N;
+    g_compareCount = 0;
+    for (auto &k: keys) {
+        words.insert(make_pair(k, 0));  // ȫѴ
+    }
+    double perInsert = (double)g_compareCount / N;
+    cout << N << " keyƽÿβұȽ " << perFind << " ΣÿظȽ " << perInsert << " " << endl;
+
+    // B+ײҲ֧ԶȽ
+    pzh::set<int, greater<>, allocator<int>, pzh::bplus_tree_policy> bs;
+    for (int i = 0; i < 1000; i++) {
+        bs.insert(i);
+    }
+    ok = ok && *bs.begin() == 999 && *bs.rbegin() == 0 && bs.count(500) == 1 && *bs.lower_bound(500) == 500;
+    cout << "Ƚ/칹Ҽ: " << (ok ? "ok" : "error") << endl;
+}
+
+// ¼/ƶvalue
+struct Tracked {
+    static size_t copies;
+    static size_t moves;
+    vector<int> payload;
+
+    Tracked() = default;
+
+    explicit Tracked(size_t n) : payload(n, 1) {}
+
+    Tracked(const Tracked &t) : payload(t.payload) { ++copies; }
+
+    Tracked(Tracked &&t) noexcept : payload(std::move(t.payload)) { ++moves; }
+
+    Tracked &operator=(const Tracked &t) {
+        payload = t.payload;
+        ++copies;
+        return *this;
+    }
+
+    Tracked &operator=(Tracked &&t) noexcept {
+        payload = std::move(t.payload);
+        ++moves;
+        return *this;
+    }
+};
+
+size_t Tracked::copies = 0;
+size_t Tracked::moves = 0;
+
+// ¼ķ
+size_t g_allocCount = 0;
+
+template<class T>
+struct CountingAllocator {
+    typedef T value_type;
+
+    CountingAllocator() = default;
+
+    template<class U>
+    CountingAllocator(const CountingAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        ++g_allocCount;
+        return allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, size_t n) {
+        allocator<T>().deallocate(p, n);
+    }
+
+    template<class U>
+    bool operator==(const CountingAllocator<U> &) const { return true; }
+};
+
+// ״̬ķÿʵֻԼļڵҪǽķͷţߵļز0
+template<class T>
+struct LiveCountAllocator {
+    typedef T value_type;
+
+    explicit LiveCountAllocator(long *live) : _live(live) {}
+
+    template<class U>
+    LiveCountAllocator(const LiveCountAllocator<U> &a) : _live(a._live) {}
+
+    T *allocate(size_t n) {
+        ++*_live;
+        return allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *p, size_t n) {
+        --*_live;
+        allocator<T>().deallocate(p, n);
+    }
+
+    template<class U>
+    bool operator==(const LiveCountAllocator<U> &a) const { return _live == a._live; }
+
+    long *_live;
+};
+
+// ƶ塢emplace/try_emplaceͽڵ
+void test_RBTree_move() {
+    cout << "\n========== ƶͽڵ ==========" << endl;
+    bool ok = true;
+    typedef pzh::map<string, Tracked, less<>, CountingAllocator<pair<string, Tracked>>> TrackedMap;
+    TrackedMap m;
+
+    // ֵ룺valueֻƶ
+    Tracked::copies = Tracked::moves = 0;
+    m.insert(make_pair(string("a"), Tracked(100)));
+    m.emplace("b", Tracked(100));
+    m.try_emplace("c", 100);
+    ok = ok && Tracked::copies == 0 && m.size() == 3 && m.find("c")->second.payload.size() == 100;
+
+    // keyѴʱoperator[]try_emplacevalueҲڵ
+    Tracked::copies = Tracked::moves = 0;
+    g_allocCount = 0;
+    Tracked big(100);
+    m["a"].payload.push_back(2);
+    ok = ok && !m.try_emplace("a", std::move(big)).second && big.payload.size() == 100;
+    ok = ok && Tracked::copies == 0 && Tracked::moves == 0 && g_allocCount == 0;
+
+    // extract + insertڵmap֮ң㿽䣬˳key
+    TrackedMap other;
+    Tracked::copies = Tracked::moves = 0;
+    g_allocCount = 0;
+    auto nh = m.extract("a");
+    ok = ok && !nh.empty() && nh.key() == "a" && nh.mapped().payload.size() == 101 && m.size() == 2;
+    nh.key() = "z";
+    auto ret = other.insert(std::move(nh));
+    ok = ok && ret.inserted && ret.position->first == "z" && nh.empty();
+    auto dup = other.insert(m.extract(m.begin()));  // "b"嵽other
+    other["b"];
+    auto back = m.insert(other.extract("b"));
+    ok = ok && dup.inserted && back.inserted && m.size() == 2 && other.size() == 1;
+    ok = ok && Tracked::copies == 0 && Tracked::moves == 0 && g_allocCount == 0;
+
+    // keyͻʱڵԭʱͷŽڵ
+    m["z"];
+    auto fail = m.insert(other.extract("z"));
+    ok = ok && !fail.inserted && !fail.node.empty() && fail.node.key() == "z" && fail.position->second.payload.empty();
+    ok = ok && m.extract("nothing").empty() && other.size() == 0;
+
+    // setҲժڵ
+    pzh::set<string> s1, s2;
+    s1.emplace(3, 'x');
+    s1.insert(string("yy"));
+    auto sh = s1.extract(s1.begin());
+    ok = ok && sh.value() == "xxx" && s2.insert(std::move(sh)).inserted && s1.size() == 1 && *s2.begin() == "xxx";
+
+    // B+ײ㣺ûнڵֵ/try_emplaceͬvalue
+    pzh::map<int, Tracked, less<>, allocator<pair<int, Tracked>>, pzh::bplus_tree_policy> bm;
+    Tracked::copies = 0;
+    for (int i = 0; i < 1000; i++) {
+        bm.try_emplace(i, 10);
+        bm[i].payload.push_back(i);
+        bm.insert(make_pair(i + 1000, Tracked(10)));
+    }
+    ok = ok && Tracked::copies == 0 && bm.size() == 2000 && bm[999].payload.size() == 11;
+
+    // ܶԱȣvaluemap֮ң+ɾ vs extract/insert
+    const int N = 20000;
+    pzh::map<int, vector<int>> from, to;
+    for (int i = 0; i < N; i++) {
+        from.try_emplace(i, 256, i);
+    }
+    size_t begin = clock();
+    for (int i = 0; i < N; i++) {
+        auto it = from.find(i);
+        to.insert(*it);
+        from.erase(it);
+    }
+    size_t copyTime = clock() - begin;
+    begin = clock();
+    for (int i = 0; i < N; i++) {
+        from.insert(to.extract(i));
+    }
+    size_t extractTime = clock() - begin;
+    ok = ok && from.size() == N && to.size() == 0 && from.find(N - 1)->second[255] == N - 1;
+    cout << N << " value(256int): +ɾʱ " << copyTime << "extract/insertʱ " << extractTime << endl;
+    cout << "ƶ/ڵ: " << (ok ? "ok" : "error") << endl;
+}
+
+// ־ûmapջӰ졢ս̶߳պÿ޸ĸƵĽڵ
+void test_persistent_map() {
+    cout << "\n========== Գ־ûmap ==========" << endl;
+    bool ok = true;
+    typedef pzh::persistent_map<int, int, less<>, CountingAllocator<pair<int, int>>> PMap;
+
+    // ޸ģ;ĿգÿնҪʱstd::mapһ
+    PMap m;
+    map<int, int> ref;
+    vector<PMap> snaps;
+    vector<map<int, int>> refSnaps;
+    srand(2024);
+    for (int i = 0; i < 30000; i++) {
+        int key = rand() % 3000;
+        int op = rand() % 4;
+        if (op == 0) {
+            ok = ok && m.erase(key) == ref.erase(key);
+        } else if (op == 1) {
+            m[key] += i;
+            ref[key] += i;
+        } else {
+            ok = ok && m.insert_or_assign(key, i) == (ref.count(key) == 0);
+            ref[key] = i;
+        }
+        if (i % 3000 == 0) {
+            snaps.push_back(m.snapshot());
+            refSnaps.push_back(ref);
+        }
+    }
+    snaps.push_back(m);
+    refSnaps.push_back(ref);
+    for (size_t i = 0; i < snaps.size(); i++) {
+        ok = ok && snaps[i].IsValid() && snaps[i].size() == refSnaps[i].size();
+        auto rit = refSnaps[i].begin();
+        for (auto &kv: snaps[i]) {
+            ok = ok && kv.first == rit->first && kv.second == rit->second;
+            ++rit;
+        }
+    }
+    auto fit = m.find(ref.begin()->first);
+    ok = ok && fit != m.end() && fit->second == ref.begin()->second && m.find(-1) == m.end();
+    snaps.clear();
+
+    // ֵ֮ڵŷһ𻻹ʱɷǵǸͷ
+    {
+        typedef pzh::persistent_map<int, int, less<>, LiveCountAllocator<pair<int, int>>> LMap;
+        long liveA = 0, liveB = 0;
+        {
+            LMap a{less<>(), LiveCountAllocator<pair<int, int>>(&liveA)};
+            LMap b{less<>(), LiveCountAllocator<pair<int, int>>(&liveB)};
+            for (int i = 0; i < 100; i++) {
+                a[i] = i;
+                b[-i] = i;
+            }
+            a = b;
+            a[1000] = 1;
+            ok = ok && a.size() == 101 && b.size() == 100;
+        }
+        ok = ok && liveA == 0 && liveB == 0;
+    }
+
+    // д̲߳ͣ޸ģ̱߳գʼĿһ̵
+    const int N = 1000000;
+    PMap big;
+    for (int i = 0; i < N; i++) {
+        big.insert(make_pair(i, 1));
+    }
+    PMap snap = big.snapshot();
+    long long readerSum = 0;
+    thread reader([&snap, &readerSum]() {
+        for (int round = 0; round < 5; round++) {
+            for (auto &kv: snap) {
+                readerSum += kv.second;
+            }
+        }
+    });
+    for (int i = 0; i < 200000; i++) {
+        big[rand() % N] += 1;
+        big.erase(rand() % N);
+    }
+    reader.join();
+    ok = ok && readerSum == 5LL * N && snap.size() == (size_t)N && big.IsValid() && snap.IsValid();
+
+    // ûпʱ޸ԭصģ䣻пʱÿ޸ֻ·ϵO(logN)ڵ
+    PMap owned;
+    for (int i = 0; i < N; i++) {
+        owned.insert(make_pair(i, i));
+    }
+    const int M = 10000;
+    g_allocCount = 0;
+    for (int i = 0; i < M; i++) {
+        owned[rand() % N] += 1;
+    }
+    size_t noSnapAllocs = g_allocCount;
+
+    size_t begin = clock();
+    vector<PMap> history;
+    for (int i = 0; i < M; i++) {
+        history.push_back(owned.snapshot());
+        owned[rand() % N] += 1;
+    }
+    size_t snapTime = clock() - begin;
+    size_t pathAllocs = g_allocCount - noSnapAllocs;
+    history.clear();
+
+    // Աȣÿζһpzh::map
+    pzh::map<int, int> full;
+    for (int i = 0; i < N; i++) {
+        full[i] = i;
+    }
+    begin = clock();
+    pzh::map<int, int> fullCopy(full);
+    size_t copyTime = clock() - begin;
+
+    cout << N << " Ԫأ" << M << " \"+޸\"ʱ " << snapTime << "һpzh::mapʱ " << copyTime << endl;
+    cout << "޿ʱ޸ķڵ " << noSnapAllocs << " пʱÿ޸ƽ " << (double)pathAllocs / M
+         << " ڵ㣨" << (double)pathAllocs / M * (sizeof(int) * 2 + sizeof(void *) * 2 + 8) << " ֽڣҪ "
+         << fullCopy.size() << " " << endl;
+    ok = ok && noSnapAllocs == 0 && pathAllocs <= (size_t)M * 30;
+    cout << "־ûmap: " << (ok ? "ok" : "error") << endl;
+}
+
+// ԽڵĬϷڴظ/һ
+template<class Alloc>
+size_t RBTreeAllocBench(const vector<int>& v) {
+    size_t begin = clock();
+    {
+        RBTree<int, int, IntKeyOfT, less<>, Alloc> t;
+        for (auto e: v) {
+            t.Insert(e);
+        }
+        RBTree<int, int, IntKeyOfT, less<>, Alloc> copy(t);
+        if (!copy.IsBalance() || copy.Size() != t.Size()) {
+            cout << "ȷ" << endl;
+        }
+    } // ڵ㻹
+    return clock() - begin;
+}
+
+void test_RBTree_pool() {
+    cout << "\n========== Ժڵڴ ==========" << endl;
+    const int N = 1000000;
+    vector<int> v;
+    v.reserve(N);
+    srand(time(0));
+    for (size_t i = 0; i < N; i++) {
+        v.push_back(rand() % (1 << 30) + i);
+    }
+    cout << "std::allocator ++ʱ: " << RBTreeAllocBench<allocator<int>>(v) << endl;
+    cout << "pool_allocator ++ʱ: " << RBTreeAllocBench<pzh::pool_allocator<int>>(v) << endl;
+}
+
+// B+롢/std::set˶
+void test_BPlusTree() {
+    cout << "\n========== B+ ==========" << endl;
+    bool ok = true;
+    {
+        BPlusTree<int, int, IntKeyOfT> t;
+        std::set<int> ref;
+        srand(time(0));
+        for (int i = 0; i < 200000; i++) {
+            int x = rand() % 100000;
+            bool inserted = t.Insert(x).second;
+            ok = ok && inserted == ref.insert(x).second && *t.Find(x) == x;
+        }
+        ok = ok && t.IsValid() && t.Size() == ref.size();
+        ok = ok && equal(ref.begin(), ref.end(), t.begin());
+        for (int i = -10; i < 100010; i++) {
+            ok = ok && (t.Find(i) != t.end()) == (ref.count(i) == 1);
+            auto lb = t.LowerBound(i);
+            auto rlb = ref.lower_bound(i);
+            ok = ok && (rlb == ref.end() ? lb == t.end() : (lb != t.end() && *lb == *rlb));
+        }
+        cout << "ڵ: " << t.Size() << "߶: " << t.Height() << endl;
+
+        // ԭһ
+        BPlusTree<int, int, IntKeyOfT> copy(t);
+        ok = ok && copy.IsValid() && equal(ref.begin(), ref.end(), copy.begin());
+    }
+    {
+        // 򡢽룺ʱһ߱ȫ
+        BPlusTree<int, int, IntKeyOfT> up, down;
+        for (int i = 0; i < 100000; i++) {
+            up.Insert(i);
+            down.Insert(100000 - i);
+        }
+        ok = ok && up.IsValid() && down.IsValid() && up.Size() == 100000 && down.Size() == 100000;
+        cout << "߶: " << up.Height() << "߶: " << down.Height() << endl;
+        // 
+        int expect = 99999;
+        for (auto rit = up.rbegin(); rit != up.rend(); ++rit) {
+            ok = ok && *rit == expect--;
+        }
+        ok = ok && expect == -1 && *--down.end() == 100000;
+    }
+    {
+        // Ϊmap/setĵײ㣬ԪûĬϹҲ
+        string arr[] = {"apple", "banana", "apple", "orange", "banana", "apple", "grape", "banana", "apple"};
+        pzh::map<string, int, less<>, allocator<pair<string, int>>, pzh::bplus_tree_policy> countMap;
+        for (auto &e: arr) {
+            countMap[e]++;
+        }
+        for (auto &kv: countMap) {
+            cout << kv.first << ": " << kv.second << endl;
+        }
+        ok = ok && countMap["apple"] == 4 && countMap["banana"] == 3 && countMap["grape"] == 1;
+
+        pzh::set<int, less<>, pzh::pool_allocator<int>, pzh::bplus_tree_policy> s;
+        for (int i = 1000; i > 0; i--) {
+            s.insert(i % 500);
+        }
+        int prev = -1;
+        for (auto e: s) {
+            ok = ok && e == prev + 1;
+            prev = e;
+        }
+        ok = ok && prev == 499;
+    }
+    {
+        // ɾstd::setģڵ㿪Сһ㣬һЩڲڵĽ/ϲҲߵ
+        BPlusTree<int, int, IntKeyOfT, less<>, allocator<int>, 128> t;
+        std::set<int> ref;
+        for (int i = 0; i < 200000 && ok; i++) {
+            int x = rand() % 20000;
+            if (rand() % 2) {
+                ok = t.Insert(x).second == ref.insert(x).second;
+            } else {
+                ok = t.Erase(x) == (ref.erase(x) == 1);
+            }
+            if (i % 10000 == 0) {
+                ok = ok && t.IsValid();
+            }
+        }
+        ok = ok && t.IsValid() && t.Size() == ref.size() && equal(ref.begin(), ref.end(), t.begin());
+        // ɾżɾɾգҪһ·ȥ
+        for (int i = 0; i < 20000; i += 2) {
+            t.Erase(i);
+        }
+        ok = ok && t.IsValid();
+        for (int i = 19999; i > 0; i -= 2) {
+            t.Erase(i);
+        }
+        ok = ok && t.IsValid() && t.Size() == 0 && t.begin() == t.end() && t.Height() == 0;
+
+        // maperase(iterator)һλ
+        pzh::map<string, int, less<>, allocator<pair<string, int>>, pzh::bplus_tree_policy> m;
+        for (int i = 0; i < 3000; i++) {
+            m[to_string(100000 + i)] = i;
+        }
+        for (auto it = m.begin(); it != m.end();) {
+            if (it->second % 3) {
+                it = m.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        ok = ok && m.erase("100003") == 1 && m.erase("100004") == 0;
+        size_t left = 0;
+        for (auto &kv: m) {
+            ok = ok && kv.second % 3 == 0 && kv.second != 3;
+            left++;
+        }
+        ok = ok && left == 999;
+    }
+    cout << "B+: " << (ok ? "ok" : "error") << endl;
+}
+
+// 롢ҡһ飬κʱ
+template<class Tree>
+void TreeBench(const char *name, const vector<int> &keys, const vector<int> &probes) {
+    Tree t;
+    size_t begin = clock();
+    for (auto e: keys) {
+        t.Insert(make_pair(e, e));
+    }
+    size_t insertTime = clock() - begin;
+
+    begin = clock();
+    size_t hit = 0;
+    for (auto e: probes) {
+        hit += t.Find(e) != t.end();
+    }
+    size_t findTime = clock() - begin;
+
+    begin = clock();
+    long long sum = 0;
+    for (int round = 0; round < 10; round++) {
+        for (auto &kv: t) {
+            sum += kv.second;
+        }
+    }
+    size_t scanTime = clock() - begin;
+
+    cout << name << " : " << insertTime << "  : " << findTime
+         << "  x10: " << scanTime << "  (߶ " << t.Height() << " " << hit << "У " << sum << ")" << endl;
+}
+
+// B+ĶԱȣkeyĲ롢ҡ˳ɨ
+void test_BPlusTree_performance() {
+    cout << "\n==========  vs B+ ==========" << endl;
+    const int N = 1000000;
+    vector<int> keys;
+    keys.reserve(N);
+    srand(time(0));
+    for (size_t i = 0; i < N; i++) {
+        keys.push_back(rand() % (1 << 30) + i);
+    }
+    // һһ벻У˳
+    vector<int> probes;
+    probes.reserve(N);
+    for (size_t i = 0; i < N; i++) {
+        probes.push_back(i % 2 ? keys[rand() % N] : rand() % (1 << 30));
+    }
+    TreeBench<RBTree<int, pair<int, int>, PairIntKeyOfT>>("RBTree         ", keys, probes);
+    TreeBench<AVLTree<int, pair<int, int>, PairIntKeyOfT>>("AVLTree        ", keys, probes);
+    TreeBench<BPlusTree<int, pair<int, int>, PairIntKeyOfT, less<>, allocator<pair<int, int>>, 256>>("BPlusTree(256B)", keys, probes);
+    TreeBench<BPlusTree<int, pair<int, int>, PairIntKeyOfT>>("BPlusTree(512B)", keys, probes);
+    TreeBench<BPlusTree<int, pair<int, int>, PairIntKeyOfT, less<>, allocator<pair<int, int>>, 1024>>("BPlusTree(1KB) ", keys, probes);
+}
+
+// һmapop 0ҡ1롢2ɾ
+template<class Map>
+void TraceBench(const char *name, const vector<int> &preload, const vector<pair<int, int>> &trace) {
+    Map m;
+    for (auto e: preload) {
+        m[e] = e;
+    }
+    size_t begin = clock();
+    size_t hit = 0;
+    for (auto &op: trace) {
+        if (op.first == 0) {
+            hit += m.find(op.second) != m.end();
+        } else if (op.first == 1) {
+            m.insert(make_pair(op.second, op.second));
+        } else {
+            m.erase(op.second);
+        }
+    }
+    cout << name << " ʱ: " << clock() - begin << "  ( " << hit << "ʱ " << m.size() << " Ԫ)" << endl;
+}
+
+// pzh::mapײѡAVLдٺдֲ
+void test_AVL_vs_RB() {
+    cout << "\n========== pzh::map:  vs AVL ==========" << endl;
+    const int N = 500000;
+    const int OPS = 2000000;
+    const int RANGE = 1 << 21;
+    srand(time(0));
+    vector<int> preload;
+    preload.reserve(N);
+    for (int i = 0; i < N; i++) {
+        preload.push_back(rand() % RANGE);
+    }
+    typedef pzh::map<int, int, less<>, allocator<pair<int, int>>, pzh::rb_tree_policy> RBMap;
+    typedef pzh::map<int, int, less<>, allocator<pair<int, int>>, pzh::avl_tree_policy> AVLMap;
+    // readPercent% ĲңʣµĲɾһ
+    for (int readPercent: {95, 20}) {
+        vector<pair<int, int>> trace;
+        trace.reserve(OPS);
+        for (int i = 0; i < OPS; i++) {
+            int r = rand() % 100;
+            int op = r < readPercent ? 0 : (r - readPercent) % 2 + 1;
+            trace.push_back(make_pair(op, rand() % RANGE));
+        }
+        cout << (readPercent > 50 ? "д" : "д") << "" << readPercent << "% ң:" << endl;
+        TraceBench<RBMap>("  rb_tree_policy ", preload, trace);
+        TraceBench<AVLMap>("  avl_tree_policy", preload, trace);
+    }
+
+    // ֵײΪһ
+    RBMap rm;
+    AVLMap am;
+    bool ok = true;
+    for (int i = 0; i < 100000; i++) {
+        int key = rand() % 5000;
+        if (i % 3 == 0) {
+            ok = ok && rm.erase(key) == am.erase(key);
+        } else {
+            ok = ok && rm.try_emplace(key, i).second == am.try_emplace(key, i).second;
+        }
+    }
+    auto it = am.begin();
+    for (auto &kv: rm) {
+        ok = ok && it != am.end() && it->first == kv.first && it->second == kv.second;
+        ++it;
+    }
+    ok = ok && it == am.end() && rm.size() == am.size() && am.rbegin()->first == rm.rbegin()->first
+         && am.lower_bound(2500)->first == rm.lower_bound(2500)->first;
+    cout << "avl_tree_policy: " << (ok ? "ok" : "error") << endl;
+}
+
+// ȫһpzh::mapΪĶ
+template<class K, class V>
+class LockedOrderedMap {
+public:
+    optional<V> find(const K &key) const {
+        lock_guard<mutex> lock(_mtx);
+        auto it = _map.find(key);
+        if (it == _map.end())
+            return nullopt;
+        return it->second;
+    }
+
+    bool insert(const pair<K, V> &kv) {
+        lock_guard<mutex> lock(_mtx);
+        return _map.insert(kv).second;
+    }
+
+    bool erase(const K &key) {
+        lock_guard<mutex> lock(_mtx);
+        return _map.erase(key) == 1;
+    }
+
+private:
+    mutable mutex _mtx;
+    mutable pzh::map<K, V> _map;
+};
+
+// ռҽֹѲŻ
+atomic<size_t> g_benchSink;
+
+// ÿ̶߳ĲreadPercent%ңɾһ룩£Mops/s
+template<class Map>
+double BenchOrderedMap(Map &m, int threadCount, int opsPerThread, int keyRange, int readPercent) {
+    vector<thread> threads;
+    auto begin = chrono::steady_clock::now();
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back([&m, t, opsPerThread, keyRange, readPercent]() {
+            uint64_t x = 0x9E3779B97F4A7C15ULL * (t + 1);
+            size_t hit = 0;
+            for (int i = 0; i < opsPerThread; i++) {
+                // xorshiftrand()ڲӰ
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                int key = (int) (x % keyRange);
+                int r = (int) ((x >> 32) % 100);
+                if (r < readPercent) {
+                    hit += m.find(key).has_value();
+                } else if (r % 2) {
+                    hit += m.insert(make_pair(key, i));
+                } else {
+                    hit += m.erase(key);
+                }
+            }
+            g_benchSink += hit;
+        });
+    }
+    for (auto &th: threads) {
+        th.join();
+    }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    return threadCount * (double) opsPerThread / sec / 1e6;
+}
+
+// ̶߳Բཻkey/ɾ˳˶ԣٺͼpzh::map
+void test_concurrent_map() {
+    cout << "\n========== concurrent_map ==========" << endl;
+    bool ok = true;
+    {
+        pzh::concurrent_map<int, int> m;
+        const int kThreads = 8;
+        const int kPerThread = 20000;
+        vector<thread> threads;
+        for (int t = 0; t < kThreads; t++) {
+            threads.emplace_back([&m, t]() {
+                // keyÿ̸߳ i * kThreads + t
+                for (int i = 0; i < kPerThread; i++) {
+                    m.insert(make_pair(i * kThreads + t, i));
+                }
+                for (int i = 0; i < kPerThread; i += 3) {
+                    m.erase(i * kThreads + t);
+                }
+            });
+        }
+        // ͬʱ߳ͬһkeyϷɾͬһkeyɾֲ
+        threads.emplace_back([&m]() {
+            for (int round = 0; round < 20; round++) {
+                for (int k = -1000; k < 0; k++) {
+                    m.insert(make_pair(k, round));
+                    m.erase(k);
+                }
+            }
+        });
+        for (auto &th: threads) {
+            th.join();
+        }
+        size_t expectSize = 0;
+        for (int i = 0; i < kPerThread; i++) {
+            expectSize += i % 3 ? kThreads : 0;
+        }
+        int prev = -1;
+        size_t count = 0;
+        m.for_each([&](const pair<int, int> &kv) {
+            ok = ok && kv.first > prev && (kv.first / kThreads) % 3 != 0 && kv.second == kv.first / kThreads;
+            prev = kv.first;
+            ++count;
+        });
+        ok = ok && count == expectSize && m.size() == expectSize && !m.contains(1) && m.find(kThreads + 1) == 1;
+        auto lb = m.lower_bound(kThreads * 3);
+        ok = ok && lb && lb->first == kThreads * 4;
+        size_t rangeCount = 0;
+        m.for_each(100, 200, [&](const pair<int, int> &kv) { rangeCount += kv.first >= 100 && kv.first < 200; });
+        ok = ok && rangeCount > 0 && rangeCount < 100;
+    }
+    cout << "/ɾ: " << (ok ? "ok" : "error") << endl;
+
+    const int keyRange = 1 << 20;
+    const int opsPerThread = 100000;
+    cout << "---- map£Mops/s80%10%10%ɾ:" << thread::hardware_concurrency() << "----" << endl;
+    for (int threads = 1; threads <= 64; threads *= 2) {
+        LockedOrderedMap<int, int> locked;
+        pzh::concurrent_map<int, int> skiplist;
+        for (int i = 0; i < keyRange; i += 2) {
+            locked.insert(make_pair(i, i));
+            skiplist.insert(make_pair(i, i));
+        }
+        double a = BenchOrderedMap(locked, threads, opsPerThread, keyRange, 80);
+        double b = BenchOrderedMap(skiplist, threads, opsPerThread, keyRange, 80);
+        printf("threads:%2d  mutex+pzh::map:%7.2f  concurrent_map:%7.2f\n", threads, a, b);
+    }
+}
+
 int main() {
     // Ժ
     test_RBTree_basic();
@@ -421,6 +1646,32 @@ int main() {
     test_map();
     // Set
     test_set();
+    // Խڵڴ
+    test_RBTree_pool();
+    // ɾͷΧѯ
+    test_RBTree_erase();
+    // ѯ
+    test_RBTree_rank();
+    // ۺ
+    test_RBTree_aggregate();
+    // ͺϲ
+    test_RBTree_bulk_load();
+    // ͷڵͷ
+    test_RBTree_header();
+    // ԱȽ칹
+    test_RBTree_compare();
+    // ƶͽڵ
+    test_RBTree_move();
+    // Գ־ûmap
+    test_persistent_map();
+    // B+
+    test_BPlusTree();
+    // B+ܶԱ
+    test_BPlusTree_performance();
+    // pzh::mapײAVLĶԱ
+    test_AVL_vs_RB();
+    // ͼĶԱ
+    test_concurrent_map();
     // ܲԣע͵Ҫϳʱ䣩
     // test_RBTree_performance();
     return 0;
@@ -1,3 +1,4 @@
+#pragma once
 // vector::iterator  -> ReverseIterator
 // list::iterator    -> ReverseIterator
 
@@ -0,0 +1,219 @@
+#pragma once
+#include<shared_mutex>
+#include<mutex>
+#include<memory>
+#include<optional>
+#include<thread>
+#include<vector>
+#include"MyUnorderedMap.h"
+
+namespace pzh
+{
+    // 分片并发哈希表：key按哈希值分到N个互相独立的unordered_map上，每个分片一把读写锁。
+    //   find/cvisit 拿读锁，不同线程读同一分片也不互斥；
+    //   insert_or_assign/visit/erase 拿写锁，只影响同一分片上的操作。
+    // 不提供迭代器：锁只在一次调用里持有，需要遍历时用for_each_shard逐个分片加锁处理。
+    // 分片不能开启渐进式rehash：那样find会顺带迁移桶，读锁下就成了写操作
+    template<class K, class V, class Hash = HashFunc<K>, class Policy = hash_bucket_policy>
+    class concurrent_unordered_map
+    {
+        typedef unordered_map<K, V, Hash, Policy> Map;
+
+        // 每个分片独占缓存行，避免相邻分片的锁互相伪共享
+        struct alignas(64) Shard
+        {
+            mutable std::shared_mutex _mtx;
+            mutable Map _map;  // unordered_map的find不是const成员，读锁下的查找也要通过它调用
+        };
+
+    public:
+        typedef pair<const K, V> value_type;
+
+        // 分片数向上取整到2的幂
+        explicit concurrent_unordered_map(size_t shards = 64)
+        {
+            size_t n = 1;
+            while (n < shards)
+                n <<= 1;
+            _mask = n - 1;
+            _shards.reset(new Shard[n]);
+        }
+
+        concurrent_unordered_map(const concurrent_unordered_map&) = delete;
+        concurrent_unordered_map& operator=(const concurrent_unordered_map&) = delete;
+
+        // 返回value的拷贝：锁在返回前就释放了，不能把引用交出去
+        std::optional<V> find(const K& key) const
+        {
+            const Shard& shard = ShardOf(key);
+            std::shared_lock<std::shared_mutex> lock(shard._mtx);
+            auto it = shard._map.find(key);
+            if (it == shard._map.end())
+                return std::nullopt;
+            return it->second;
+        }
+
+        bool contains(const K& key) const
+        {
+            const Shard& shard = ShardOf(key);
+            std::shared_lock<std::shared_mutex> lock(shard._mtx);
+            return shard._map.find(key) != shard._map.end();
+        }
+
+        // key不存在就插入，存在就覆盖value；返回是否新插入
+        template<class M>
+        bool insert_or_assign(const K& key, M&& value)
+        {
+            Shard& shard = ShardOf(key);
+            std::unique_lock<std::shared_mutex> lock(shard._mtx);
+            auto ret = shard._map.try_emplace(key, std::forward<M>(value));
+            if (!ret.second)
+                ret.first->second = std::forward<M>(value);
+            return ret.second;
+        }
+
+        // key不存在时才插入
+        template<class... Args>
+        bool try_emplace(const K& key, Args&&... args)
+        {
+            Shard& shard = ShardOf(key);
+            std::unique_lock<std::shared_mutex> lock(shard._mtx);
+            return shard._map.try_emplace(key, std::forward<Args>(args)...).second;
+        }
+
+        // 在写锁内对元素调用fn(value_type&)，可以原地修改（比如计数+1）；返回key是否存在
+        template<class Fn>
+        bool visit(const K& key, Fn fn)
+        {
+            Shard& shard = ShardOf(key);
+            std::unique_lock<std::shared_mutex> lock(shard._mtx);
+            auto it = shard._map.find(key);
+            if (it == shard._map.end())
+                return false;
+            fn(*it);
+            return true;
+        }
+
+        // 在读锁内对元素调用fn(const value_type&)，多个读者可以同时访问同一分片
+        template<class Fn>
+        bool cvisit(const K& key, Fn fn) const
+        {
+            const Shard& shard = ShardOf(key);
+            std::shared_lock<std::shared_mutex> lock(shard._mtx);
+            auto it = shard._map.find(key);
+            if (it == shard._map.end())
+                return false;
+            fn(static_cast<const value_type&>(*it));
+            return true;
+        }
+
+        bool erase(const K& key)
+        {
+            Shard& shard = ShardOf(key);
+            std::unique_lock<std::shared_mutex> lock(shard._mtx);
+            return shard._map.erase(key);
+        }
+
+        // 依次锁住每个分片（写锁），把分片内的unordered_map交给fn处理。
+        // 整体不是一个快照：处理后面的分片时前面的分片可能已经被修改
+        template<class Fn>
+        void for_each_shard(Fn fn)
+        {
+            for (size_t i = 0; i <= _mask; i++)
+            {
+                std::unique_lock<std::shared_mutex> lock(_shards[i]._mtx);
+                fn(_shards[i]._map);
+            }
+        }
+
+        // 各分片大小之和，并发修改时只是一个近似值
+        size_t size() const
+        {
+            size_t n = 0;
+            for (size_t i = 0; i <= _mask; i++)
+            {
+                std::shared_lock<std::shared_mutex> lock(_shards[i]._mtx);
+                n += _shards[i]._map.size();
+            }
+            return n;
+        }
+
+        size_t shard_count() const
+        {
+            return _mask + 1;
+        }
+
+        // 每个分片预留total/分片数个元素的空间
+        void reserve(size_t total)
+        {
+            for_each_shard([&](Map& m) { m.reserve(total / (_mask + 1) + 1); });
+        }
+
+    private:
+        // 分片内部的哈希表用哈希值的低位选桶，这里用高位选分片，两者互不干扰
+        size_t ShardIndex(const K& key) const
+        {
+            Hash hf;
+            size_t hash = hf(key);
+            return (hash >> (sizeof(size_t) * 8 - 16)) & _mask;
+        }
+
+        Shard& ShardOf(const K& key)
+        {
+            return _shards[ShardIndex(key)];
+        }
+
+        const Shard& ShardOf(const K& key) const
+        {
+            return _shards[ShardIndex(key)];
+        }
+
+        std::unique_ptr<Shard[]> _shards;
+        size_t _mask;
+    };
+
+    // 多线程对不相交的key区间做插入/修改/删除，结束后逐个key核对
+    void test_concurrent_map()
+    {
+        concurrent_unordered_map<int, int> m(16);
+        const int kThreads = 8;
+        const int kPerThread = 20000;
+        vector<thread> threads;
+        for (int t = 0; t < kThreads; t++)
+        {
+            threads.emplace_back([&m, t]() {
+                int base = t * kPerThread;
+                for (int i = 0; i < kPerThread; i++)
+                    m.insert_or_assign(base + i, i);
+                for (int i = 0; i < kPerThread; i += 2)
+                    m.visit(base + i, [](pair<const int, int>& kv) { kv.second += 1; });
+                for (int i = 0; i < kPerThread; i += 3)
+                    m.erase(base + i);
+            });
+        }
+        for (auto& th : threads)
+            th.join();
+        bool ok = true;
+        size_t expectSize = 0;
+        for (int t = 0; t < kThreads; t++)
+        {
+            for (int i = 0; i < kPerThread; i++)
+            {
+                auto v = m.find(t * kPerThread + i);
+                if (i % 3 == 0)
+                {
+                    ok = ok && !v;
+                }
+                else
+                {
+                    ++expectSize;
+                    ok = ok && v && *v == i + (i % 2 == 0 ? 1 : 0);
+                }
+            }
+        }
+        size_t shardTotal = 0;
+        m.for_each_shard([&](unordered_map<int, int>& shard) { shardTotal += shard.size(); });
+        ok = ok && m.size() == expectSize && shardTotal == expectSize;
+        cout << "concurrent map check:" << (ok ? "ok" : "error") << endl;
+    }
+}
@@ -0,0 +1,576 @@
+#pragma once
+#include<vector>
+#include<memory>
+#include<cassert>
+#include<cstdint>
+#include<cstring>
+#include<utility>
+#include<type_traits>
+#include<bit>
+#if defined(__AVX2__)
+#include<immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include<emmintrin.h>
+#endif
+
+// 开放定址 + 控制字节的扁平哈希表（SwissTable 思路）
+// 元素直接存放在连续的槽数组里，另有一个并行的控制字节数组：
+//   kEmpty   : 空槽
+//   kDeleted : 墓碑（删除过的槽）
+//   0~127    : 该槽有元素，值为哈希值的高7位(H2)
+// 查找时一次比较一整组（SSE2为16个、AVX2为32个）控制字节，
+// 只有H2命中的槽才去比较key，基本不用访问元素本身
+namespace pzh_flat_hash
+{
+    typedef int8_t ctrl_t;
+
+    enum : ctrl_t
+    {
+        kEmpty = -128,   // 0b10000000
+        kDeleted = -2    // 0b11111110
+    };
+
+    // 组内匹配结果：每个槽占 1<<kShift 位，用 countr_zero 依次取出命中的槽
+#if defined(__AVX2__)
+    struct Group
+    {
+        static constexpr size_t kWidth = 32;
+        static constexpr int kShift = 0;
+        __m256i _ctrl;
+
+        explicit Group(const ctrl_t* pos)
+            :_ctrl(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos)))
+        {}
+
+        // 控制字节等于h2的槽
+        uint64_t Match(ctrl_t h2) const
+        {
+            return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_set1_epi8(h2), _ctrl));
+        }
+
+        uint64_t MatchEmpty() const
+        {
+            return Match(kEmpty);
+        }
+
+        // 空槽和墓碑都是负数，有元素的槽都>=0
+        uint64_t MatchEmptyOrDeleted() const
+        {
+            return (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(_mm256_set1_epi8(-1), _ctrl));
+        }
+    };
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    struct Group
+    {
+        static constexpr size_t kWidth = 16;
+        static constexpr int kShift = 0;
+        __m128i _ctrl;
+
+        explicit Group(const ctrl_t* pos)
+            :_ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pos)))
+        {}
+
+        uint64_t Match(ctrl_t h2) const
+        {
+            return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), _ctrl));
+        }
+
+        uint64_t MatchEmpty() const
+        {
+            return Match(kEmpty);
+        }
+
+        uint64_t MatchEmptyOrDeleted() const
+        {
+            return (uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), _ctrl));
+        }
+    };
+#else
+    // 没有SIMD时用64位整数一次处理8个控制字节，每个槽占一个字节的最高位
+    struct Group
+    {
+        static constexpr size_t kWidth = 8;
+        static constexpr int kShift = 3;
+        static constexpr uint64_t kLsbs = 0x0101010101010101ULL;
+        static constexpr uint64_t kMsbs = 0x8080808080808080ULL;
+        uint64_t _ctrl;
+
+        explicit Group(const ctrl_t* pos)
+        {
+            memcpy(&_ctrl, pos, sizeof(_ctrl));
+        }
+
+        // 可能有假阳性，但调用方总会再比较一次key，不影响正确性
+        uint64_t Match(ctrl_t h2) const
+        {
+            uint64_t x = _ctrl ^ (kLsbs * (uint8_t)h2);
+            return (x - kLsbs) & ~x & kMsbs;
+        }
+
+        uint64_t MatchEmpty() const
+        {
+            return (_ctrl & ~(_ctrl << 6)) & kMsbs;
+        }
+
+        uint64_t MatchEmptyOrDeleted() const
+        {
+            return (_ctrl & ~(_ctrl << 7)) & kMsbs;
+        }
+    };
+#endif
+
+    // 取出并清掉最低位的命中槽，返回它在组内的下标
+    inline size_t PopMatch(uint64_t& mask)
+    {
+        size_t i = (size_t)std::countr_zero(mask) >> Group::kShift;
+        mask &= mask - 1;
+        return i;
+    }
+
+    template<class K, class T, class KeyOfT, class Hash>
+    class FlatHashTable;
+
+    // 扁平哈希表迭代器：记录所属表和槽下标，++时跳过非元素槽
+    template<class K, class T, class Ref, class Ptr, class KeyOfT, class Hash>
+    struct __FlatIterator
+    {
+        typedef __FlatIterator<K, T, Ref, Ptr, KeyOfT, Hash> Self;
+        typedef __FlatIterator<K, T, T&, T*, KeyOfT, Hash> Iterator;
+        const FlatHashTable<K, T, KeyOfT, Hash>* _pht;
+        size_t _index;
+
+        __FlatIterator(const FlatHashTable<K, T, KeyOfT, Hash>* pht, size_t index)
+            :_pht(pht)
+            ,_index(index)
+        {}
+
+        // iterator转const_iterator。做成只接受Iterator的模板：在iterator自己身上它不会占掉拷贝构造的位置
+        template<class It>
+            requires std::is_same_v<It, Iterator> && (!std::is_same_v<It, Self>)
+        __FlatIterator(const It& it)
+            :_pht(it._pht)
+            ,_index(it._index)
+        {}
+
+        Self& operator++()
+        {
+            ++_index;
+            while (_index < _pht->_capacity && _pht->_ctrl[_index] < 0)
+            {
+                ++_index;
+            }
+            return *this;
+        }
+
+        Ref operator*()
+        {
+            return _pht->_slots[_index];
+        }
+
+        Ptr operator->()
+        {
+            return &_pht->_slots[_index];
+        }
+
+        bool operator!=(const Self& s) const
+        {
+            return _index != s._index;
+        }
+
+        bool operator==(const Self& s) const
+        {
+            return _index == s._index;
+        }
+    };
+
+    // 对外接口和 pzh_hash_bucket::HashTable 保持一致：Insert/Find/Erase/begin/end
+    template<class K, class T, class KeyOfT, class Hash>
+    class FlatHashTable
+    {
+        template<class K1, class T1, class Ref, class Ptr, class KeyOfT1, class Hash1>
+        friend struct __FlatIterator;
+
+    public:
+        typedef __FlatIterator<K, T, T&, T*, KeyOfT, Hash> iterator;
+        typedef __FlatIterator<K, T, const T&, const T*, KeyOfT, Hash> const_iterator;
+
+        iterator begin()
+        {
+            return iterator(this, FirstFull());
+        }
+
+        iterator end()
+        {
+            return iterator(this, _capacity);
+        }
+
+        const_iterator begin() const
+        {
+            return const_iterator(this, FirstFull());
+        }
+
+        const_iterator end() const
+        {
+            return const_iterator(this, _capacity);
+        }
+
+        FlatHashTable()
+        {
+            Allocate(Group::kWidth);
+        }
+
+        FlatHashTable(const FlatHashTable&) = delete;
+        FlatHashTable& operator=(const FlatHashTable&) = delete;
+
+        ~FlatHashTable()
+        {
+            DestroyAll();
+            Deallocate();
+        }
+
+        pair<iterator, bool> Insert(const T& data)
+        {
+            KeyOfT kot;
+            size_t hash = HashOf(kot(data));
+            size_t index = FindIndex(kot(data), hash);
+            if (index != _capacity)
+                return make_pair(iterator(this, index), false);
+            index = PrepareInsert(hash);
+            new(&_slots[index]) T(data);
+            OccupySlot(index, hash);
+            return make_pair(iterator(this, index), true);
+        }
+
+        // key不存在时才用args构造元素，存在时什么都不构造
+        template<class... Args>
+        pair<iterator, bool> Emplace(const K& key, Args&&... args)
+        {
+            size_t hash = HashOf(key);
+            size_t index = FindIndex(key, hash);
+            if (index != _capacity)
+                return make_pair(iterator(this, index), false);
+            index = PrepareInsert(hash);
+            new(&_slots[index]) T(std::forward<Args>(args)...);
+            OccupySlot(index, hash);
+            return make_pair(iterator(this, index), true);
+        }
+
+        iterator Find(const K& key)
+        {
+            return iterator(this, FindIndex(key, HashOf(key)));
+        }
+
+        const_iterator Find(const K& key) const
+        {
+            return const_iterator(this, FindIndex(key, HashOf(key)));
+        }
+
+        // 哈希函数带is_transparent时，可以不构造K直接查找
+        template<class KeyLike>
+            requires requires { typename Hash::is_transparent; }
+        iterator Find(const KeyLike& key)
+        {
+            return iterator(this, FindIndex(key, HashOf(key)));
+        }
+
+        template<class KeyLike>
+            requires requires { typename Hash::is_transparent; }
+        const_iterator Find(const KeyLike& key) const
+        {
+            return const_iterator(this, FindIndex(key, HashOf(key)));
+        }
+
+        bool Erase(const K& key)
+        {
+            size_t index = FindIndex(key, HashOf(key));
+            if (index == _capacity)
+                return false;
+            EraseIndex(index);
+            return true;
+        }
+
+        // 按迭代器删除：槽位就是迭代器里的下标，不用重新计算哈希，其他元素也不移动
+        iterator Erase(const_iterator pos)
+        {
+            iterator next(this, pos._index);
+            ++next;
+            EraseIndex(pos._index);
+            return next;
+        }
+
+        // 删除所有满足pred的元素，一趟扫完控制字节，返回删除的个数
+        template<class Pred>
+        size_t EraseIf(Pred pred)
+        {
+            size_t count = 0;
+            for (size_t i = 0; i < _capacity; i++)
+            {
+                if (_ctrl[i] >= 0 && pred(_slots[i]))
+                {
+                    EraseIndex(i);
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+        // 大量删除之后收缩槽数组，同时清掉所有墓碑
+        void ShrinkToFit()
+        {
+            size_t capacity = CapacityFor(_n);
+            bool hasDeleted = _growthLeft + _n < MaxElements(_capacity);
+            if (capacity < _capacity || hasDeleted)
+                Resize(capacity);
+        }
+
+        size_t Size() const
+        {
+            return _n;
+        }
+
+        size_t BucketCount() const
+        {
+            return _capacity;
+        }
+
+        float LoadFactor() const
+        {
+            return (float)_n / (float)_capacity;
+        }
+
+        float MaxLoadFactor() const
+        {
+            return _maxLoadFactor;
+        }
+
+        // 组探测在负载超过7/8后退化明显，所以最大负载因子不超过7/8
+        void MaxLoadFactor(float ml)
+        {
+            assert(ml > 0);
+            _maxLoadFactor = ml < 0.875f ? ml : 0.875f;
+            Rehash(0);
+        }
+
+        // 槽数调整到至少n个，同时保证不超过最大负载因子
+        void Rehash(size_t n)
+        {
+            size_t capacity = CapacityFor(_n);
+            while (capacity < n)
+            {
+                capacity *= 2;
+            }
+            Resize(capacity);
+        }
+
+        // 预留能放下n个元素的槽，批量插入前调用可以避免中途多次扩容
+        void Reserve(size_t n)
+        {
+            size_t capacity = CapacityFor(n);
+            if (capacity > _capacity)
+            {
+                Resize(capacity);
+            }
+        }
+
+    private:
+        // 对用户哈希值做一次混合：起始组取的是低位，而乘积的低位只由输入的低位决定，
+        // 只差在高位的key（比如i << 32，整数直接强转的哈希）乘完低位还是一样，会全部挤进同一组；
+        // 所以乘完再把高32位异或回低位，让每一位输入都影响到选组的低位，高7位（H2）保持乘积的高位
+        template<class KeyLike>
+        size_t HashOf(const KeyLike& key) const
+        {
+            Hash hf;
+            uint64_t h = (uint64_t)hf(key) * 0x9E3779B97F4A7C15ULL;
+            return (size_t)(h ^ (h >> 32));
+        }
+
+        // 高7位存入控制字节，其余位用来选起始组
+        static ctrl_t H2(size_t hash)
+        {
+            return (ctrl_t)(hash >> (sizeof(size_t) * 8 - 7));
+        }
+
+        size_t GroupMask() const
+        {
+            return _capacity / Group::kWidth - 1;
+        }
+
+        // 按组做三角数探测：g, g+1, g+3, g+6 ...，组数是2的幂时能遍历所有组
+        template<class KeyLike>
+        size_t FindIndex(const KeyLike& key, size_t hash) const
+        {
+            KeyOfT kot;
+            size_t mask = GroupMask();
+            size_t g = hash & mask;
+            ctrl_t h2 = H2(hash);
+            for (size_t step = 1; ; ++step)
+            {
+                const ctrl_t* pos = _ctrl + g * Group::kWidth;
+                Group group(pos);
+                uint64_t match = group.Match(h2);
+                while (match)
+                {
+                    size_t index = g * Group::kWidth + PopMatch(match);
+                    if (kot(_slots[index]) == key)
+                        return index;
+                }
+                // 本组有空槽，说明key不可能在更后面
+                if (group.MatchEmpty())
+                    return _capacity;
+                g = (g + step) & mask;
+            }
+        }
+
+        // 找到探测序列上第一个空槽或墓碑
+        size_t FindInsertSlot(size_t hash) const
+        {
+            size_t mask = GroupMask();
+            size_t g = hash & mask;
+            for (size_t step = 1; ; ++step)
+            {
+                uint64_t match = Group(_ctrl + g * Group::kWidth).MatchEmptyOrDeleted();
+                if (match)
+                    return g * Group::kWidth + PopMatch(match);
+                g = (g + step) & mask;
+            }
+        }
+
+        // 必要时扩容，返回新元素该放的槽；调用方构造好元素之后再调OccupySlot
+        size_t PrepareInsert(size_t hash)
+        {
+            // 可用槽用完了（负载因子到7/8）
+            if (_growthLeft == 0)
+            {
+                // 墓碑占了一半以上时原地重建就够了，否则扩容2倍
+                if (_n * 2 < MaxElements(_capacity))
+                    Resize(_capacity);
+                else
+                    Resize(_capacity * 2);
+            }
+            return FindInsertSlot(hash);
+        }
+
+        // 元素已经构造进index之后才占用这个槽：构造抛异常时控制字节和可用槽数都没动过
+        void OccupySlot(size_t index, size_t hash)
+        {
+            if (_ctrl[index] == kEmpty)
+                --_growthLeft;  // 复用墓碑不消耗可用槽
+            _ctrl[index] = H2(hash);
+            ++_n;
+        }
+
+        void EraseIndex(size_t index)
+        {
+            _slots[index].~T();
+            // 所在组里还有空槽，说明从来没有探测越过这一组，可以直接置空；
+            // 否则要留下墓碑，保证后面组里的元素还能被找到
+            size_t groupStart = index & ~(Group::kWidth - 1);
+            if (Group(_ctrl + groupStart).MatchEmpty())
+            {
+                _ctrl[index] = kEmpty;
+                ++_growthLeft;
+            }
+            else
+            {
+                _ctrl[index] = kDeleted;
+            }
+            --_n;
+        }
+
+        size_t FirstFull() const
+        {
+            size_t index = 0;
+            while (index < _capacity && _ctrl[index] < 0)
+            {
+                ++index;
+            }
+            return index;
+        }
+
+        // capacity个槽最多放多少个元素
+        size_t MaxElements(size_t capacity) const
+        {
+            size_t n = (size_t)(capacity * _maxLoadFactor);
+            return n > 0 ? n : 1;
+        }
+
+        // 放下n个元素需要的最小槽数
+        size_t CapacityFor(size_t n) const
+        {
+            size_t capacity = Group::kWidth;
+            while (MaxElements(capacity) < n)
+            {
+                capacity *= 2;
+            }
+            return capacity;
+        }
+
+        void Allocate(size_t capacity)
+        {
+            _capacity = capacity;
+            _ctrl = new ctrl_t[capacity];
+            memset(_ctrl, kEmpty, capacity);
+            _slots = allocator<T>().allocate(capacity);
+            _growthLeft = MaxElements(capacity);
+        }
+
+        void Deallocate()
+        {
+            delete[] _ctrl;
+            allocator<T>().deallocate(_slots, _capacity);
+            _ctrl = nullptr;
+            _slots = nullptr;
+        }
+
+        void DestroyAll()
+        {
+            for (size_t i = 0; i < _capacity; i++)
+            {
+                if (_ctrl[i] >= 0)
+                    _slots[i].~T();
+            }
+        }
+
+        // 把所有元素搬到容量为newCapacity的新数组里，墓碑顺便清掉
+        void Resize(size_t newCapacity)
+        {
+            KeyOfT kot;
+            ctrl_t* oldCtrl = _ctrl;
+            T* oldSlots = _slots;
+            size_t oldCapacity = _capacity;
+            Allocate(newCapacity);
+            for (size_t i = 0; i < oldCapacity; i++)
+            {
+                if (oldCtrl[i] >= 0)
+                {
+                    size_t hash = HashOf(kot(oldSlots[i]));
+                    size_t index = FindInsertSlot(hash);
+                    new(&_slots[index]) T(std::move(oldSlots[i]));
+                    _ctrl[index] = H2(hash);
+                    --_growthLeft;
+                    oldSlots[i].~T();
+                }
+            }
+            delete[] oldCtrl;
+            allocator<T>().deallocate(oldSlots, oldCapacity);
+        }
+
+    private:
+        ctrl_t* _ctrl = nullptr;   // 控制字节数组
+        T* _slots = nullptr;       // 元素槽数组（未初始化内存，按需构造）
+        size_t _capacity = 0;      // 槽数，2的幂且是Group::kWidth的倍数
+        size_t _n = 0;             // 元素个数
+        size_t _growthLeft = 0;    // 还能占用多少个空槽才需要扩容
+        float _maxLoadFactor = 0.875f;  // 最大负载因子
+    };
+}
+
+namespace pzh
+{
+    // 哈希表后端策略：作为 unordered_map/unordered_set 的模板参数选择底层实现
+    struct flat_hash_policy
+    {
+        template<class K, class T, class KeyOfT, class Hash>
+        using Table = pzh_flat_hash::FlatHashTable<K, T, KeyOfT, Hash>;
+    };
+}
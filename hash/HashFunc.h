@@ -0,0 +1,172 @@
+#pragma once
+#include<cstdint>
+#include<cstring>
+#include<string>
+#include<string_view>
+#if defined(_MSC_VER) && defined(_M_X64)
+#include<intrin.h>
+#endif
+
+// 哈希函数模块：
+//   字符串按wyhash的思路每次吃进16字节（长串时三路并行共48字节），
+//   整数键经过一次128位乘法折叠，打散连续/等步长的key，
+//   HashFunc<string>带is_transparent，可以直接用const char*/string_view查找
+namespace pzh_hash_func
+{
+    static const uint64_t kSecret0 = 0xa0761d6478bd642fULL;
+    static const uint64_t kSecret1 = 0xe7037ed1a0b428dbULL;
+    static const uint64_t kSecret2 = 0x8ebc6af09c88c6e3ULL;
+    static const uint64_t kSecret3 = 0x589965cc75374cc3ULL;
+
+    // 64x64->128位乘法，结果低64位放回a，高64位放回b
+    inline void MulFull(uint64_t& a, uint64_t& b)
+    {
+#if defined(__SIZEOF_INT128__)
+        __uint128_t r = (__uint128_t)a * b;
+        a = (uint64_t)r;
+        b = (uint64_t)(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+        a = _umul128(a, b, &b);
+#else
+        // 没有128位乘法时拆成4个32位乘法
+        uint64_t ha = a >> 32, la = (uint32_t)a, hb = b >> 32, lb = (uint32_t)b;
+        uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+        uint64_t t = rl + (rm0 << 32);
+        uint64_t c = t < rl;
+        uint64_t lo = t + (rm1 << 32);
+        c += lo < t;
+        a = lo;
+        b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+    }
+
+    // 128位乘积的高低两半异或折叠成64位
+    inline uint64_t Mum(uint64_t a, uint64_t b)
+    {
+        MulFull(a, b);
+        return a ^ b;
+    }
+
+    // 整数混合：低位也依赖key的每一位，2的幂取模时不会扎堆
+    inline uint64_t Mix(uint64_t x)
+    {
+        return Mum(x ^ kSecret0, kSecret1);
+    }
+
+    inline uint64_t Read8(const uint8_t* p)
+    {
+        uint64_t v;
+        memcpy(&v, p, 8);
+        return v;
+    }
+
+    inline uint64_t Read4(const uint8_t* p)
+    {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    // 1~3字节：取首、中、尾三个字节拼起来
+    inline uint64_t Read3(const uint8_t* p, size_t k)
+    {
+        return ((uint64_t)p[0] << 16) | ((uint64_t)p[k >> 1] << 8) | p[k - 1];
+    }
+
+    // 任意字节串的哈希，短串不进循环，长串每步处理16字节
+    inline uint64_t HashBytes(const void* key, size_t len, uint64_t seed = 0)
+    {
+        const uint8_t* p = (const uint8_t*)key;
+        seed ^= Mum(seed ^ kSecret0, kSecret1);
+        uint64_t a, b;
+        if (len <= 16)
+        {
+            if (len >= 4)
+            {
+                // 4~16字节用首尾各两个可能重叠的4字节块盖住整个串
+                size_t off = (len >> 3) << 2;
+                a = (Read4(p) << 32) | Read4(p + off);
+                b = (Read4(p + len - 4) << 32) | Read4(p + len - 4 - off);
+            }
+            else if (len > 0)
+            {
+                a = Read3(p, len);
+                b = 0;
+            }
+            else
+            {
+                a = b = 0;
+            }
+        }
+        else
+        {
+            size_t i = len;
+            if (i > 48)
+            {
+                // 三条互不依赖的乘法链，乘法器可以流水起来
+                uint64_t see1 = seed, see2 = seed;
+                do
+                {
+                    seed = Mum(Read8(p) ^ kSecret1, Read8(p + 8) ^ seed);
+                    see1 = Mum(Read8(p + 16) ^ kSecret2, Read8(p + 24) ^ see1);
+                    see2 = Mum(Read8(p + 32) ^ kSecret3, Read8(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+                } while (i > 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16)
+            {
+                seed = Mum(Read8(p) ^ kSecret1, Read8(p + 8) ^ seed);
+                p += 16;
+                i -= 16;
+            }
+            // 最后16字节（可能和前面重叠）
+            a = Read8(p + i - 16);
+            b = Read8(p + i - 8);
+        }
+        a ^= kSecret1;
+        b ^= seed;
+        MulFull(a, b);
+        return Mum(a ^ kSecret0 ^ len, b ^ kSecret1);
+    }
+}
+
+template<class K>
+// 默认的仿函数：能转换成整型的key先转成整型，再经过混合
+struct HashFunc
+{
+    size_t operator()(const K& key) const
+    {
+        // 直接返回(size_t)key的话，连续的key落在连续的桶里，等步长的key只落在少数几个桶里
+        return (size_t)pzh_hash_func::Mix((uint64_t)(size_t)key);
+    }
+};
+
+// 针对string类型进行转换（针对string的特化版本）
+// is_transparent表示可以直接拿const char*/string_view来查找，不需要先构造string
+template<>
+struct HashFunc<string>
+{
+    typedef void is_transparent;
+
+    size_t operator()(string_view key) const
+    {
+        return (size_t)pzh_hash_func::HashBytes(key.data(), key.size());
+    }
+
+    size_t operator()(const string& key) const
+    {
+        return (*this)(string_view(key));
+    }
+
+    size_t operator()(const char* key) const
+    {
+        return (*this)(string_view(key));
+    }
+};
+
+template<>
+struct HashFunc<string_view> : HashFunc<string>
+{
+};
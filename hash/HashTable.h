@@ -1,49 +1,34 @@
 #pragma once
 #include<vector>
-
-template<class K>
-// 默认的仿函数功能，可以直接进行转换
-struct HashFunc
-{
-    size_t operator()(const K& key)
-    {
-        // 如果key值可以转换成size_t整型，就直接进行转换
-        return (size_t)key;
-    }
-};
-
-// 针对string类型进行转换（针对string的特化版本）
-template<>
-struct HashFunc<string>
-{
-    size_t operator()(const string& key)
-    {
-        size_t hash = 0;
-        for (auto e : key)
-        {
-            hash *= 31;
-            hash += e;
-        }
-        cout << key << ":" << hash << endl;
-        return hash;
-    }
-};
+#include<cmath>
+#include<cassert>
+#include<cstdlib>
+#include<new>
+#include<memory>
+#include<type_traits>
+#include<unordered_map>
+#include"HashFunc.h"
+#include"../Memory_management/PoolAllocator.h"
 
 // 开放地址法
+// Robin Hood线性探测：插入时“劫富济贫”，探测距离短的元素给距离长的让位，
+// 所有元素的探测距离都比较平均；删除时把后面的元素整体前移一格（backward shift），不留墓碑。
+// 探测距离和键值对分两个数组存放：查找时先顺序扫描1字节的距离数组，只有距离吻合才去比较key
 namespace pzh_open_address
 {
-    enum Status
+    // 探测长度统计：距离指元素实际位置离它哈希起始位置的格数
+    struct ProbeStats
     {
-        EMPTY,
-        EXIST,
-        DELETE
-    };
+        size_t _size;        // 元素个数
+        size_t _capacity;    // 槽数
+        double _avgProbe;    // 平均探测距离（查找成功时要比较的次数 - 1）
+        size_t _maxProbe;    // 最大探测距离
 
-    template<class K, class V>
-    struct HashData
-    {
-        pair<K, V> _kv;
-        Status _s; //状态
+        void Print() const
+        {
+            printf("size:%zu capacity:%zu load:%.2f avg probe:%.2f max probe:%zu\n",
+                   _size, _capacity, _capacity ? (double)_size / _capacity : 0.0, _avgProbe, _maxProbe);
+        }
     };
 
     //因为不是所有的key都可以正常的继续取模运算，所以需要加入仿函数Hash
@@ -53,99 +38,156 @@ namespace pzh_open_address
     public:
         HashTable_pre()
         {
-            _tables.resize(10);  //一开始就给哈希表开一点空间
+            Allocate(16);  //一开始就给哈希表开一点空间，槽数保持2的幂
         }
 
         bool Insert(const pair<K, V> &kv)
         {
             if (Find(kv.first))
                 return false;
-            // 负载因子0.7就扩容
-            if (_n * 10 / _tables.size() == 7)
-            {
-                size_t newSize = _tables.size() * 2;  //将旧表扩容原来的2倍
-                HashTable_pre<K, V, Hash> newHT;  // 扩容需要重新映射
-                newHT._tables.resize(newSize);
-                // 遍历旧表
-                for (size_t i = 0; i < _tables.size(); i++)
-                {
-                    if (_tables[i]._s == EXIST)
-                    {
-                        newHT.Insert(_tables[i]._kv);
-                    }
-                }
-                // 交换新旧表的存储空间
-                _tables.swap(newHT._tables);
-            }
-            Hash hf;
-            size_t hashi = hf(kv.first) % _tables.size();  // 算起始的第一个位置
-            while (_tables[hashi]._s == EXIST)  //起始位置的状态是“存在”
+            // 负载因子超过7/8就扩容（Robin Hood在高负载下探测距离依然很短）
+            if ((_n + 1) * 8 > _kvs.size() * 7)
             {
-                hashi++;
-                hashi %= _tables.size();
+                Resize(_kvs.size() * 2);
             }
-            _tables[hashi]._kv = kv;
-            _tables[hashi]._s = EXIST;
+            InsertNoCheck(kv);
             ++_n;
             return true;
         }
 
-        HashData<K, V>* Find(const K& key)
+        pair<K, V>* Find(const K& key)
         {
-            Hash hf;
-            size_t hashi = hf(key) % _tables.size();
-            while (_tables[hashi]._s != EMPTY)
-            {
-                if (_tables[hashi]._s == EXIST && _tables[hashi]._kv.first == key)
-                {
-                    return &_tables[hashi];
-                }
-                hashi++;
-                hashi %= _tables.size();
-            }
-            return NULL;
+            size_t i = FindIndex(key);
+            return i == _kvs.size() ? nullptr : &_kvs[i];
         }
 
-        // 伪删除法
-        /*删除3后，再插入3，由于只是改变了状态，并没有真正删除这个值*/
+        // 删除后把后面探测距离不为0的元素依次前移一格，表里始终没有墓碑
         bool Erase(const K& key)
         {
-            HashData<K, V>* ret = Find(key);
-            if (ret)
+            size_t i = FindIndex(key);
+            if (i == _kvs.size())
+                return false;
+            size_t mask = _kvs.size() - 1;
+            size_t next = (i + 1) & mask;
+            while (_dist[next] > 1)
             {
-                ret->_s = DELETE;
-                --_n;
-                return true;
+                _kvs[i] = std::move(_kvs[next]);
+                _dist[i] = _dist[next] - 1;
+                i = next;
+                next = (next + 1) & mask;
             }
-            else
+            _kvs[i] = pair<K, V>();
+            _dist[i] = 0;
+            --_n;
+            return true;
+        }
+
+        ProbeStats Stats() const
+        {
+            size_t sum = 0, maxProbe = 0;
+            for (size_t i = 0; i < _dist.size(); i++)
             {
-                return false;
+                if (_dist[i])
+                {
+                    size_t probe = _dist[i] - 1;
+                    sum += probe;
+                    if (probe > maxProbe)
+                        maxProbe = probe;
+                }
             }
+            return ProbeStats{_n, _kvs.size(), _n ? (double)sum / _n : 0.0, maxProbe};
+        }
+
+        size_t Size() const
+        {
+            return _n;
         }
 
         void Print()
         {
-            for (size_t i = 0; i < _tables.size(); i++)
+            for (size_t i = 0; i < _kvs.size(); i++)
             {
-                if (_tables[i]._s == EXIST)
+                if (_dist[i])
                 {
-                    //printf("[%d]->%d\n", i, _tables[i]._kv.first);
-                    cout << "[" << i << "]->" << _tables[i]._kv.first <<":" << _tables[i]._kv.second<< endl;
-                }
-                else if (_tables[i]._s == EMPTY)
-                {
-                    printf("[%d]->\n", i);
+                    cout << "[" << i << "]->" << _kvs[i].first << ":" << _kvs[i].second
+                         << " (probe " << _dist[i] - 1 << ")" << endl;
                 }
                 else
                 {
-                    printf("[%d]->D\n", i);
+                    printf("[%zu]->\n", i);
                 }
             }
             cout << endl;
         }
 
     private:
-        vector<HashData<K, V>> _tables;
+        // 距离数组最多记到254，再远就扩容
+        static const uint8_t kMaxDist = 255;
+
+        size_t FindIndex(const K& key) const
+        {
+            Hash hf;
+            size_t mask = _kvs.size() - 1;
+            size_t i = hf(key) & mask;
+            // 当前位置元素的探测距离比我们已经走过的还短，说明key如果存在早就该出现了
+            for (uint8_t d = 1; _dist[i] >= d; ++d)
+            {
+                if (_dist[i] == d && _kvs[i].first == key)
+                    return i;
+                i = (i + 1) & mask;
+            }
+            return _kvs.size();
+        }
+
+        // 不查重的插入：沿探测序列走，遇到比自己“富”（距离短）的元素就交换，带着被换出的元素继续找位置
+        void InsertNoCheck(pair<K, V> kv)
+        {
+            Hash hf;
+            size_t mask = _kvs.size() - 1;
+            size_t i = hf(kv.first) & mask;
+            uint8_t d = 1;  // 距离+1，0留给空槽
+            while (_dist[i] != 0)
+            {
+                if (_dist[i] < d)
+                {
+                    swap(kv, _kvs[i]);
+                    swap(d, _dist[i]);
+                }
+                i = (i + 1) & mask;
+                if (++d == kMaxDist)
+                {
+                    // 探测距离太长（哈希函数太差），扩容后重新插入手上这个元素
+                    Resize(_kvs.size() * 2);
+                    InsertNoCheck(std::move(kv));
+                    return;
+                }
+            }
+            _kvs[i] = std::move(kv);
+            _dist[i] = d;
+        }
+
+        void Allocate(size_t capacity)
+        {
+            _kvs.assign(capacity, pair<K, V>());
+            _dist.assign(capacity, 0);
+        }
+
+        void Resize(size_t newCapacity)
+        {
+            vector<pair<K, V>> oldKvs;
+            vector<uint8_t> oldDist;
+            oldKvs.swap(_kvs);
+            oldDist.swap(_dist);
+            Allocate(newCapacity);
+            for (size_t i = 0; i < oldKvs.size(); i++)
+            {
+                if (oldDist[i])
+                    InsertNoCheck(std::move(oldKvs[i]));
+            }
+        }
+
+        vector<pair<K, V>> _kvs;   // 键值对
+        vector<uint8_t> _dist;     // 探测距离+1，0表示空槽
         size_t _n = 0; // 存储的关键字的个数
     };
 
@@ -184,10 +226,10 @@ namespace pzh_open_address
         for (auto& e : arr)
         {
             //auto ret = ht.Find(e);
-            HashData<string, int>* ret = ht.Find(e);
+            pair<string, int>* ret = ht.Find(e);
             if (ret)
             {
-                ret->_kv.second++;
+                ret->second++;
             }
             else
             {
@@ -202,6 +244,31 @@ namespace pzh_open_address
         ht.Insert(make_pair("aad", 1));
         ht.Print();
     }
+
+    // 反复插入/删除之后探测长度不会变长，并和std::unordered_map对拍
+    void TestHT3()
+    {
+        HashTable_pre<int, int> ht;
+        std::unordered_map<int, int> ref;
+        srand(3);
+        bool ok = true;
+        for (int i = 0; i < 200000 && ok; i++)
+        {
+            int key = rand() % 20000;
+            if (rand() % 2)
+                ok = ht.Insert(make_pair(key, i)) == ref.insert(make_pair(key, i)).second;
+            else
+                ok = ht.Erase(key) == (ref.erase(key) == 1);
+        }
+        for (auto& kv : ref)
+        {
+            pair<int, int>* ret = ht.Find(kv.first);
+            ok = ok && ret && ret->second == kv.second;
+        }
+        ok = ok && ht.Size() == ref.size();
+        cout << "robin hood check:" << (ok ? "ok" : "error") << "  ";
+        ht.Stats().Print();
+    }
 }
 
 namespace pzh_hash_bucket
@@ -210,43 +277,178 @@ namespace pzh_hash_bucket
 	struct HashNode
 	{
 		HashNode<T>* _next;
+		size_t _hash;    // 缓存完整的哈希值，扩容重新映射时不用再调用Hash
 		T _data;
 
-		HashNode(const T& data)
-			:_data(data)
-			,_next(nullptr)
+		// 直接用参数原地构造数据，emplace/try_emplace也走这里
+		template<class... Args>
+		HashNode(size_t hash, Args&&... args)
+			:_next(nullptr)
+			,_hash(hash)
+			,_data(std::forward<Args>(args)...)
 		{}
 	};
 
+	// 桶数增长策略：决定桶数取哪些值，以及哈希值怎么映射到桶
+	// 桶数取2的幂，用位与代替取模（默认）
+	struct PowerOfTwoGrowth
+	{
+		// 不小于n的最小桶数
+		static size_t BucketCount(size_t n)
+		{
+			size_t count = 8;
+			while (count < n)
+			{
+				count <<= 1;
+			}
+			return count;
+		}
+
+		void Reset(size_t bucketCount)
+		{
+			_mask = bucketCount - 1;
+		}
+
+		size_t Index(size_t hash) const
+		{
+			return hash & _mask;
+		}
+
+		size_t _mask = 0;
+	};
+
+	// 桶数取素数，按哈希值取模；哈希函数比较弱（低位分布差）时更稳
+	struct PrimeGrowth
+	{
+		static size_t BucketCount(size_t n)
+		{
+			static const size_t primes[] =
+			{
+				11, 23, 53, 97, 193, 389, 769, 1543, 3079, 6151, 12289, 24593,
+				49157, 98317, 196613, 393241, 786433, 1572869, 3145739, 6291469,
+				12582917, 25165843, 50331653, 100663319, 201326611, 402653189,
+				805306457, 1610612741, 3221225473ul, 4294967291ul
+			};
+			for (size_t p : primes)
+			{
+				if (p >= n)
+					return p;
+			}
+			return primes[sizeof(primes) / sizeof(primes[0]) - 1];
+		}
+
+		void Reset(size_t bucketCount)
+		{
+			_bucketCount = bucketCount;
+		}
+
+		size_t Index(size_t hash) const
+		{
+			return hash % _bucketCount;
+		}
+
+		size_t _bucketCount = 1;
+	};
+
+	// 桶数组：用calloc申请。大块内存由系统按页惰性清零，
+	// 扩容时申请新桶数组几乎不花时间，不会像vector那样先逐个写一遍nullptr
+	template<class Node>
+	class BucketArray
+	{
+	public:
+		BucketArray() = default;
+
+		explicit BucketArray(size_t n)
+			:_buckets((Node**)calloc(n, sizeof(Node*)))
+			,_size(n)
+		{
+			if (_buckets == nullptr)
+				throw bad_alloc();
+		}
+
+		BucketArray(const BucketArray&) = delete;
+		BucketArray& operator=(const BucketArray&) = delete;
+
+		~BucketArray()
+		{
+			free(_buckets);
+		}
+
+		void swap(BucketArray& other)
+		{
+			std::swap(_buckets, other._buckets);
+			std::swap(_size, other._size);
+		}
+
+		void clear()
+		{
+			BucketArray().swap(*this);
+		}
+
+		size_t size() const
+		{
+			return _size;
+		}
+
+		bool empty() const
+		{
+			return _size == 0;
+		}
+
+		Node*& operator[](size_t i)
+		{
+			return _buckets[i];
+		}
+
+		Node* operator[](size_t i) const
+		{
+			return _buckets[i];
+		}
+
+	private:
+		Node** _buckets = nullptr;
+		size_t _size = 0;
+	};
+
 	// 前置声明哈希表类，因为迭代器需要用到
-	template<class K, class T, class KeyOfT, class Hash>
+	template<class K, class T, class KeyOfT, class Hash, class Growth, class Alloc>
 	class HashTable;
 
 	// 哈希表迭代器模板类
-	template<class K, class T, class Ref, class Ptr, class KeyOfT, class Hash>
+	template<class K, class T, class Ref, class Ptr, class KeyOfT, class Hash, class Growth, class Alloc>
 	struct __HTIterator
 	{
 		typedef HashNode<T> Node;
-		typedef __HTIterator<K, T, Ref, Ptr, KeyOfT, Hash> Self;  // 迭代器自身类型别名
+		typedef __HTIterator<K, T, Ref, Ptr, KeyOfT, Hash, Growth, Alloc> Self;  // 迭代器自身类型别名
+		typedef __HTIterator<K, T, T&, T*, KeyOfT, Hash, Growth, Alloc> Iterator;  // 普通迭代器类型
 		Node* _node;
-		const HashTable<K, T, KeyOfT, Hash>* _pht;  // 指向所属哈希表的指针
+		const HashTable<K, T, KeyOfT, Hash, Growth, Alloc>* _pht;  // 指向所属哈希表的指针
 		// vector<Node*> * _ptb;
 		size_t _hashi;   // 当前桶的索引
 
 		// 构造函数（非const版本）
-		__HTIterator(Node* node, HashTable<K, T, KeyOfT, Hash>* pht, size_t hashi)
+		__HTIterator(Node* node, HashTable<K, T, KeyOfT, Hash, Growth, Alloc>* pht, size_t hashi)
 			:_node(node)
 			,_pht(pht)
 			,_hashi(hashi)
 		{}
 
 		// 构造函数（const版本）
-		__HTIterator(Node* node, const HashTable<K, T, KeyOfT, Hash>* pht, size_t hashi)
+		__HTIterator(Node* node, const HashTable<K, T, KeyOfT, Hash, Growth, Alloc>* pht, size_t hashi)
 			:_node(node)
 			, _pht(pht)
 			, _hashi(hashi)
 		{}
 
+		// 允许iterator隐式转成const_iterator；模板构造函数不算拷贝构造，iterator自己的拷贝/赋值照常隐式生成
+		template<class It>
+			requires std::is_same_v<It, Iterator> && (!std::is_same_v<It, Self>)
+		__HTIterator(const It& it)
+			:_node(it._node)
+			, _pht(it._pht)
+			, _hashi(it._hashi)
+		{}
+
 		// 前置++运算符重载
 		Self& operator++()
 		{
@@ -261,18 +463,20 @@ namespace pzh_hash_bucket
 				//KeyOfT kot;
 				//Hash hf;
 				//size_t hashi = hf(kot(_node->_data)) % _pht._tables.size();
+				// 渐进式迁移过程中旧表和新表的桶连续编号，旧表在前
 				++_hashi;
-				while (_hashi < _pht->_tables.size())
+				size_t total = _pht->TotalBuckets();
+				while (_hashi < total)
 				{
-					if (_pht->_tables[_hashi])
+					if (_pht->BucketAt(_hashi))
 					{
-						_node = _pht->_tables[_hashi];
+						_node = _pht->BucketAt(_hashi);
 						break;
 					}
 
 					++_hashi;
 				}
-				if (_hashi == _pht->_tables.size())
+				if (_hashi == total)
 				{
 					_node = nullptr;
 				}
@@ -291,35 +495,42 @@ namespace pzh_hash_bucket
 			return &_node->_data;
 		}
 
-		bool operator!=(const Self& s)
+		bool operator!=(const Self& s) const
 		{
 			return _node != s._node;
 		}
+
+		bool operator==(const Self& s) const
+		{
+			return _node == s._node;
+		}
 	};
 
 	// 哈希表模板类
 	// unordered_set -> Hashtable<K, K>
 	// unordered_map -> Hashtable<K, pair<K, V>>
-	template<class K, class T, class KeyOfT, class Hash>
+	// Alloc是元素的分配器，内部rebind成节点的分配器，比如传pzh::pool_allocator<T>让节点走内存池
+	template<class K, class T, class KeyOfT, class Hash, class Growth = PowerOfTwoGrowth, class Alloc = std::allocator<T>>
 	class HashTable
 	{
 		typedef HashNode<T> Node;
+		typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc;
 
 		// 声明迭代器为友元类，使其可以访问私有成员
-		template<class K1, class T1, class Ref, class Ptr, class KeyOfT1, class Hash1>
+		template<class K1, class T1, class Ref, class Ptr, class KeyOfT1, class Hash1, class Growth1, class Alloc1>
 		friend struct __HTIterator;
 
 	public:
-		typedef __HTIterator<K, T, T&, T*, KeyOfT, Hash> iterator;  // 迭代器类型别名
-		typedef __HTIterator<K, T, const T&, const T*, KeyOfT, Hash> const_iterator;
+		typedef __HTIterator<K, T, T&, T*, KeyOfT, Hash, Growth, Alloc> iterator;  // 迭代器类型别名
+		typedef __HTIterator<K, T, const T&, const T*, KeyOfT, Hash, Growth, Alloc> const_iterator;
 
 		iterator begin()
 		{
-			for (size_t i = 0; i < _tables.size(); i++)
+			for (size_t i = 0; i < TotalBuckets(); i++)
 			{
-				if (_tables[i])
+				if (BucketAt(i))
 				{
-					return iterator(_tables[i], this, i);
+					return iterator(BucketAt(i), this, i);
 				}
 			}
 			return end();
@@ -333,17 +544,17 @@ namespace pzh_hash_bucket
 
 		const_iterator begin() const
 		{
-			for (size_t i = 0; i < _tables.size(); i++)
+			for (size_t i = 0; i < TotalBuckets(); i++)
 			{
-				if (_tables[i])
+				if (BucketAt(i))
 				{
-					return const_iterator(_tables[i], this, i);
+					return const_iterator(BucketAt(i), this, i);
 				}
 			}
 			return end();
 		}
 
-		// this-> const HashTable<K, T, KeyOfT, Hash>*
+		// this-> const HashTable<K, T, KeyOfT, Hash, Growth, Alloc>*
 		const_iterator end() const
 		{
 			return const_iterator(nullptr, this, -1);
@@ -351,100 +562,86 @@ namespace pzh_hash_bucket
 
 		HashTable()
 		{
-			_tables.resize(10);
+			BucketArray<Node>(Growth::BucketCount(10)).swap(_tables);
+			_growth.Reset(_tables.size());
 		}
 
 		~HashTable()
 		{
-			for (size_t i = 0; i < _tables.size(); i++)
+			for (size_t i = 0; i < TotalBuckets(); i++)
 			{
-				Node* cur = _tables[i];
+				Node* cur = BucketAt(i);
 				while (cur)
 				{
 					Node* next = cur->_next;
-					delete cur;
+					DestroyNode(cur);
 					cur = next;
 				}
-				_tables[i] = nullptr;
 			}
 		}
 
-		// 插入元素
+		// 插入元素：key只计算一次哈希，查重、扩容、定位桶都复用这个值
 		pair<iterator, bool> Insert(const T& data)
 		{
-			Hash hf;
 			KeyOfT kot;   // 提取键的函数对象
-			iterator it = Find(kot(data));  // 先查找是否已存在相同键
-			if (it != end())
-				return make_pair(it, false);
-			// 负载因子最大到1
-			if (_n == _tables.size())
-			{
-				vector<Node*> newTables;
-				newTables.resize(_tables.size() * 2, nullptr);
-				// 遍历旧表
-				for (size_t i = 0; i < _tables.size(); i++)
-				{
-					Node* cur = _tables[i];
-					while(cur)
-					{
-						Node* next = cur->_next;
-						// 挪动到映射的新表
-						size_t hashi = hf(kot(cur->_data)) % newTables.size();
-						cur->_next = newTables[i];
-						newTables[hashi] = cur;
-						cur = next;
-					}
-					_tables[i] = nullptr;
-				}
-				_tables.swap(newTables);
-			}
-			size_t hashi = hf(kot(data)) % _tables.size();
-			Node* newnode = new Node(data);
-			// 头插
-			newnode->_next = _tables[hashi];
-			_tables[hashi] = newnode;
-			++_n;
-			return make_pair(iterator(newnode, this, hashi), true);
+			Hash hf;      // 哈希函数对象
+			const K& key = kot(data);
+			size_t hash = hf(key);
+			RehashStep();
+			return InsertNode(hash, FindNode(key, hash), hash, data);
+		}
+
+		// key不存在时才用args构造元素，存在时什么都不构造
+		template<class... Args>
+		pair<iterator, bool> Emplace(const K& key, Args&&... args)
+		{
+			Hash hf;
+			size_t hash = hf(key);
+			RehashStep();
+			return InsertNode(hash, FindNode(key, hash), hash, std::forward<Args>(args)...);
 		}
 
 		iterator Find(const K& key)
 		{
 			Hash hf;     // 哈希函数对象
-			KeyOfT kot;  // 提取键的函数对象
-			size_t hashi = hf(key) % _tables.size();
-			Node* cur = _tables[hashi];
-			while (cur)
-			{
-				if (kot(cur->_data) == key)
-				{
-					return iterator(cur, this, hashi);
-				}
-				cur = cur->_next;
-			}
-			return end();
+			RehashStep();
+			return FindNode(key, hf(key));
+		}
+
+		// 哈希函数带is_transparent时，可以不构造K直接查找（比如用const char*查string）
+		template<class KeyLike>
+			requires requires { typename Hash::is_transparent; }
+		iterator Find(const KeyLike& key)
+		{
+			Hash hf;
+			RehashStep();
+			return FindNode(key, hf(key));
 		}
 
 		bool Erase(const K& key)
 		{
 			Hash hf;
 			KeyOfT kot;
-			size_t hashi = hf(key) % _tables.size();
+			size_t hash = hf(key);
+			RehashStep();
+			size_t hashi;
+			Node*& bucket = BucketOf(hash, hashi);
 			Node* prev = nullptr;
-			Node* cur = _tables[hashi];
+			Node* cur = bucket;
 			while (cur)
 			{
-				if (kot(cur->_data) == key)
+				if (cur->_hash == hash && kot(cur->_data) == key)
 				{
 					if (prev == nullptr)
 					{
-						_tables[hashi] = cur->_next;
+						bucket = cur->_next;
 					}
 					else
 					{
 						prev->_next = cur->_next;
 					}
-					delete cur;
+					DestroyNode(cur);
+					--_n;
 					return true;
 				}
 				prev = cur;
@@ -453,6 +650,66 @@ namespace pzh_hash_bucket
 			return false;
 		}
 
+		// 按迭代器删除，返回下一个元素的迭代器：迭代器里记着所在的桶，
+		// 不用重新计算哈希，只在这个桶里找前驱（桶平均长度不超过负载因子，期望O(1)）。
+		// 不推进渐进式迁移，边遍历边删除时桶编号保持稳定
+		iterator Erase(const_iterator pos)
+		{
+			Node* node = pos._node;
+			const_iterator next = pos;
+			++next;
+			Node*& bucket = BucketRef(pos._hashi);
+			if (bucket == node)
+			{
+				bucket = node->_next;
+			}
+			else
+			{
+				Node* prev = bucket;
+				while (prev->_next != node)
+				{
+					prev = prev->_next;
+				}
+				prev->_next = node->_next;
+			}
+			DestroyNode(node);
+			--_n;
+			return iterator(next._node, this, next._hashi);
+		}
+
+		// 删除所有满足pred的元素，一趟扫完所有桶，返回删除的个数
+		template<class Pred>
+		size_t EraseIf(Pred pred)
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < TotalBuckets(); i++)
+			{
+				Node** link = &BucketRef(i);
+				while (*link)
+				{
+					Node* cur = *link;
+					if (pred(cur->_data))
+					{
+						*link = cur->_next;
+						DestroyNode(cur);
+						++count;
+					}
+					else
+					{
+						link = &cur->_next;
+					}
+				}
+			}
+			_n -= count;
+			return count;
+		}
+
+		// 大量删除之后收缩桶数组：桶数降到刚好满足最大负载因子
+		void ShrinkToFit()
+		{
+			Rehash(0);
+		}
+
 		// 统计哈希表信息
 		void Some()
 		{
@@ -460,9 +717,9 @@ namespace pzh_hash_bucket
 			size_t maxBucketLen = 0;
 			size_t sum = 0;
 			double averageBucketLen = 0;
-			for (size_t i = 0; i < _tables.size(); i++)
+			for (size_t i = 0; i < TotalBuckets(); i++)
 			{
-				Node* cur = _tables[i];
+				Node* cur = BucketAt(i);
 				if (cur)
 				{
 					++bucketSize;
@@ -486,8 +743,270 @@ namespace pzh_hash_bucket
 			printf("averageBucketLen:%lf\n\n", averageBucketLen);
 		}
 
+		size_t Size() const
+		{
+			return _n;
+		}
+
+		size_t BucketCount() const
+		{
+			return _tables.size();
+		}
+
+		float LoadFactor() const
+		{
+			return (float)_n / (float)_tables.size();
+		}
+
+		float MaxLoadFactor() const
+		{
+			return _maxLoadFactor;
+		}
+
+		void MaxLoadFactor(float ml)
+		{
+			assert(ml > 0);
+			_maxLoadFactor = ml;
+			Rehash(0);
+		}
+
+		// 渐进式rehash（类似Redis的dict）：扩容时新旧两个桶数组同时存在，
+		// 之后每次Insert/Find/Erase顺带迁移几个旧桶，避免一次性搬完所有节点造成的长尾延迟。
+		// 迁移进行中的任何操作都可能改变遍历顺序，已有迭代器需要重新获取（节点和引用不受影响）
+		void IncrementalRehash(bool on)
+		{
+			if (!on)
+			{
+				FinishRehash();
+			}
+			_incremental = on;
+		}
+
+		bool Rehashing() const
+		{
+			return !_oldTables.empty();
+		}
+
+		// 桶数调整到至少n个，同时保证不超过最大负载因子
+		void Rehash(size_t n)
+		{
+			size_t need = (size_t)ceil(_n / _maxLoadFactor);
+			size_t count = Growth::BucketCount(n > need ? n : need);
+			if (count != _tables.size())
+			{
+				Relink(count);
+			}
+		}
+
+		// 预留能放下n个元素的桶，批量插入前调用可以避免中途多次扩容
+		void Reserve(size_t n)
+		{
+			size_t count = Growth::BucketCount((size_t)ceil(n / _maxLoadFactor));
+			if (count > _tables.size())
+			{
+				Relink(count);
+			}
+		}
+
 	private:
-		vector<Node*> _tables;
+		// 每次操作最多迁移的旧桶数，以及最多跳过的空桶数
+		static const size_t kRehashBuckets = 4;
+		static const size_t kRehashEmptyVisits = kRehashBuckets * 10;
+
+		// 旧表和新表的桶连续编号，旧表在前；不在迁移时只有新表
+		size_t TotalBuckets() const
+		{
+			return _oldTables.size() + _tables.size();
+		}
+
+		Node* BucketAt(size_t i) const
+		{
+			return i < _oldTables.size() ? _oldTables[i] : _tables[i - _oldTables.size()];
+		}
+
+		Node*& BucketRef(size_t i)
+		{
+			return i < _oldTables.size() ? _oldTables[i] : _tables[i - _oldTables.size()];
+		}
+
+		// 哈希值对应的桶：迁移中旧表里还没迁走的桶仍然有效，否则在新表。
+		// 每个key同一时刻只会在其中一个桶里，查找和插入都按这个规则定位。
+		// hashi返回迭代器用的全局桶编号
+		Node*& BucketOf(size_t hash, size_t& hashi)
+		{
+			if (Rehashing())
+			{
+				size_t oldi = _oldGrowth.Index(hash);
+				if (oldi >= _rehashIdx)
+				{
+					hashi = oldi;
+					return _oldTables[oldi];
+				}
+			}
+			size_t i = _growth.Index(hash);
+			hashi = _oldTables.size() + i;
+			return _tables[i];
+		}
+
+		// 开始渐进式迁移：当前桶数组变成旧表，新表为空
+		void StartRehash(size_t bucketCount)
+		{
+			FinishRehash();
+			_oldTables.swap(_tables);
+			_oldGrowth = _growth;
+			BucketArray<Node>(bucketCount).swap(_tables);
+			_growth.Reset(bucketCount);
+			_rehashIdx = 0;
+		}
+
+		// 迁移至多kRehashBuckets个非空旧桶，旧表迁完就释放
+		void RehashStep(size_t buckets = kRehashBuckets)
+		{
+			if (!Rehashing())
+				return;
+			size_t emptyVisits = kRehashEmptyVisits;
+			while (buckets > 0 && _rehashIdx < _oldTables.size())
+			{
+				Node* cur = _oldTables[_rehashIdx];
+				if (cur == nullptr)
+				{
+					++_rehashIdx;
+					if (--emptyVisits == 0)
+						break;
+					continue;
+				}
+				while (cur)
+				{
+					Node* next = cur->_next;
+					size_t hashi = _growth.Index(cur->_hash);
+					cur->_next = _tables[hashi];
+					_tables[hashi] = cur;
+					cur = next;
+				}
+				_oldTables[_rehashIdx++] = nullptr;
+				--buckets;
+			}
+			if (_rehashIdx == _oldTables.size())
+			{
+				_oldTables.clear();
+				_rehashIdx = 0;
+			}
+		}
+
+		void FinishRehash()
+		{
+			while (Rehashing())
+			{
+				RehashStep(_oldTables.size());
+			}
+		}
+
+		// 把所有节点重新挂到bucketCount个桶上：
+		// 只换桶数组，节点原地摘下来头插到新桶，不分配/释放节点，也不重新计算哈希
+		void Relink(size_t bucketCount)
+		{
+			FinishRehash();
+			BucketArray<Node> newTables(bucketCount);
+			Growth newGrowth;
+			newGrowth.Reset(bucketCount);
+			for (size_t i = 0; i < _tables.size(); i++)
+			{
+				Node* cur = _tables[i];
+				while (cur)
+				{
+					Node* next = cur->_next;
+					size_t hashi = newGrowth.Index(cur->_hash);
+					cur->_next = newTables[hashi];
+					newTables[hashi] = cur;
+					cur = next;
+				}
+			}
+			_tables.swap(newTables);
+			_growth = newGrowth;
+		}
+
+		// 按已经算好的哈希值查找，先比较缓存的哈希值再比较key
+		template<class KeyLike>
+		iterator FindNode(const KeyLike& key, size_t hash)
+		{
+			KeyOfT kot;  // 提取键的函数对象
+			size_t hashi;
+			Node* cur = BucketOf(hash, hashi);
+			while (cur)
+			{
+				if (cur->_hash == hash && kot(cur->_data) == key)
+				{
+					return iterator(cur, this, hashi);
+				}
+				cur = cur->_next;
+			}
+			return end();
+		}
+
+		// it是FindNode的结果，已存在就直接返回，否则用args构造新节点头插
+		template<class... Args>
+		pair<iterator, bool> InsertNode(size_t hash, iterator it, Args&&... args)
+		{
+			if (it != end())
+				return make_pair(it, false);
+			// 超过最大负载因子就把桶数翻倍
+			if (_n + 1 > _tables.size() * _maxLoadFactor)
+			{
+				if (_incremental)
+					StartRehash(Growth::BucketCount(_tables.size() * 2));
+				else
+					Relink(Growth::BucketCount(_tables.size() * 2));
+			}
+			size_t hashi;
+			Node*& bucket = BucketOf(hash, hashi);
+			Node* newnode = CreateNode(std::forward<Args>(args)...);
+			// 头插
+			newnode->_next = bucket;
+			bucket = newnode;
+			++_n;
+			return make_pair(iterator(newnode, this, hashi), true);
+		}
+
+		template<class... Args>
+		Node* CreateNode(Args&&... args)
+		{
+			return pzh::__AllocateNode(_alloc, std::forward<Args>(args)...);
+		}
+
+		void DestroyNode(Node* node)
+		{
+			pzh::__DestroyNode(_alloc, node);
+		}
+
+	private:
+		BucketArray<Node> _tables;
 		size_t _n = 0;
+		[[no_unique_address]] NodeAlloc _alloc;
+		Growth _growth;              // 桶数增长策略（保存掩码或素数桶数）
+		float _maxLoadFactor = 1.0f; // 最大负载因子
+
+		// 渐进式rehash
+		bool _incremental = false;   // 是否开启渐进式rehash
+		BucketArray<Node> _oldTables; // 迁移中的旧桶数组，不在迁移时为空
+		Growth _oldGrowth;           // 旧桶数组的映射方式
+		size_t _rehashIdx = 0;       // 旧表中下一个要迁移的桶
 	};
-}
\ No newline at end of file
+}
+
+namespace pzh
+{
+	// 哈希表后端策略：作为 unordered_map/unordered_set 的模板参数选择底层实现
+	// 默认的链地址法哈希桶
+	// AllocT是分配器模板，比如std::allocator或pzh::pool_allocator
+	template<class Growth, template<class> class AllocT = std::allocator>
+	struct basic_hash_bucket_policy
+	{
+		template<class K, class T, class KeyOfT, class Hash>
+		using Table = pzh_hash_bucket::HashTable<K, T, KeyOfT, Hash, Growth, AllocT<T>>;
+	};
+
+	// 桶数取2的幂（默认）
+	typedef basic_hash_bucket_policy<pzh_hash_bucket::PowerOfTwoGrowth> hash_bucket_policy;
+	// 桶数取素数，适合低位分布差的哈希函数
+	typedef basic_hash_bucket_policy<pzh_hash_bucket::PrimeGrowth> hash_bucket_prime_policy;
+}
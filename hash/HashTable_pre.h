@@ -1,49 +1,26 @@
 #pragma once
 #include <vector>
-
-template<class K>
-    // Ĭϵķºܣֱӽת
-struct HashFunc
-{
-    size_t operator()(const K& key)
-    {
-        // keyֵתsize_tֱͣӽת
-        return (size_t)key;
-    }
-};
-
-// stringͽתstringػ汾
-template<>
-struct HashFunc<string>
-{
-    size_t operator()(const string& key)
-    {
-        size_t hash = 0;
-        for (auto e : key)
-        {
-            hash *= 31;
-            hash += e;
-        }
-        cout << key << ":" << hash << endl;
-        return hash;
-    }
-};
+#include "HashFunc.h"
 
 // ŵַ
+// Robin Hood̽⣺ʱٸƶ̵̽Ԫظ볤λ
+// Ԫص̽붼ȽƽɾʱѺԪǰһbackward shiftĹ
+// ̽ͼֵԷţʱ˳ɨ1ֽڵľ飬ֻоǺϲȥȽkey
 namespace pzh_open_address
 {
-    enum Status
+    // ̽ⳤͳƣָԪʵλϣʼλõĸ
+    struct ProbeStats
     {
-        EMPTY,
-        EXIST,
-        DELETE
-    };
+        size_t _size;        // Ԫظ
+        size_t _capacity;    // 
+        double _avgProbe;    // ƽ̽루ҳɹʱҪȽϵĴ - 1
+        size_t _maxProbe;    // ̽
 
-    template<class K, class V>
-    struct HashData
-    {
-        pair<K, V> _kv;
-        Status _s; //״̬
+        void Print() const
+        {
+            printf("size:%zu capacity:%zu load:%.2f avg probe:%.2f max probe:%zu\n",
+                   _size, _capacity, _capacity ? (double)_size / _capacity : 0.0, _avgProbe, _maxProbe);
+        }
     };
 
     //Ϊеkeyļȡģ㣬ҪºHash
@@ -53,99 +30,156 @@ namespace pzh_open_address
     public:
         HashTable_pre()
         {
-            _tables.resize(10);  //һʼ͸ϣһռ
+            Allocate(16);  //һʼ͸ϣһռ䣬2
         }
 
         bool Insert(const pair<K, V> &kv)
         {
             if (Find(kv.first))
                 return false;
-            // 0.7
-            if (_n * 10 / _tables.size() == 7)
+            // ӳ7/8ݣRobin Hoodڸ߸̽Ȼ̣ܶ
+            if ((_n + 1) * 8 > _kvs.size() * 7)
             {
-                size_t newSize = _tables.size() * 2;  //ɱԭ2
-                HashTable_pre<K, V, Hash> newHT;  // Ҫӳ
-                newHT._tables.resize(newSize);
-                // ɱ
-                for (size_t i = 0; i < _tables.size(); i++)
-                {
-                    if (_tables[i]._s == EXIST)
-                    {
-                        newHT.Insert(_tables[i]._kv);
-                    }
-                }
-                // ¾ɱĴ洢ռ
-                _tables.swap(newHT._tables);
+                Resize(_kvs.size() * 2);
             }
-            Hash hf;
-            size_t hashi = hf(kv.first) % _tables.size();  // ʼĵһλ
-            while (_tables[hashi]._s == EXIST)  //ʼλõ״̬ǡڡ
-            {
-                hashi++;
-                hashi %= _tables.size();
-            }
-            _tables[hashi]._kv = kv;
-            _tables[hashi]._s = EXIST;
+            InsertNoCheck(kv);
             ++_n;
             return true;
         }
 
-        HashData<K, V>* Find(const K& key)
+        pair<K, V>* Find(const K& key)
         {
-            Hash hf;
-            size_t hashi = hf(key) % _tables.size();
-            while (_tables[hashi]._s != EMPTY)
-            {
-                if (_tables[hashi]._s == EXIST && _tables[hashi]._kv.first == key)
-                {
-                    return &_tables[hashi];
-                }
-                hashi++;
-                hashi %= _tables.size();
-            }
-            return NULL;
+            size_t i = FindIndex(key);
+            return i == _kvs.size() ? nullptr : &_kvs[i];
         }
 
-        // αɾ
-        /*ɾ3ٲ3ֻǸı״̬ûɾֵ*/
+        // ɾѺ̽벻Ϊ0Ԫǰһ񣬱ʼûĹ
         bool Erase(const K& key)
         {
-            HashData<K, V>* ret = Find(key);
-            if (ret)
+            size_t i = FindIndex(key);
+            if (i == _kvs.size())
+                return false;
+            size_t mask = _kvs.size() - 1;
+            size_t next = (i + 1) & mask;
+            while (_dist[next] > 1)
             {
-                ret->_s = DELETE;
-                --_n;
-                return true;
+                _kvs[i] = std::move(_kvs[next]);
+                _dist[i] = _dist[next] - 1;
+                i = next;
+                next = (next + 1) & mask;
             }
-            else
+            _kvs[i] = pair<K, V>();
+            _dist[i] = 0;
+            --_n;
+            return true;
+        }
+
+        ProbeStats Stats() const
+        {
+            size_t sum = 0, maxProbe = 0;
+            for (size_t i = 0; i < _dist.size(); i++)
             {
-                return false;
+                if (_dist[i])
+                {
+                    size_t probe = _dist[i] - 1;
+                    sum += probe;
+                    if (probe > maxProbe)
+                        maxProbe = probe;
+                }
             }
+            return ProbeStats{_n, _kvs.size(), _n ? (double)sum / _n : 0.0, maxProbe};
+        }
+
+        size_t Size() const
+        {
+            return _n;
         }
 
         void Print()
         {
-            for (size_t i = 0; i < _tables.size(); i++)
+            for (size_t i = 0; i < _kvs.size(); i++)
             {
-                if (_tables[i]._s == EXIST)
+                if (_dist[i])
                 {
-                    //printf("[%d]->%d\n", i, _tables[i]._kv.first);
-                    cout << "[" << i << "]->" << _tables[i]._kv.first <<":" << _tables[i]._kv.second<< endl;
-                }
-                else if (_tables[i]._s == EMPTY)
-                {
-                    printf("[%d]->\n", i);
+                    cout << "[" << i << "]->" << _kvs[i].first << ":" << _kvs[i].second
+                         << " (probe " << _dist[i] - 1 << ")" << endl;
                 }
                 else
                 {
-                    printf("[%d]->D\n", i);
+                    printf("[%zu]->\n", i);
                 }
             }
             cout << endl;
         }
 
     private:
-        vector<HashData<K, V>> _tables;
+        // ǵ254Զ
+        static const uint8_t kMaxDist = 255;
+
+        size_t FindIndex(const K& key) const
+        {
+            Hash hf;
+            size_t mask = _kvs.size() - 1;
+            size_t i = hf(key) & mask;
+            // ǰλԪص̽Ѿ߹Ļ̣˵key͸ó
+            for (uint8_t d = 1; _dist[i] >= d; ++d)
+            {
+                if (_dist[i] == d && _kvs[i].first == key)
+                    return i;
+                i = (i + 1) & mask;
+            }
+            return _kvs.size();
+        }
+
+        // صĲ룺̽ߣԼ̣ԪؾͽűԪؼλ
+        void InsertNoCheck(pair<K, V> kv)
+        {
+            Hash hf;
+            size_t mask = _kvs.size() - 1;
+            size_t i = hf(kv.first) & mask;
+            uint8_t d = 1;  // +10ղ
+            while (_dist[i] != 0)
+            {
+                if (_dist[i] < d)
+                {
+                    swap(kv, _kvs[i]);
+                    swap(d, _dist[i]);
+                }
+                i = (i + 1) & mask;
+                if (++d == kMaxDist)
+                {
+                    // ̫̽ϣ̫ݺ²Ԫ
+                    Resize(_kvs.size() * 2);
+                    InsertNoCheck(std::move(kv));
+                    return;
+                }
+            }
+            _kvs[i] = std::move(kv);
+            _dist[i] = d;
+        }
+
+        void Allocate(size_t capacity)
+        {
+            _kvs.assign(capacity, pair<K, V>());
+            _dist.assign(capacity, 0);
+        }
+
+        void Resize(size_t newCapacity)
+        {
+            vector<pair<K, V>> oldKvs;
+            vector<uint8_t> oldDist;
+            oldKvs.swap(_kvs);
+            oldDist.swap(_dist);
+            Allocate(newCapacity);
+            for (size_t i = 0; i < oldKvs.size(); i++)
+            {
+                if (oldDist[i])
+                    InsertNoCheck(std::move(oldKvs[i]));
+            }
+        }
+
+        vector<pair<K, V>> _kvs;   // ֵ
+        vector<uint8_t> _dist;     // ̽+10ʾղ
         size_t _n = 0; // 洢Ĺؼֵĸ
     };
 
@@ -184,10 +218,10 @@ namespace pzh_open_address
         for (auto& e : arr)
         {
             //auto ret = ht.Find(e);
-            HashData<string, int>* ret = ht.Find(e);
+            pair<string, int>* ret = ht.Find(e);
             if (ret)
             {
-                ret->_kv.second++;
+                ret->second++;
             }
             else
             {
@@ -202,6 +236,31 @@ namespace pzh_open_address
         ht.Insert(make_pair("aad", 1));
         ht.Print();
     }
+
+    // /ɾ֮̽ⳤȲ䳤std::unordered_map
+    void TestHT3()
+    {
+        HashTable_pre<int, int> ht;
+        std::unordered_map<int, int> ref;
+        srand(3);
+        bool ok = true;
+        for (int i = 0; i < 200000 && ok; i++)
+        {
+            int key = rand() % 20000;
+            if (rand() % 2)
+                ok = ht.Insert(make_pair(key, i)) == ref.insert(make_pair(key, i)).second;
+            else
+                ok = ht.Erase(key) == (ref.erase(key) == 1);
+        }
+        for (auto& kv : ref)
+        {
+            pair<int, int>* ret = ht.Find(kv.first);
+            ok = ok && ret && ret->second == kv.second;
+        }
+        ok = ok && ht.Size() == ref.size();
+        cout << "robin hood check:" << (ok ? "ok" : "error") << "  ";
+        ht.Stats().Print();
+    }
 }
 
 // ϣͰ
@@ -1,20 +1,28 @@
 #pragma once
 #include"HashTable.h"
+#include"FlatHashTable.h"
+#include<tuple>
+#include<unordered_map>
 
 namespace pzh
 {
-    template<class K, class V, class Hash = HashFunc<K>>
+    // Policy 选择底层哈希表：hash_bucket_policy（链地址法，默认）或 flat_hash_policy（扁平开放定址）
+    template<class K, class V, class Hash = HashFunc<K>, class Policy = hash_bucket_policy>
     class unordered_map
     {
         struct MapKeyOfT
         {
-            const K& operator()(const pair<K, V>& kv)
+            // 参数必须是pair<const K, V>，否则每次取key都会先拷贝出一个临时pair
+            const K& operator()(const pair<const K, V>& kv)
             {
                 return kv.first;
             }
         };
+
+        typedef typename Policy::template Table<K, pair<const K, V>, MapKeyOfT, Hash> HT;
     public:
-        typedef typename pzh_hash_bucket::HashTable<K, pair<const K, V>, MapKeyOfT, Hash>::iterator iterator;
+        typedef typename HT::iterator iterator;
+        typedef typename HT::const_iterator const_iterator;
 
         iterator begin()
         {
@@ -31,9 +39,35 @@ namespace pzh
             return _ht.Insert(kv);
         }
 
+        // key不存在时才用args构造value；已存在时args原封不动，也不会构造临时对象
+        template<class... Args>
+        pair<iterator, bool> try_emplace(const K& key, Args&&... args)
+        {
+            return _ht.Emplace(key, piecewise_construct, forward_as_tuple(key),
+                               forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        template<class... Args>
+        pair<iterator, bool> try_emplace(K&& key, Args&&... args)
+        {
+            // 先用key查找，确定要插入时才把key移动进节点
+            return _ht.Emplace(key, piecewise_construct, forward_as_tuple(std::move(key)),
+                               forward_as_tuple(std::forward<Args>(args)...));
+        }
+
+        // 和标准库一样，需要先构造出元素才能拿到key；
+        // 构造好的元素直接移动进节点，不会再拷贝
+        template<class... Args>
+        pair<iterator, bool> emplace(Args&&... args)
+        {
+            pair<K, V> kv(std::forward<Args>(args)...);
+            return _ht.Emplace(kv.first, std::move(kv));
+        }
+
         V& operator[](const K& key)
         {
-            pair<iterator, bool> ret = _ht.Insert(make_pair(key, V()));
+            // key已存在时不再构造V()
+            pair<iterator, bool> ret = try_emplace(key);
             return ret.first->second;
         }
 
@@ -48,13 +82,83 @@ namespace pzh
             return _ht.Find(key);
         }
 
+        // 异构查找：Hash带is_transparent时，find("abc")不会先构造string
+        template<class KeyLike>
+            requires requires { typename Hash::is_transparent; }
+        iterator find(const KeyLike& key)
+        {
+            return _ht.Find(key);
+        }
+
         bool erase(const K& key)
         {
             return _ht.Erase(key);
         }
 
+        // 按迭代器删除，返回下一个元素；可以边遍历边删除：it = m.erase(it)
+        iterator erase(const_iterator pos)
+        {
+            return _ht.Erase(pos);
+        }
+
+        // 一趟删除所有满足pred的元素，返回删除的个数
+        template<class Pred>
+        size_t erase_if(Pred pred)
+        {
+            return _ht.EraseIf(pred);
+        }
+
+        // 大量删除之后把桶数组收缩到刚好够用
+        void shrink_to_fit()
+        {
+            _ht.ShrinkToFit();
+        }
+
+        size_t size() const
+        {
+            return _ht.Size();
+        }
+
+        size_t bucket_count() const
+        {
+            return _ht.BucketCount();
+        }
+
+        float load_factor() const
+        {
+            return _ht.LoadFactor();
+        }
+
+        float max_load_factor() const
+        {
+            return _ht.MaxLoadFactor();
+        }
+
+        void max_load_factor(float ml)
+        {
+            _ht.MaxLoadFactor(ml);
+        }
+
+        // 桶数调整到至少n个
+        void rehash(size_t n)
+        {
+            _ht.Rehash(n);
+        }
+
+        // 预留能放下n个元素的空间，之后插入n个元素都不会再扩容
+        void reserve(size_t n)
+        {
+            _ht.Reserve(n);
+        }
+
+        // 开启渐进式rehash（仅链地址法后端）：扩容分摊到之后的多次操作里完成
+        void incremental_rehash(bool on)
+        {
+            _ht.IncrementalRehash(on);
+        }
+
     private:
-        pzh_hash_bucket::HashTable<K, pair<const K, V>, MapKeyOfT, Hash> _ht;
+        HT _ht;
     };
 
     void test_map()
@@ -86,4 +190,175 @@ namespace pzh
         }
         cout << endl;
     }
+
+    // 扁平哈希表后端：和std::unordered_map做随机插入/删除对拍
+    void test_flat_map()
+    {
+        unordered_map<int, int, HashFunc<int>, flat_hash_policy> fm;
+        std::unordered_map<int, int> ref;
+        srand(1);
+        for (int i = 0; i < 200000; i++)
+        {
+            int key = rand() % 5000;
+            if (rand() % 3 == 0)
+            {
+                if (fm.erase(key) != (ref.erase(key) == 1))
+                {
+                    cout << "flat erase error:" << key << endl;
+                    return;
+                }
+            }
+            else
+            {
+                fm[key] += i;
+                ref[key] += i;
+            }
+        }
+        size_t count = 0;
+        for (auto& kv : fm)
+        {
+            auto it = ref.find(kv.first);
+            if (it == ref.end() || it->second != kv.second)
+            {
+                cout << "flat value error:" << kv.first << endl;
+                return;
+            }
+            ++count;
+        }
+        cout << "flat map check:" << (count == ref.size() ? "ok" : "size error") << endl;
+    }
+
+    // reserve/rehash/max_load_factor：预留之后批量插入不会再改变桶数
+    template<class Policy>
+    void test_reserve()
+    {
+        unordered_map<int, int, HashFunc<int>, Policy> m;
+        m.max_load_factor(0.5f);
+        m.reserve(1000);
+        size_t buckets = m.bucket_count();
+        for (int i = 0; i < 1000; i++)
+        {
+            m[i * 1024] = i;  // 低位全是0的key
+        }
+        bool ok = m.bucket_count() == buckets && m.load_factor() <= m.max_load_factor();
+        for (int i = 0; i < 1000; i++)
+        {
+            auto it = m.find(i * 1024);
+            ok = ok && it != m.end() && it->second == i;
+        }
+        m.rehash(m.bucket_count() * 4);
+        ok = ok && m.size() == 1000 && m.find(999 * 1024) != m.end();
+        cout << "reserve check:" << (ok ? "ok" : "error") << " buckets:" << m.bucket_count() << endl;
+    }
+
+    // 渐进式rehash：迁移过程中随机增删查，和std::unordered_map对拍
+    void test_incremental_rehash()
+    {
+        unordered_map<int, int> m;
+        m.incremental_rehash(true);
+        std::unordered_map<int, int> ref;
+        srand(2);
+        bool ok = true;
+        for (int i = 0; i < 300000 && ok; i++)
+        {
+            int key = rand() % 50000;
+            int op = rand() % 4;
+            if (op == 0 && key % 2 == 0)
+            {
+                ok = m.erase(key) == (ref.erase(key) == 1);
+            }
+            else if (op == 0)
+            {
+                // 按迭代器删除：迭代器记着迁移中的桶编号
+                auto it = m.find(key);
+                if (it != m.end())
+                    m.erase(it);
+                ok = (it != m.end()) == (ref.erase(key) == 1);
+            }
+            else if (op == 1)
+            {
+                auto it = m.find(key);
+                ok = (it == m.end()) == (ref.find(key) == ref.end());
+            }
+            else
+            {
+                m[key] = i;
+                ref[key] = i;
+            }
+        }
+        size_t count = 0;
+        for (auto& kv : m)
+        {
+            ok = ok && ref[kv.first] == kv.second;
+            ++count;
+        }
+        cout << "incremental rehash check:" << (ok && count == ref.size() && m.size() == ref.size() ? "ok" : "error") << endl;
+    }
+
+    // try_emplace：key已存在时实参不会被移动走
+    template<class Policy>
+    void test_try_emplace()
+    {
+        unordered_map<string, string, HashFunc<string>, Policy> dict;
+        string v1 = "排序";
+        auto ret1 = dict.try_emplace("sort", std::move(v1));
+        string v2 = "xx";
+        auto ret2 = dict.try_emplace("sort", std::move(v2));
+        auto ret3 = dict.emplace("left", "左边");
+        cout << "try_emplace:" << ret1.second << " " << ret2.second << " " << ret3.second
+             << " v2:" << v2 << " sort:" << dict["sort"] << " left:" << dict["left"] << endl;
+    }
+
+    template<class Policy>
+    void test_heterogeneous_find()
+    {
+        unordered_map<string, int, HashFunc<string>, Policy> m;
+        m["apple"] = 1;
+        m["banana"] = 2;
+        const char* key = "banana";
+        string_view sv("apple!", 5);
+        // 直接用const char*/string_view查找，不会构造临时string
+        auto it1 = m.find(key);
+        auto it2 = m.find(sv);
+        auto it3 = m.find("cherry");
+        bool ok = it1 != m.end() && it1->second == 2
+                  && it2 != m.end() && it2->second == 1
+                  && it3 == m.end();
+        cout << "heterogeneous find:" << (ok ? "ok" : "error") << endl;
+    }
+
+    // 删除：按key、按迭代器、erase_if之后size正确，shrink_to_fit能把桶数降下来
+    template<class Policy>
+    void test_erase()
+    {
+        unordered_map<int, int, HashFunc<int>, Policy> m;
+        const int N = 100000;
+        for (int i = 0; i < N; i++)
+            m[i] = i;
+        size_t buckets = m.bucket_count();
+        bool ok = true;
+        for (int i = 0; i < N; i += 4)
+            ok = ok && m.erase(i);
+        // 边遍历边按迭代器删掉奇数
+        auto it = m.begin();
+        while (it != m.end())
+        {
+            if (it->first % 2 == 1)
+                it = m.erase(it);
+            else
+                ++it;
+        }
+        ok = ok && m.size() == N / 4;
+        size_t removed = m.erase_if([](const pair<const int, int>& kv) { return kv.first % 8 == 2; });
+        ok = ok && removed == N / 8 && m.size() == N / 8;
+        m.shrink_to_fit();
+        for (int i = 0; i < N; i++)
+        {
+            bool expect = i % 8 == 6;
+            ok = ok && (m.find(i) != m.end()) == expect;
+        }
+        // 删除后负载因子不应该虚高：再插回去也不会触发不必要的扩容
+        ok = ok && m.bucket_count() < buckets && m.load_factor() <= m.max_load_factor();
+        cout << "erase check:" << (ok ? "ok" : "error") << " buckets:" << buckets << "->" << m.bucket_count() << endl;
+    }
 }
@@ -1,9 +1,10 @@
 #pragma once
 #include"HashTable.h"
+#include"FlatHashTable.h"
 
 namespace pzh
 {
-    template<class K, class Hash = HashFunc<K>>
+    template<class K, class Hash = HashFunc<K>, class Policy = hash_bucket_policy>
     class unordered_set
     {
         struct SetKeyOfT
@@ -13,9 +14,11 @@ namespace pzh
                 return key;
             }
         };
+
+        typedef typename Policy::template Table<K, K, SetKeyOfT, Hash> HT;
     public:
-        typedef typename pzh_hash_bucket::HashTable<K, K, SetKeyOfT, Hash>::iterator iterator;
-        typedef typename pzh_hash_bucket::HashTable<K, K, SetKeyOfT, Hash>::const_iterator const_iterator;
+        typedef typename HT::iterator iterator;
+        typedef typename HT::const_iterator const_iterator;
 
          iterator begin()
          {
@@ -40,7 +43,7 @@ namespace pzh
         pair<const_iterator, bool> insert(const K& key)
         {
             auto ret = _ht.Insert(key);
-            return pair<const_iterator, bool>(const_iterator(ret.first._node, ret.first._pht, ret.first._hashi), ret.second);
+            return pair<const_iterator, bool>(const_iterator(ret.first), ret.second);
         }
 
         iterator find(const K& key)
@@ -48,12 +51,76 @@ namespace pzh
             return _ht.Find(key);
         }
 
+        // 异构查找：Hash带is_transparent时，find("abc")不会先构造string
+        template<class KeyLike>
+            requires requires { typename Hash::is_transparent; }
+        iterator find(const KeyLike& key)
+        {
+            return _ht.Find(key);
+        }
+
         bool erase(const K& key)
         {
             return _ht.Erase(key);
         }
+
+        // 按迭代器删除，返回下一个元素；可以边遍历边删除：it = m.erase(it)
+        iterator erase(const_iterator pos)
+        {
+            return _ht.Erase(pos);
+        }
+
+        // 一趟删除所有满足pred的元素，返回删除的个数
+        template<class Pred>
+        size_t erase_if(Pred pred)
+        {
+            return _ht.EraseIf(pred);
+        }
+
+        // 大量删除之后把桶数组收缩到刚好够用
+        void shrink_to_fit()
+        {
+            _ht.ShrinkToFit();
+        }
+
+        size_t size() const
+        {
+            return _ht.Size();
+        }
+
+        size_t bucket_count() const
+        {
+            return _ht.BucketCount();
+        }
+
+        float load_factor() const
+        {
+            return _ht.LoadFactor();
+        }
+
+        float max_load_factor() const
+        {
+            return _ht.MaxLoadFactor();
+        }
+
+        void max_load_factor(float ml)
+        {
+            _ht.MaxLoadFactor(ml);
+        }
+
+        // 桶数调整到至少n个
+        void rehash(size_t n)
+        {
+            _ht.Rehash(n);
+        }
+
+        // 预留能放下n个元素的空间，之后插入n个元素都不会再扩容
+        void reserve(size_t n)
+        {
+            _ht.Reserve(n);
+        }
     private:
-        pzh_hash_bucket::HashTable<K, K, SetKeyOfT, Hash> _ht;
+        HT _ht;
     };
 
     void test_set()
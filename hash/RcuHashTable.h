@@ -0,0 +1,517 @@
+#pragma once
+#include<atomic>
+#include<mutex>
+#include<optional>
+#include<vector>
+#include<thread>
+#include<stdexcept>
+#include"HashFunc.h"
+
+// 读多写少场景的哈希表：读者完全不加锁，写者之间用一把互斥锁串行。
+//   写者从不原地修改读者可能正在看的数据：新节点/新桶数组构造好之后用一次原子指针store发布，
+//   被摘下来的节点和旧桶数组先挂到“待回收”队列，等所有可能看到它们的读者都离开后再释放（基于epoch的回收）
+namespace pzh_rcu
+{
+    // 全局epoch + 每个读者线程一个槽位。
+    //   读者进入：把当前全局epoch写进自己的槽位；离开：槽位清零。
+    //   写者回收：对象摘下后记下当时的epoch r并推进全局epoch，
+    //   当所有活跃读者槽位里的epoch都大于r时，不可能还有读者拿着这个对象，可以释放
+    class EpochDomain
+    {
+    public:
+        static const size_t kMaxReaders = 256;
+
+        static EpochDomain& Instance()
+        {
+            static EpochDomain* domain = new EpochDomain;  // 不析构，线程退出时还要用
+            return *domain;
+        }
+
+        uint64_t Current() const
+        {
+            return _globalEpoch.load(std::memory_order_seq_cst);
+        }
+
+        uint64_t Advance()
+        {
+            return _globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+        }
+
+        // 活跃读者中最小的epoch，没有活跃读者时返回UINT64_MAX
+        uint64_t MinActive() const
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            uint64_t min = UINT64_MAX;
+            for (size_t i = 0; i < kMaxReaders; i++)
+            {
+                uint64_t e = _slots[i]._epoch.load(std::memory_order_acquire);
+                if (e != 0 && e < min)
+                    min = e;
+            }
+            return min;
+        }
+
+        // 线程第一次读时占一个槽位，线程退出时归还
+        struct ThreadState
+        {
+            size_t _slot;
+            size_t _depth = 0;  // 允许读临界区嵌套
+
+            ThreadState()
+            {
+                EpochDomain& domain = Instance();
+                for (size_t i = 0; i < kMaxReaders; i++)
+                {
+                    bool expected = false;
+                    if (domain._slots[i]._used.compare_exchange_strong(expected, true))
+                    {
+                        _slot = i;
+                        return;
+                    }
+                }
+                throw std::runtime_error("pzh_rcu: too many reader threads");
+            }
+
+            ~ThreadState()
+            {
+                EpochDomain& domain = Instance();
+                domain._slots[_slot]._epoch.store(0, std::memory_order_release);
+                domain._slots[_slot]._used.store(false, std::memory_order_release);
+            }
+        };
+
+        // 返回当前线程的状态，Leave时传回来，省掉一次thread_local查找
+        ThreadState* Enter()
+        {
+            ThreadState& ts = Local();
+            if (ts._depth++ == 0)
+            {
+                Slot& slot = _slots[ts._slot];
+                slot._epoch.store(_globalEpoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                // 和写者摘链之后的fence配对：要么写者看到这个槽位，要么这里之后的读取看到摘链后的结果
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+            return &ts;
+        }
+
+        void Leave(ThreadState* ts)
+        {
+            if (--ts->_depth == 0)
+            {
+                _slots[ts->_slot]._epoch.store(0, std::memory_order_release);
+            }
+        }
+
+    private:
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> _epoch{0};   // 0表示不在读临界区
+            std::atomic<bool> _used{false};    // 是否已被某个线程占用
+        };
+
+        static ThreadState& Local()
+        {
+            thread_local ThreadState ts;
+            return ts;
+        }
+
+        std::atomic<uint64_t> _globalEpoch{1};
+        Slot _slots[kMaxReaders];
+    };
+
+    // 读临界区：作用域内拿到的节点指针都不会被释放
+    class ReadGuard
+    {
+    public:
+        ReadGuard()
+            :_domain(EpochDomain::Instance())
+            ,_ts(_domain.Enter())
+        {}
+
+        ~ReadGuard()
+        {
+            _domain.Leave(_ts);
+        }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        EpochDomain& _domain;
+        EpochDomain::ThreadState* _ts;
+    };
+
+    // 写者一侧的待回收队列，由调用方的写锁保护
+    class RetireList
+    {
+    public:
+        ~RetireList()
+        {
+            // 走到析构说明所属的表已经没有读者了
+            for (auto& e : _items)
+                e._deleter(e._ptr);
+        }
+
+        template<class T>
+        void Retire(T* p)
+        {
+            _items.push_back({p, [](void* q) { delete (T*)q; }, EpochDomain::Instance().Advance()});
+            if (_items.size() >= kBatch)
+                Reclaim();
+        }
+
+        // 释放所有已经没有读者能看到的对象
+        void Reclaim()
+        {
+            uint64_t min = EpochDomain::Instance().MinActive();
+            size_t keep = 0;
+            for (size_t i = 0; i < _items.size(); i++)
+            {
+                if (_items[i]._epoch < min)
+                    _items[i]._deleter(_items[i]._ptr);
+                else
+                    _items[keep++] = _items[i];
+            }
+            _items.resize(keep);
+        }
+
+        size_t Pending() const
+        {
+            return _items.size();
+        }
+
+    private:
+        static const size_t kBatch = 64;  // 攒够一批再扫描读者槽位
+
+        struct Item
+        {
+            void* _ptr;
+            void (*_deleter)(void*);
+            uint64_t _epoch;   // 摘下时的epoch
+        };
+        std::vector<Item> _items;
+    };
+}
+
+namespace pzh_hash_bucket
+{
+    // 读者无锁的链地址法哈希表。
+    // 节点一旦发布就不再修改数据，修改value = 用新节点替换旧节点；
+    // 扩容时复制出一整套新节点挂到新桶数组上再发布，读者要么看到完整的旧表，要么看到完整的新表
+    template<class K, class T, class KeyOfT, class Hash = HashFunc<K>>
+    class RcuHashTable
+    {
+        struct Node
+        {
+            std::atomic<Node*> _next;
+            size_t _hash;
+            T _data;
+
+            template<class... Args>
+            Node(size_t hash, Node* next, Args&&... args)
+                :_next(next)
+                ,_hash(hash)
+                ,_data(std::forward<Args>(args)...)
+            {}
+        };
+
+        struct Buckets
+        {
+            size_t _mask;
+            std::atomic<Node*>* _heads;
+
+            explicit Buckets(size_t count)
+                :_mask(count - 1)
+                ,_heads(new std::atomic<Node*>[count])
+            {
+                for (size_t i = 0; i < count; i++)
+                    _heads[i].store(nullptr, std::memory_order_relaxed);
+            }
+
+            ~Buckets()
+            {
+                delete[] _heads;
+            }
+
+            size_t Count() const
+            {
+                return _mask + 1;
+            }
+        };
+
+    public:
+        RcuHashTable()
+            :_buckets(new Buckets(8))
+        {}
+
+        RcuHashTable(const RcuHashTable&) = delete;
+        RcuHashTable& operator=(const RcuHashTable&) = delete;
+
+        ~RcuHashTable()
+        {
+            Buckets* b = _buckets.load(std::memory_order_relaxed);
+            DestroyNodes(b);
+            delete b;
+        }
+
+        // 无锁查找：在读临界区内找到节点后把fn(const T&)的结果带出来
+        template<class Fn>
+        bool Read(const K& key, Fn fn) const
+        {
+            Hash hf;
+            KeyOfT kot;
+            size_t hash = hf(key);
+            pzh_rcu::ReadGuard guard;
+            Buckets* b = _buckets.load(std::memory_order_acquire);
+            Node* cur = b->_heads[hash & b->_mask].load(std::memory_order_acquire);
+            while (cur)
+            {
+                if (cur->_hash == hash && kot(cur->_data) == key)
+                {
+                    fn(cur->_data);
+                    return true;
+                }
+                cur = cur->_next.load(std::memory_order_acquire);
+            }
+            return false;
+        }
+
+        // 插入或替换：已存在时用新节点替换旧节点，返回是否新插入
+        template<class... Args>
+        bool Upsert(const K& key, Args&&... args)
+        {
+            Hash hf;
+            KeyOfT kot;
+            size_t hash = hf(key);
+            std::lock_guard<std::mutex> lock(_writeMtx);
+            Buckets* b = _buckets.load(std::memory_order_relaxed);
+            std::atomic<Node*>* link = &b->_heads[hash & b->_mask];
+            Node* cur = link->load(std::memory_order_relaxed);
+            while (cur)
+            {
+                if (cur->_hash == hash && kot(cur->_data) == key)
+                {
+                    Node* newnode = new Node(hash, cur->_next.load(std::memory_order_relaxed), std::forward<Args>(args)...);
+                    link->store(newnode, std::memory_order_release);
+                    _retired.Retire(cur);
+                    return false;
+                }
+                link = &cur->_next;
+                cur = link->load(std::memory_order_relaxed);
+            }
+            if (_n + 1 > b->Count())
+            {
+                Grow(b);
+                b = _buckets.load(std::memory_order_relaxed);
+            }
+            std::atomic<Node*>& head = b->_heads[hash & b->_mask];
+            Node* newnode = new Node(hash, head.load(std::memory_order_relaxed), std::forward<Args>(args)...);
+            head.store(newnode, std::memory_order_release);  // 节点内容构造完才对读者可见
+            ++_n;
+            return true;
+        }
+
+        bool Erase(const K& key)
+        {
+            Hash hf;
+            KeyOfT kot;
+            size_t hash = hf(key);
+            std::lock_guard<std::mutex> lock(_writeMtx);
+            Buckets* b = _buckets.load(std::memory_order_relaxed);
+            std::atomic<Node*>* link = &b->_heads[hash & b->_mask];
+            Node* cur = link->load(std::memory_order_relaxed);
+            while (cur)
+            {
+                if (cur->_hash == hash && kot(cur->_data) == key)
+                {
+                    // 只改前驱的指针，cur->_next保持不变，正在cur上的读者还能继续往后走
+                    link->store(cur->_next.load(std::memory_order_relaxed), std::memory_order_release);
+                    _retired.Retire(cur);
+                    --_n;
+                    return true;
+                }
+                link = &cur->_next;
+                cur = link->load(std::memory_order_relaxed);
+            }
+            return false;
+        }
+
+        size_t Size() const
+        {
+            std::lock_guard<std::mutex> lock(_writeMtx);
+            return _n;
+        }
+
+        size_t BucketCount() const
+        {
+            pzh_rcu::ReadGuard guard;
+            return _buckets.load(std::memory_order_acquire)->Count();
+        }
+
+        // 还在等读者离开的待回收对象个数
+        size_t PendingReclaim() const
+        {
+            std::lock_guard<std::mutex> lock(_writeMtx);
+            return _retired.Pending();
+        }
+
+    private:
+        // 扩容：复制出新的节点链挂到两倍大小的新桶数组上，一次发布，旧桶数组和旧节点整体延迟回收。
+        // 不能把旧节点原地摘到新桶里：正在旧链上走的读者会被带到别的链上，漏掉后面的节点
+        void Grow(Buckets* old)
+        {
+            Buckets* b = new Buckets(old->Count() * 2);
+            for (size_t i = 0; i < old->Count(); i++)
+            {
+                Node* cur = old->_heads[i].load(std::memory_order_relaxed);
+                while (cur)
+                {
+                    std::atomic<Node*>& head = b->_heads[cur->_hash & b->_mask];
+                    head.store(new Node(cur->_hash, head.load(std::memory_order_relaxed), cur->_data),
+                               std::memory_order_relaxed);
+                    cur = cur->_next.load(std::memory_order_relaxed);
+                }
+            }
+            _buckets.store(b, std::memory_order_release);
+            for (size_t i = 0; i < old->Count(); i++)
+            {
+                Node* cur = old->_heads[i].load(std::memory_order_relaxed);
+                while (cur)
+                {
+                    Node* next = cur->_next.load(std::memory_order_relaxed);
+                    _retired.Retire(cur);
+                    cur = next;
+                }
+            }
+            _retired.Retire(old);
+        }
+
+        static void DestroyNodes(Buckets* b)
+        {
+            for (size_t i = 0; i < b->Count(); i++)
+            {
+                Node* cur = b->_heads[i].load(std::memory_order_relaxed);
+                while (cur)
+                {
+                    Node* next = cur->_next.load(std::memory_order_relaxed);
+                    delete cur;
+                    cur = next;
+                }
+            }
+        }
+
+        std::atomic<Buckets*> _buckets;
+        size_t _n = 0;
+        mutable std::mutex _writeMtx;
+        pzh_rcu::RetireList _retired;
+    };
+}
+
+namespace pzh
+{
+    // 读多写少的map：find不加锁、不阻塞，写操作之间串行
+    template<class K, class V, class Hash = HashFunc<K>>
+    class rcu_unordered_map
+    {
+        struct MapKeyOfT
+        {
+            const K& operator()(const pair<const K, V>& kv)
+            {
+                return kv.first;
+            }
+        };
+
+    public:
+        typedef pair<const K, V> value_type;
+
+        // 返回value的拷贝，读临界区在返回前就结束了
+        std::optional<V> find(const K& key) const
+        {
+            std::optional<V> ret;
+            _ht.Read(key, [&ret](const value_type& kv) { ret = kv.second; });
+            return ret;
+        }
+
+        bool contains(const K& key) const
+        {
+            return _ht.Read(key, [](const value_type&) {});
+        }
+
+        // 在读临界区内访问元素，fn里不能保存元素的引用
+        template<class Fn>
+        bool cvisit(const K& key, Fn fn) const
+        {
+            return _ht.Read(key, fn);
+        }
+
+        template<class M>
+        bool insert_or_assign(const K& key, M&& value)
+        {
+            return _ht.Upsert(key, key, std::forward<M>(value));
+        }
+
+        bool erase(const K& key)
+        {
+            return _ht.Erase(key);
+        }
+
+        size_t size() const
+        {
+            return _ht.Size();
+        }
+
+        size_t bucket_count() const
+        {
+            return _ht.BucketCount();
+        }
+
+    private:
+        pzh_hash_bucket::RcuHashTable<K, value_type, MapKeyOfT, Hash> _ht;
+    };
+
+    // 读者线程不停地查，写者线程增删改，读者看到的value必须是某次写入的完整值
+    void test_rcu_map()
+    {
+        rcu_unordered_map<int, string> m;
+        const int kKeys = 2000;
+        for (int i = 0; i < kKeys; i++)
+            m.insert_or_assign(i, to_string(i) + ":0");
+        std::atomic<bool> stop{false};
+        std::atomic<bool> ok{true};
+        vector<thread> readers;
+        for (int t = 0; t < 4; t++)
+        {
+            readers.emplace_back([&]() {
+                int i = 0;
+                while (!stop.load(std::memory_order_relaxed))
+                {
+                    int key = i++ % kKeys;
+                    auto v = m.find(key);
+                    // 偶数key只会被改值，永远存在；value前缀必须是key本身
+                    if (key % 2 == 0 && !v)
+                        ok = false;
+                    if (v && v->compare(0, v->find(':'), to_string(key)) != 0)
+                        ok = false;
+                }
+            });
+        }
+        for (int round = 1; round <= 20; round++)
+        {
+            for (int i = 0; i < kKeys; i++)
+            {
+                if (i % 2 == 1 && round % 2 == 1)
+                    m.erase(i);
+                else
+                    m.insert_or_assign(i, to_string(i) + ":" + to_string(round));
+            }
+            // 插入大量新key触发扩容
+            for (int i = 0; i < 500; i++)
+                m.insert_or_assign(kKeys + round * 1000 + i, to_string(kKeys + round * 1000 + i) + ":x");
+        }
+        stop = true;
+        for (auto& th : readers)
+            th.join();
+        bool finalOk = m.size() == kKeys + 20 * 500 && m.find(0) && *m.find(0) == "0:20" && m.find(1) && *m.find(1) == "1:20";
+        cout << "rcu map check:" << (ok && finalOk ? "ok" : "error") << " buckets:" << m.bucket_count() << endl;
+    }
+}
@@ -6,12 +6,458 @@ using namespace std;
 #include<unordered_map>
 #include<map>
 #include<set>
+#include<chrono>
+#include<atomic>
 
+#include"../Memory_management/PoolAllocator.h"
 #include"HashTable.h"
 #include "MyUnorderedSet.h"
 #include"MyUnorderedMap.h"
+#include"ConcurrentUnorderedMap.h"
+#include"RcuHashTable.h"
 
 
+// 插入/查找/删除耗时，reserve为true时先预留好空间再批量插入
+template<class Map>
+void BenchMap(const char* name, const vector<int>& v, bool reserve)
+{
+    Map m;
+    if (reserve)
+        m.reserve(v.size());
+
+    size_t begin1 = clock();
+    for (auto e : v)
+        m.insert(make_pair(e, e));
+    size_t end1 = clock();
+
+    size_t hit = 0;
+    size_t begin2 = clock();
+    for (auto e : v)
+        hit += m.find(e) != m.end();
+    size_t end2 = clock();
+
+    size_t begin3 = clock();
+    for (auto e : v)
+        m.erase(e);
+    size_t end3 = clock();
+
+    cout << name << (reserve ? "(reserve)" : "") << " insert:" << end1 - begin1
+         << " find:" << end2 - begin2 << " erase:" << end3 - begin3 << " hit:" << hit << endl;
+}
+
+// 几种哈希表后端的对比
+void TestHashPolicy()
+{
+    const size_t N = 1000000;
+    vector<int> v;
+    v.reserve(N);
+    srand(time(0));
+    for (size_t i = 0; i < N; ++i)
+    {
+        v.push_back(rand() + i);
+    }
+
+    for (bool reserve : { false, true })
+    {
+        BenchMap<unordered_map<int, int>>("std::unordered_map", v, reserve);
+        BenchMap<pzh::unordered_map<int, int>>("bucket", v, reserve);
+        BenchMap<pzh::unordered_map<int, int, HashFunc<int>, pzh::hash_bucket_prime_policy>>("bucket prime", v, reserve);
+        BenchMap<pzh::unordered_map<int, int, HashFunc<int>,
+                 pzh::basic_hash_bucket_policy<pzh_hash_bucket::PowerOfTwoGrowth, pzh::pool_allocator>>>("bucket(pool)", v, reserve);
+        BenchMap<pzh::unordered_map<int, int, HashFunc<int>, pzh::flat_hash_policy>>("flat", v, reserve);
+    }
+    cout << endl;
+}
+
+// 整数直接强转的哈希：key只在高位不同（i << 16、i << 32）时，flat表的选组不能只看低位
+struct IdentityHash
+{
+    size_t operator()(uint64_t key) const
+    {
+        return (size_t)key;
+    }
+};
+
+void TestFlatHighBitKeys()
+{
+    const uint64_t N = 20000;
+    cout << "---- flat表 只在高位不同的key（恒等哈希）----" << endl;
+    for (int shift : { 0, 16, 32 })
+    {
+        pzh::unordered_map<uint64_t, int, IdentityHash, pzh::flat_hash_policy> m;
+        size_t begin = clock();
+        for (uint64_t i = 0; i < N; i++)
+            m.insert(make_pair(i << shift, (int)i));
+        size_t hit = 0;
+        for (uint64_t i = 0; i < N; i++)
+            hit += m.find(i << shift) != m.end();
+        size_t end = clock();
+        cout << "key = i << " << shift << " insert+find:" << end - begin << (hit == N ? "" : " error") << endl;
+    }
+    cout << endl;
+}
+
+// 逐个插入时单次插入的最大耗时：一次性rehash会在表很大时出现毫秒级的尖刺
+void TestIncrementalRehash()
+{
+    const size_t N = 4000000;
+    for (bool incremental : { true, false })
+    {
+        pzh::unordered_map<int, int> m;
+        m.incremental_rehash(incremental);
+        long long maxNs = 0;
+        size_t slow = 0;  // 超过1ms的插入次数
+        auto begin = chrono::steady_clock::now();
+        for (size_t i = 0; i < N; i++)
+        {
+            auto t1 = chrono::steady_clock::now();
+            m.insert(make_pair((int)i, (int)i));
+            auto t2 = chrono::steady_clock::now();
+            long long ns = chrono::duration_cast<chrono::nanoseconds>(t2 - t1).count();
+            if (ns > maxNs)
+                maxNs = ns;
+            if (ns > 1000000)
+                ++slow;
+        }
+        auto end = chrono::steady_clock::now();
+        cout << (incremental ? "incremental" : "one-shot") << " rehash: total "
+             << chrono::duration_cast<chrono::milliseconds>(end - begin).count() << "ms, max insert "
+             << maxNs / 1000 << "us, inserts over 1ms: " << slow << endl;
+    }
+    cout << endl;
+}
+
+// 全局一把锁保护的unordered_map，作为分片并发哈希表的对照
+template<class K, class V>
+class LockedMap
+{
+public:
+    std::optional<V> find(const K& key) const
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        auto it = _map.find(key);
+        if (it == _map.end())
+            return std::nullopt;
+        return it->second;
+    }
+
+    void insert_or_assign(const K& key, const V& value)
+    {
+        std::lock_guard<std::mutex> lock(_mtx);
+        _map[key] = value;
+    }
+
+private:
+    mutable std::mutex _mtx;
+    mutable pzh::unordered_map<K, V> _map;
+};
+
+// 收集查找结果，防止编译器把查找优化掉
+atomic<size_t> g_benchSink;
+
+// 每个线程做固定次数的操作（readPercent%查找，其余insert_or_assign），统计总吞吐
+template<class Map>
+double BenchConcurrentMap(Map& m, int threadCount, int opsPerThread, int keyRange, int readPercent)
+{
+    vector<thread> threads;
+    auto begin = chrono::steady_clock::now();
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&m, t, opsPerThread, keyRange, readPercent]() {
+            uint64_t x = 0x9E3779B97F4A7C15ULL * (t + 1);
+            size_t hit = 0;
+            for (int i = 0; i < opsPerThread; i++)
+            {
+                // xorshift，避免rand()内部的锁影响结果
+                x ^= x << 13;
+                x ^= x >> 7;
+                x ^= x << 17;
+                int key = (int)(x % keyRange);
+                if ((int)((x >> 32) % 100) < readPercent)
+                    hit += m.find(key).has_value();
+                else
+                    m.insert_or_assign(key, i);
+            }
+            g_benchSink += hit;
+        });
+    }
+    for (auto& th : threads)
+        th.join();
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    return threadCount * (double)opsPerThread / sec / 1e6;
+}
+
+void TestConcurrentMap()
+{
+    const int keyRange = 1 << 20;
+    const int opsPerThread = 200000;
+    cout << "---- 并发哈希表吞吐（Mops/s，90%读10%写，机器核数:" << thread::hardware_concurrency() << "）----" << endl;
+    for (int threads = 1; threads <= 64; threads *= 2)
+    {
+        LockedMap<int, int> locked;
+        pzh::concurrent_unordered_map<int, int> sharded(64);
+        for (int i = 0; i < keyRange; i += 2)
+        {
+            locked.insert_or_assign(i, i);
+            sharded.insert_or_assign(i, i);
+        }
+        double a = BenchConcurrentMap(locked, threads, opsPerThread, keyRange, 90);
+        double b = BenchConcurrentMap(sharded, threads, opsPerThread, keyRange, 90);
+        printf("threads:%2d  global mutex:%7.2f  sharded(64):%7.2f\n", threads, a, b);
+    }
+    cout << endl;
+}
+
+// 读多写少：读者无锁的rcu_unordered_map 对比 全局互斥锁
+void TestRcuMap()
+{
+    const int keyRange = 1 << 16;
+    const int opsPerThread = 200000;
+    int ratios[] = {99, 90};
+    for (int readPercent : ratios)
+    {
+        cout << "---- 读写比 " << readPercent << "/" << 100 - readPercent << "（Mops/s）----" << endl;
+        for (int threads = 1; threads <= 8; threads *= 2)
+        {
+            LockedMap<int, int> locked;
+            pzh::rcu_unordered_map<int, int> rcu;
+            for (int i = 0; i < keyRange; i += 2)
+            {
+                locked.insert_or_assign(i, i);
+                rcu.insert_or_assign(i, i);
+            }
+            double a = BenchConcurrentMap(locked, threads, opsPerThread, keyRange, readPercent);
+            double b = BenchConcurrentMap(rcu, threads, opsPerThread, keyRange, readPercent);
+            printf("threads:%2d  global mutex:%7.2f  rcu:%7.2f\n", threads, a, b);
+        }
+    }
+    cout << endl;
+}
+
+// 改造前的开放地址法：线性探测 + DELETE墓碑，墓碑只有扩容时才会清掉
+class LegacyLinearProbe
+{
+    enum Status { EMPTY, EXIST, DELETE };
+
+public:
+    LegacyLinearProbe()
+        :_keys(16), _status(16, EMPTY)
+    {}
+
+    bool Insert(int key)
+    {
+        if (Find(key))
+            return false;
+        // 和原来一样只按EXIST的个数判断负载，墓碑不算
+        if ((_n + 1) * 10 > _keys.size() * 7)
+        {
+            LegacyLinearProbe bigger;
+            bigger._keys.assign(_keys.size() * 2, 0);
+            bigger._status.assign(_keys.size() * 2, EMPTY);
+            for (size_t i = 0; i < _keys.size(); i++)
+            {
+                if (_status[i] == EXIST)
+                    bigger.Insert(_keys[i]);
+            }
+            *this = bigger;
+        }
+        size_t i = HashFunc<int>()(key) & (_keys.size() - 1);
+        while (_status[i] == EXIST)
+            i = (i + 1) & (_keys.size() - 1);
+        _keys[i] = key;
+        _status[i] = EXIST;
+        ++_n;
+        return true;
+    }
+
+    // 返回是否找到，probes累加比较次数；全是墓碑时最多走一圈
+    bool Find(int key, size_t* probes = nullptr)
+    {
+        size_t i = HashFunc<int>()(key) & (_keys.size() - 1);
+        for (size_t step = 0; step < _keys.size() && _status[i] != EMPTY; step++)
+        {
+            if (probes)
+                ++*probes;
+            if (_status[i] == EXIST && _keys[i] == key)
+                return true;
+            i = (i + 1) & (_keys.size() - 1);
+        }
+        return false;
+    }
+
+    bool Erase(int key)
+    {
+        size_t i = HashFunc<int>()(key) & (_keys.size() - 1);
+        for (size_t step = 0; step < _keys.size() && _status[i] != EMPTY; step++)
+        {
+            if (_status[i] == EXIST && _keys[i] == key)
+            {
+                _status[i] = DELETE;
+                --_n;
+                return true;
+            }
+            i = (i + 1) & (_keys.size() - 1);
+        }
+        return false;
+    }
+
+private:
+    vector<int> _keys;
+    vector<Status> _status;
+    size_t _n = 0;
+};
+
+// 多轮插入/删除之后，对比查找一个不存在的key平均要探测多少格
+void TestProbeLength()
+{
+    const int N = 1 << 16;
+    LegacyLinearProbe legacy;
+    pzh_open_address::HashTable_pre<int, int> robin;
+    for (int i = 0; i < N; i++)
+    {
+        legacy.Insert(i);
+        robin.Insert(make_pair(i, i));
+    }
+    cout << "---- 开放地址法 churn（每轮删掉最早的一半key，再插入同样多的新key）----" << endl;
+    int next = N;
+    for (int round = 1; round <= 8; round++)
+    {
+        for (int i = next - N; i < next - N / 2; i++)
+        {
+            legacy.Erase(i);
+            robin.Erase(i);
+        }
+        for (int i = 0; i < N / 2; i++, next++)
+        {
+            legacy.Insert(next);
+            robin.Insert(make_pair(next, next));
+        }
+        size_t legacyProbes = 0;
+        size_t begin1 = clock();
+        for (int i = 0; i < N; i++)
+            legacy.Find(-1 - i, &legacyProbes);
+        size_t end1 = clock();
+        size_t begin2 = clock();
+        size_t hit = 0;
+        for (int i = 0; i < N; i++)
+            hit += robin.Find(-1 - i) != nullptr;
+        size_t end2 = clock();
+        printf("round %d  legacy miss probes:%8.1f time:%6zu  robin hood time:%6zu  ", round,
+               (double)legacyProbes / N, end1 - begin1, end2 - begin2);
+        g_benchSink += hit;
+        robin.Stats().Print();
+    }
+    cout << endl;
+}
+
+// 改造前的哈希函数，留作对比
+struct LegacyIntHash
+{
+    size_t operator()(int key) const
+    {
+        return (size_t)key;
+    }
+};
+
+struct LegacyStringHash
+{
+    size_t operator()(const string& key) const
+    {
+        size_t hash = 0;
+        for (auto e : key)
+        {
+            hash *= 31;
+            hash += e;
+        }
+        return hash;
+    }
+};
+
+// 把keys按hash & (桶数-1)放进2的幂个桶里，统计冲突次数（落进非空桶的key数）和最长桶
+template<class Key, class Hash>
+void HashCollision(const char* name, const vector<Key>& keys)
+{
+    size_t bucketCount = 1;
+    while (bucketCount < keys.size())
+        bucketCount <<= 1;
+    vector<size_t> buckets(bucketCount, 0);
+    Hash hf;
+    size_t collision = 0, longest = 0;
+    for (auto& e : keys)
+    {
+        size_t& len = buckets[hf(e) & (bucketCount - 1)];
+        if (len > 0)
+            ++collision;
+        ++len;
+        if (len > longest)
+            longest = len;
+    }
+    printf("%-28s collision:%8zu (%.1f%%)  longest bucket:%zu\n", name, collision,
+           100.0 * collision / keys.size(), longest);
+}
+
+// 哈希吞吐：反复计算同一批key的哈希
+template<class Key, class Hash>
+void HashThroughput(const char* name, const vector<Key>& keys, size_t bytes)
+{
+    const int rounds = 20;
+    Hash hf;
+    size_t sum = 0;
+    auto begin = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        for (auto& e : keys)
+            sum += hf(e);
+    }
+    double sec = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+    printf("%-28s %6.2f ns/key  %8.1f MB/s  (%zu)\n", name, sec * 1e9 / (keys.size() * rounds),
+           bytes * rounds / sec / 1e6, sum & 1);
+}
+
+void TestHashFunc()
+{
+    const size_t N = 1 << 20;
+    vector<int> seq, stride;
+    vector<string> shortKeys, urls, longKeys;
+    size_t shortBytes = 0, urlBytes = 0, longBytes = 0;
+    char buf[128];
+    for (size_t i = 0; i < N; ++i)
+    {
+        seq.push_back((int)i);
+        stride.push_back((int)(i << 10));
+        snprintf(buf, sizeof(buf), "key_%zu", i);
+        shortKeys.push_back(buf);
+        shortBytes += shortKeys.back().size();
+        snprintf(buf, sizeof(buf), "https://example.com/item/%08zu/detail", i);
+        urls.push_back(buf);
+        urlBytes += urls.back().size();
+    }
+    for (size_t i = 0; i < N / 16; ++i)
+    {
+        longKeys.push_back(string(240, 'a') + to_string(i));
+        longBytes += longKeys.back().size();
+    }
+
+    cout << "---- 冲突率（桶数为不小于N的2的幂）----" << endl;
+    HashCollision<int, LegacyIntHash>("legacy int seq", seq);
+    HashCollision<int, HashFunc<int>>("HashFunc int seq", seq);
+    HashCollision<int, LegacyIntHash>("legacy int stride 1024", stride);
+    HashCollision<int, HashFunc<int>>("HashFunc int stride 1024", stride);
+    HashCollision<string, LegacyStringHash>("legacy string key_i", shortKeys);
+    HashCollision<string, HashFunc<string>>("HashFunc string key_i", shortKeys);
+    HashCollision<string, LegacyStringHash>("legacy string url", urls);
+    HashCollision<string, HashFunc<string>>("HashFunc string url", urls);
+
+    cout << "---- 吞吐 ----" << endl;
+    HashThroughput<string, LegacyStringHash>("legacy string key_i", shortKeys, shortBytes);
+    HashThroughput<string, HashFunc<string>>("HashFunc string key_i", shortKeys, shortBytes);
+    HashThroughput<string, LegacyStringHash>("legacy string url", urls, urlBytes);
+    HashThroughput<string, HashFunc<string>>("HashFunc string url", urls, urlBytes);
+    HashThroughput<string, LegacyStringHash>("legacy string 240B", longKeys, longBytes);
+    HashThroughput<string, HashFunc<string>>("HashFunc string 240B", longKeys, longBytes);
+    cout << endl;
+}
+
 int main()
 {
     unordered_set<int> s1;
@@ -104,9 +550,31 @@ int main()
 
     pzh_open_address::TestHT1();
     pzh_open_address::TestHT2();
+    pzh_open_address::TestHT3();
+    TestProbeLength();
 
     pzh::test_map();
     pzh::test_set();
+    pzh::test_flat_map();
+    pzh::test_try_emplace<pzh::hash_bucket_policy>();
+    pzh::test_try_emplace<pzh::flat_hash_policy>();
+    pzh::test_reserve<pzh::hash_bucket_policy>();
+    pzh::test_reserve<pzh::hash_bucket_prime_policy>();
+    pzh::test_reserve<pzh::flat_hash_policy>();
+    pzh::test_incremental_rehash();
+    pzh::test_erase<pzh::hash_bucket_policy>();
+    pzh::test_erase<pzh::hash_bucket_prime_policy>();
+    pzh::test_erase<pzh::flat_hash_policy>();
+    pzh::test_heterogeneous_find<pzh::hash_bucket_policy>();
+    pzh::test_heterogeneous_find<pzh::flat_hash_policy>();
+    pzh::test_concurrent_map();
+    pzh::test_rcu_map();
+    TestHashFunc();
+    TestHashPolicy();
+    TestFlatHighBitKeys();
+    TestIncrementalRehash();
+    TestConcurrentMap();
+    TestRcuMap();
 
     return 0;
 }
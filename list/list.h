@@ -1,6 +1,8 @@
 #pragma once
 #include <iostream>
 #include <string>
+#include <memory>
+#include "../Memory_management/PoolAllocator.h"
 
 namespace pzh
 {
@@ -148,10 +150,12 @@ namespace pzh
     // ---------------------------------------------------------
     // 3. 链表主类 (List Class Definition)
     // ---------------------------------------------------------
-    template <class T>
+    // Alloc: 元素的分配器，内部rebind成节点的分配器（比如pzh::pool_allocator让节点走内存池）
+    template <class T, class Alloc = std::allocator<T>>
     class list
     {
         typedef list_node<T> Node;
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Node> NodeAlloc;
 
     public:
         typedef __list_iterator<T, T&, T*> iterator;
@@ -179,7 +183,7 @@ namespace pzh
 
         void empty_init()
         {
-            _head = new Node;
+            _head = CreateNode();
             _head->_next = _head;
             _head->_prev = _head;
             _size = 0;
@@ -190,7 +194,7 @@ namespace pzh
             empty_init();
         }
 
-        list(const list<T>& lt)
+        list(const list& lt)
         {
             empty_init();
             for (auto e : lt)
@@ -199,14 +203,14 @@ namespace pzh
             }
         }
 
-        void swap(list<T>& lt)
+        void swap(list& lt)
         {
             std::swap(_head, lt._head);
             std::swap(_size, lt._size);
         }
 
         // 赋值运算符重载（已修正：将 list<int> 纠正为泛型 list<T> 以支持任意类型拷贝）
-        list<T>& operator=(list<T> lt)
+        list& operator=(list lt)
         {
             swap(lt);
             return *this;
@@ -215,7 +219,7 @@ namespace pzh
         ~list()
         {
             clear();
-            delete _head;
+            DestroyNode(_head);
             _head = nullptr;
         }
 
@@ -251,7 +255,7 @@ namespace pzh
         iterator insert(iterator pos, const T& x)
         {
             Node* cur = pos._node;
-            Node* newnode = new Node(x);
+            Node* newnode = CreateNode(x);
             Node* prev = cur->_prev;
 
             prev->_next = newnode;
@@ -269,7 +273,7 @@ namespace pzh
             Node* prev = cur->_prev;
             Node* next = cur->_next;
 
-            delete cur;
+            DestroyNode(cur);
             prev->_next = next;
             next->_prev = prev;
 
@@ -282,9 +286,22 @@ namespace pzh
             return _size;
         }
 
+    private:
+        template <class... Args>
+        Node* CreateNode(Args&&... args)
+        {
+            return pzh::__AllocateNode(_alloc, std::forward<Args>(args)...);
+        }
+
+        void DestroyNode(Node* node)
+        {
+            pzh::__DestroyNode(_alloc, node);
+        }
+
     private:
         Node* _head;
         size_t _size;
+        [[no_unique_address]] NodeAlloc _alloc;
     };
 
     // ---------------------------------------------------------
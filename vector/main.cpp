@@ -1,4 +1,30 @@
 #include "vector.h"
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+
+// 统计堆分配次数：替换全局operator new，std::allocator最终都走这里
+// new/delete都不内联，否则GCC会把内联后的malloc/free和new/delete配对，误报不匹配
+static size_t g_allocCount = 0;
+
+[[gnu::noinline]] void* operator new(size_t n)
+{
+    ++g_allocCount;
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void* p, size_t) noexcept
+{
+    std::free(p);
+}
 
 using std::cout;
 using std::endl;
@@ -139,11 +165,298 @@ void Test_Complex_Type_DeepCopy()
     print_vector(v_resize_test, "Resize Test");
 }
 
+// 统计拷贝/移动构造次数的类型，Noexcept控制移动构造是否声明noexcept
+template<bool Noexcept>
+struct Counted
+{
+    static inline int copies = 0;
+    static inline int moves = 0;
+    static inline int alive = 0;
+    std::string s;
+
+    Counted(const char* str) : s(str) { ++alive; }
+    Counted(const Counted& c) : s(c.s) { ++copies; ++alive; }
+    Counted(Counted&& c) noexcept(Noexcept) : s(std::move(c.s)) { ++moves; ++alive; }
+    Counted& operator=(const Counted& c) { s = c.s; ++copies; return *this; }
+    Counted& operator=(Counted&& c) noexcept(Noexcept) { s = std::move(c.s); ++moves; return *this; }
+    ~Counted() { --alive; }
+};
+
+// 只持有一个堆指针，没有指向自己的指针：按字节搬走是安全的，手动声明成可平凡重定位
+struct Buffer
+{
+    static inline int moves = 0;
+    int* data;
+
+    explicit Buffer(int v) : data(new int(v)) {}
+    Buffer(const Buffer& b) : data(new int(*b.data)) {}
+    Buffer(Buffer&& b) noexcept : data(b.data) { b.data = nullptr; ++moves; }
+    Buffer& operator=(Buffer b) noexcept { std::swap(data, b.data); return *this; }
+    ~Buffer() { delete data; }
+};
+
+template<>
+struct pzh::is_trivially_relocatable<Buffer> : std::true_type
+{};
+
+// 模块五：扩容时元素怎么搬
+void Test_Reserve_Relocation()
+{
+    cout << "\n=== Test 5: Relocation on Growth ===" << endl;
+    bool ok = true;
+
+    // 移动构造noexcept：扩容只移动，不拷贝
+    {
+        pzh::vector<Counted<true>> v;
+        for (int i = 0; i < 100; ++i)
+            v.push_back("item");
+        Counted<true>::copies = Counted<true>::moves = 0;
+        v.reserve(1000);
+        ok = ok && Counted<true>::copies == 0 && Counted<true>::moves == 100 && v[99].s == "item";
+    }
+    // 移动构造可能抛异常：退回拷贝，保证扩容失败时原数据不丢
+    {
+        pzh::vector<Counted<false>> v;
+        for (int i = 0; i < 100; ++i)
+            v.push_back("item");
+        Counted<false>::copies = Counted<false>::moves = 0;
+        v.reserve(1000);
+        ok = ok && Counted<false>::copies == 100 && Counted<false>::moves == 0 && v[0].s == "item";
+    }
+    ok = ok && Counted<true>::alive == 0 && Counted<false>::alive == 0;
+
+    // 可平凡重定位：memcpy，连移动构造都不调用，旧空间也不析构
+    {
+        pzh::vector<Buffer> v;
+        for (int i = 0; i < 100; ++i)
+            v.push_back(Buffer(i));
+        Buffer::moves = 0;
+        v.reserve(1000);
+        ok = ok && Buffer::moves == 0 && *v[42].data == 42;
+        v.erase(v.begin());
+        v.insert(v.begin() + 10, v[0]);  // 插入的是自己的元素
+        ok = ok && *v[0].data == 1 && *v[10].data == 1 && *v[11].data == 11 && v.size() == 100;
+    }
+
+    // 插入本vector里的元素恰好触发扩容
+    pzh::vector<string> vs;
+    for (int i = 0; i < 4; ++i)
+        vs.push_back(std::to_string(i));
+    vs.push_back(vs[0]);
+    vs.insert(vs.begin() + 1, vs[3]);
+    ok = ok && vs.size() == 6 && vs[1] == "3" && vs[5] == "0";
+    cout << "Relocation checks: " << (ok ? "ok" : "FAILED") << endl;
+}
+
+struct Large
+{
+    char payload[256];
+    std::string name;
+
+    Large() : payload(), name("large struct with a heap string") {}
+};
+
+template<class Vec, class T>
+double BenchPushBack(const T& value, int n, int rounds)
+{
+    clock_t begin = clock();
+    for (int r = 0; r < rounds; ++r)
+    {
+        Vec v;
+        for (int i = 0; i < n; ++i)
+            v.push_back(value);
+    }
+    return double(clock() - begin) / CLOCKS_PER_SEC * 1000;
+}
+
+template<class T>
+void BenchPushBackRow(const char* name, const T& value, int n, int rounds)
+{
+    double a = BenchPushBack<pzh::vector<T>>(value, n, rounds);
+    double b = BenchPushBack<std::vector<T>>(value, n, rounds);
+    printf("%-8s n=%-7d pzh::vector %8.2f ms   std::vector %8.2f ms\n", name, n, a, b);
+}
+
+// 模块六：push_back吞吐量和std::vector对比
+void Benchmark_PushBack()
+{
+    cout << "\n=== Benchmark: push_back ===" << endl;
+    BenchPushBackRow("int", 7, 100000, 200);
+    BenchPushBackRow("string", string("a string too long for SSO"), 200000, 5);
+    BenchPushBackRow("Large", Large(), 50000, 5);
+}
+
+// 模块七：右值和就地构造
+void Test_Append_Overloads()
+{
+    cout << "\n=== Test 7: push_back(T&&) / emplace_back / insert(T&&) ===" << endl;
+    bool ok = true;
+
+    pzh::vector<Counted<true>> v;
+    Counted<true> a("moved in");
+    Counted<true>::copies = Counted<true>::moves = 0;
+    v.push_back(std::move(a));
+    ok = ok && Counted<true>::copies == 0 && Counted<true>::moves == 1 && a.s.empty();
+
+    Counted<true>::moves = 0;
+    Counted<true>& back = v.emplace_back("emplaced");  // 直接用const char*构造，没有临时对象
+    ok = ok && Counted<true>::moves == 0 && &back == &v.back() && back.s == "emplaced";
+
+    v.emplace_back("third");
+    v.emplace_back("fourth");
+    Counted<true>::copies = 0;
+    v.insert(v.begin() + 1, Counted<true>("inserted"));  // 扩容时就地构造到新空间
+    v.emplace(v.begin(), "front");
+    ok = ok && Counted<true>::copies == 0 && v.size() == 6 && v[0].s == "front" && v[2].s == "inserted" && v[5].s == "fourth";
+
+    // 用自己的元素扩容尾插
+    pzh::vector<string> vs;
+    for (int i = 0; i < 4; ++i)
+        vs.emplace_back(3, char('a' + i));
+    vs.emplace_back(vs[1]);
+    vs.push_back(vs.back());
+    ok = ok && vs.size() == 6 && vs[4] == "bbb" && vs[5] == "bbb";
+    cout << "Append overloads: " << (ok ? "ok" : "FAILED") << endl;
+}
+
+template<class Growth>
+void BenchGrowthRow(const char* name, int n, int rounds)
+{
+    size_t reallocs = 0, capacity = 0;
+    clock_t begin = clock();
+    for (int r = 0; r < rounds; ++r)
+    {
+        pzh::vector<int, Growth> v;
+        reallocs = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            if (v.size() == v.capacity())
+                ++reallocs;
+            v.push_back(i);
+        }
+        capacity = v.capacity();
+    }
+    double ms = double(clock() - begin) / CLOCKS_PER_SEC * 1000;
+    printf("%-5s n=%d  reallocations=%zu  capacity=%zu (%.0f%% unused)  %.2f ms\n",
+           name, n, reallocs, capacity, 100.0 * (capacity - n) / capacity, ms);
+}
+
+// 模块八：拷贝尾插和移动尾插、两种增长策略
+void Benchmark_Append()
+{
+    cout << "\n=== Benchmark: append ===" << endl;
+    const int n = 200000, rounds = 5;
+    string value(40, 'x');
+    clock_t begin = clock();
+    for (int r = 0; r < rounds; ++r)
+    {
+        pzh::vector<string> v;
+        for (int i = 0; i < n; ++i)
+            v.push_back(value);
+    }
+    clock_t mid = clock();
+    for (int r = 0; r < rounds; ++r)
+    {
+        pzh::vector<string> v;
+        for (int i = 0; i < n; ++i)
+            v.emplace_back(40, 'x');
+    }
+    clock_t end = clock();
+    printf("string push_back(copy) %.2f ms   emplace_back %.2f ms\n",
+           double(mid - begin) / CLOCKS_PER_SEC * 1000, double(end - mid) / CLOCKS_PER_SEC * 1000);
+
+    BenchGrowthRow<pzh::double_growth>("2x", 3000000, 10);
+    BenchGrowthRow<pzh::one_and_half_growth>("1.5x", 3000000, 10);
+}
+
+// 模块九：小缓冲区优化
+void Test_Small_Vector()
+{
+    cout << "\n=== Test 9: small_vector ===" << endl;
+    bool ok = true;
+
+    // 不超过N个元素时不分配
+    size_t before = g_allocCount;
+    pzh::small_vector<int, 8> sv;
+    for (int i = 0; i < 8; ++i)
+        sv.push_back(i);
+    ok = ok && sv.is_inline() && g_allocCount == before && sv.capacity() == 8;
+    sv.push_back(8);  // 第9个搬到堆上
+    ok = ok && !sv.is_inline() && g_allocCount == before + 1 && sv.size() == 9 && sv[0] == 0 && sv[8] == 8;
+
+    {
+        typedef pzh::small_vector<Counted<true>, 4> SV;
+        SV a;
+        a.emplace_back("a0");
+        a.emplace_back("a1");
+        SV b(a);                  // 拷贝：仍在内部空间
+        SV c(std::move(a));       // 移动内部空间里的元素：逐个搬，a变空
+        ok = ok && b.is_inline() && c.is_inline() && a.empty() && c.size() == 2 && c[1].s == "a1";
+
+        SV d;
+        for (int i = 0; i < 6; ++i)
+            d.emplace_back("d");
+        Counted<true>* heap = d.begin();
+        SV e(std::move(d));       // 移动堆上的元素：直接接管指针
+        ok = ok && !e.is_inline() && e.begin() == heap && d.empty() && d.is_inline();
+
+        c.swap(e);                // 内部空间和堆交换
+        ok = ok && c.size() == 6 && e.size() == 2 && e.is_inline() && e[0].s == "a0" && c.begin() == heap;
+
+        b = c;                    // 赋值之后b搬到了堆上
+        b.insert(b.begin(), Counted<true>("front"));
+        b.erase(b.begin() + 1);
+        ok = ok && b.size() == 6 && b[0].s == "front" && !b.is_inline();
+        b.pop_back();
+    }
+    ok = ok && Counted<true>::alive == 0;
+
+    cout << "sizeof vector<int> = " << sizeof(pzh::vector<int>)
+         << ", small_vector<int, 8> = " << sizeof(pzh::small_vector<int, 8>) << endl;
+    cout << "small_vector checks: " << (ok ? "ok" : "FAILED") << endl;
+}
+
+template<class Vec>
+void BenchShortLivedRow(const char* name, int iterations)
+{
+    size_t allocs = g_allocCount;
+    long long sum = 0;
+    clock_t begin = clock();
+    for (int i = 0; i < iterations; ++i)
+    {
+        Vec v;
+        int n = 1 + i % 8;  // 每个请求1~8个元素
+        for (int j = 0; j < n; ++j)
+            v.push_back(i + j);
+        for (int x : v)
+            sum += x;
+    }
+    double ms = double(clock() - begin) / CLOCKS_PER_SEC * 1000;
+    printf("%-24s allocations=%-8zu %8.2f ms  (%lld)\n", name, g_allocCount - allocs, ms, sum);
+}
+
+// 模块十：大量短生命周期的小vector
+void Benchmark_Short_Lived()
+{
+    cout << "\n=== Benchmark: short-lived vectors (1~8 ints) ===" << endl;
+    const int iterations = 2000000;
+    BenchShortLivedRow<std::vector<int>>("std::vector", iterations);
+    BenchShortLivedRow<pzh::vector<int>>("pzh::vector", iterations);
+    BenchShortLivedRow<pzh::small_vector<int, 8>>("pzh::small_vector<int,8>", iterations);
+    BenchShortLivedRow<pzh::small_vector<int, 4>>("pzh::small_vector<int,4>", iterations);
+}
+
 int main()
 {
     Test_Construction_And_Traversal();
     Test_Capacity_And_Memory();
     Test_Modifiers_And_IteratorInvalidation();
     Test_Complex_Type_DeepCopy();
+    Test_Reserve_Relocation();
+    Benchmark_PushBack();
+    Test_Append_Overloads();
+    Benchmark_Append();
+    Test_Small_Vector();
+    Benchmark_Short_Lived();
     return 0;
 }
\ No newline at end of file
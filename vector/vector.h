@@ -1,13 +1,61 @@
 #pragma once
 #include <algorithm>
 #include <cassert>
+#include <cstring>
 #include <iostream>
+#include <memory>
+#include <new>
 #include <string>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace pzh
 {
+    // 可平凡重定位：把对象按字节搬到新地址、旧地址不再析构，等价于“移动构造 + 析构旧对象”
+    // 平凡可拷贝的类型天然满足；自定义类型（比如只持有堆指针、没有指向自己的指针）可以特化成true_type：
+    //   template<> struct pzh::is_trivially_relocatable<MyType> : std::true_type {};
+    // 注意std::string（短字符串指向对象内部）之类的类型不满足
     template <class T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T>
+    {};
+
+    template <class T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+    // 增长策略：满了之后新容量 = 旧容量 * Num / Den（空vector从4开始）
+    // 2倍扩容重新分配次数少；1.5倍多占的空闲空间少，而且释放掉的旧块加起来有机会被后面的分配复用
+    template <size_t Num, size_t Den>
+    struct growth_factor
+    {
+        static_assert(Num > Den, "growth factor must be greater than 1");
+
+        static size_t Next(size_t capacity)
+        {
+            if (capacity == 0)
+                return 4;
+            size_t next = capacity / Den * Num + capacity % Den * Num / Den;  // 先除后乘，避免溢出
+            return next > capacity ? next : capacity + 1;
+        }
+    };
+
+    typedef growth_factor<2, 1> double_growth;
+    typedef growth_factor<3, 2> one_and_half_growth;
+
+    // 对象内部的原始空间，放得下N个T；N为0时是空结构体，配合[[no_unique_address]]不占空间
+    template <class T, size_t N>
+    struct __VectorInlineStorage
+    {
+        alignas(T) unsigned char _buf[N * sizeof(T)];
+    };
+
+    template <class T>
+    struct __VectorInlineStorage<T, 0>
+    {};
+
+    // Growth: 增长策略，见growth_factor
+    // InlineN: 对象内部直接放得下的元素个数，超过了才去堆上分配（见small_vector），默认0就是普通vector
+    template <class T, class Growth = double_growth, size_t InlineN = 0>
     class vector
     {
     public:
@@ -44,17 +92,17 @@ namespace pzh
 
         // 默认构造
         vector() 
-            : _start(nullptr)
-            , _finish(nullptr)
-            , _end_of_storage(nullptr)
+            : _start(InlineData())
+            , _finish(InlineData())
+            , _end_of_storage(InlineData() + InlineN)
         {}
 
         // 迭代器区间构造
         template <class InputIterator>
         vector(InputIterator first, InputIterator last)
-            : _start(nullptr)
-            , _finish(nullptr)
-            , _end_of_storage(nullptr)
+            : _start(InlineData())
+            , _finish(InlineData())
+            , _end_of_storage(InlineData() + InlineN)
         {
             // 考虑效率，若已知距离可提前 reserve，但 InputIterator 不一定支持断言距离
             while (first != last)
@@ -66,9 +114,9 @@ namespace pzh
 
         // size_t 初始化构造
         vector(size_t n, const T& val = T())
-            : _start(nullptr)
-            , _finish(nullptr)
-            , _end_of_storage(nullptr)
+            : _start(InlineData())
+            , _finish(InlineData())
+            , _end_of_storage(InlineData() + InlineN)
         {
             reserve(n);
             for (size_t i = 0; i < n; i++)
@@ -79,9 +127,9 @@ namespace pzh
 
         // int 初始化构造
         vector(int n, const T& val = T())
-            : _start(nullptr)
-            , _finish(nullptr)
-            , _end_of_storage(nullptr)
+            : _start(InlineData())
+            , _finish(InlineData())
+            , _end_of_storage(InlineData() + InlineN)
         {
             reserve(n);
             for (int i = 0; i < n; i++)
@@ -91,10 +139,10 @@ namespace pzh
         }
 
         // 拷贝构造 (Deep Copy)
-        vector(const vector<T>& v)
-            : _start(nullptr)
-            , _finish(nullptr)
-            , _end_of_storage(nullptr)
+        vector(const vector& v)
+            : _start(InlineData())
+            , _finish(InlineData())
+            , _end_of_storage(InlineData() + InlineN)
         {
             reserve(v.capacity());
             for (const auto& e : v)
@@ -103,20 +151,31 @@ namespace pzh
             }
         }
 
+        // 移动构造：堆上的空间直接接管；元素在v的内部空间里时只能逐个搬过来
+        vector(vector&& v) noexcept(InlineN == 0 || std::is_nothrow_move_constructible_v<T>)
+            : _start(InlineData())
+            , _finish(InlineData())
+            , _end_of_storage(InlineData() + InlineN)
+        {
+            MoveFrom(v);
+        }
+
         // 赋值重载 (Copy-and-Swap idiom)
-        // 传值传参触发拷贝构造，复用 swap 实现深拷贝
-        vector<T>& operator=(vector<T> tmp)
+        // 传值传参触发拷贝构造（右值时是移动构造），复用 swap 实现深拷贝
+        vector& operator=(vector tmp)
         {
             swap(tmp);
             return *this;
         }
 
         // 析构函数
+        // 空间是未初始化的原始内存，只有[_start, _finish)里有对象，先逐个析构再释放（内部空间不释放）
         ~vector()
         {
             if (_start)
             {
-                delete[] _start;
+                std::destroy(_start, _finish);
+                Deallocate(_start, capacity());
                 _start = _finish = _end_of_storage = nullptr;
             }
         }
@@ -141,23 +200,24 @@ namespace pzh
         }
 
         // 预留空间
-        // 核心逻辑：开辟新空间 -> 元素赋值(避免浅拷贝) -> 释放旧空间 -> 更新指针
+        // 核心逻辑：开辟未初始化的新空间 -> 把元素搬过去（见Relocate） -> 释放旧空间 -> 更新指针
+        // 新空间不像new T[n]那样先默认构造n个对象，元素也不再是“默认构造 + 拷贝赋值”两遍
         void reserve(size_t n)
         {
             if (n > capacity())
             {
                 size_t old_size = size();
-                T* tmp = new T[n];
-
-                if (_start)
+                T* tmp = Allocate(n);
+                try
                 {
-                    // 使用循环赋值而非 memcpy，确保自定义类型(如 std::string)执行深拷贝
-                    for (size_t i = 0; i < old_size; i++)
-                    {
-                        tmp[i] = _start[i];
-                    }
-                    delete[] _start;
+                    Relocate(_start, _finish, tmp);
+                }
+                catch (...)
+                {
+                    Deallocate(tmp, n);  // 原来的元素还在旧空间里，vector不变
+                    throw;
                 }
+                Deallocate(_start, capacity());
 
                 _start = tmp;
                 _finish = _start + old_size;
@@ -170,6 +230,7 @@ namespace pzh
         {
             if (n < size())
             {
+                std::destroy(_start + n, _finish);
                 _finish = _start + n;
             }
             else
@@ -177,7 +238,7 @@ namespace pzh
                 reserve(n);
                 while (_finish != _start + n)
                 {
-                    *_finish = val;
+                    ::new ((void*)_finish) T(val);
                     ++_finish;
                 }
             }
@@ -227,53 +288,113 @@ namespace pzh
         // 修改器 (Modifiers)
         // =========================================================
 
+        // 尾插：还有空间时只构造一个元素，不走insert的挪动和断言；满了才走扩容
         void push_back(const T& x)
         {
-            // 扩容逻辑集成在 insert 中，此处直接复用
-            insert(end(), x);
+            if (_finish != _end_of_storage) [[likely]]
+            {
+                ::new ((void*)_finish) T(x);
+                ++_finish;
+            }
+            else
+            {
+                ReallocInsert(_finish, x);
+            }
+        }
+
+        void push_back(T&& x)
+        {
+            if (_finish != _end_of_storage) [[likely]]
+            {
+                ::new ((void*)_finish) T(std::move(x));
+                ++_finish;
+            }
+            else
+            {
+                ReallocInsert(_finish, std::move(x));
+            }
+        }
+
+        // 用args在尾部就地构造，返回新元素的引用
+        template <class... Args>
+        T& emplace_back(Args&&... args)
+        {
+            if (_finish != _end_of_storage) [[likely]]
+            {
+                ::new ((void*)_finish) T(std::forward<Args>(args)...);
+                return *_finish++;
+            }
+            return *ReallocInsert(_finish, std::forward<Args>(args)...);
         }
 
         void pop_back()
         {
             assert(!empty());
             --_finish;
+            std::destroy_at(_finish);
         }
 
-        void swap(vector<T>& v)
+        // 两边都在堆上时只交换指针；有一边用的是内部空间，指针不能跟着对象走，只能经过临时对象搬元素
+        void swap(vector& v)
         {
+            if (IsInline() || v.IsInline())
+            {
+                vector tmp;
+                tmp.MoveFrom(v);
+                v.MoveFrom(*this);
+                MoveFrom(tmp);
+                return;
+            }
             std::swap(_start, v._start);
             std::swap(_finish, v._finish);
             std::swap(_end_of_storage, v._end_of_storage);
         }
 
+        // 元素还在对象内部的空间里，没有堆分配
+        bool is_inline() const
+        {
+            return IsInline();
+        }
+
         // 任意位置插入
         // 返回指向新插入元素的迭代器
         iterator insert(iterator pos, const T& x)
+        {
+            return emplace(pos, x);
+        }
+
+        iterator insert(iterator pos, T&& x)
+        {
+            return emplace(pos, std::move(x));
+        }
+
+        // 用args在pos处构造元素
+        template <class... Args>
+        iterator emplace(iterator pos, Args&&... args)
         {
             assert(pos >= _start);
             assert(pos <= _finish);
 
-            // 检查扩容
+            // 检查扩容：在新空间里直接把元素构造到位，不用先扩容再挪一遍
             if (_finish == _end_of_storage)
             {
-                size_t len = pos - _start;  // 记录相对偏移量
-                size_t newCapacity = capacity() == 0 ? 4 : capacity() * 2;
-                reserve(newCapacity);
-
-                // 扩容后旧空间被释放，需要更新 pos，否则会导致迭代器失效
-                pos = _start + len;
+                return ReallocInsert(pos, std::forward<Args>(args)...);
             }
 
-            // 元素挪动
-            iterator end_it = _finish - 1;
-            while (end_it >= pos)
+            if (pos == _finish)
             {
-                *(end_it + 1) = *end_it;
-                --end_it;
+                ::new ((void*)_finish) T(std::forward<Args>(args)...);
+                ++_finish;
+                return pos;
             }
 
-            *pos = x;
+            // args可能引用[pos, _finish)里的元素，挪动之后就不是原来的值了，先构造出来
+            T tmp(std::forward<Args>(args)...);
+            // 最后一个元素移动构造到未初始化的_finish上，其余的往后移动赋值
+            ::new ((void*)_finish) T(std::move(*(_finish - 1)));
             ++_finish;
+            std::move_backward(pos, _finish - 2, _finish - 1);
+            *pos = std::move(tmp);
             return pos;
         }
 
@@ -287,17 +408,169 @@ namespace pzh
             iterator it = pos + 1;
             while (it < _finish)
             {
-                *(it - 1) = *it;
+                *(it - 1) = std::move(*it);
                 ++it;
             }
 
             --_finish;
+            std::destroy_at(_finish);
             return pos;
         }
 
     private:
+        static T* Allocate(size_t n)
+        {
+            return std::allocator<T>().allocate(n);
+        }
+
+        // 内部空间不是分配来的，不释放
+        void Deallocate(T* p, size_t n)
+        {
+            if (p && p != InlineData())
+                std::allocator<T>().deallocate(p, n);
+        }
+
+        // 内部空间的起始地址，只取地址不读内容（构造函数里初始化指针时用）
+        T* InlineData()
+        {
+            if constexpr (InlineN == 0)
+                return nullptr;
+            else
+                return reinterpret_cast<T*>(_inline._buf);
+        }
+
+        const T* InlineData() const
+        {
+            if constexpr (InlineN == 0)
+                return nullptr;
+            else
+                return reinterpret_cast<const T*>(_inline._buf);
+        }
+
+        bool IsInline() const
+        {
+            return InlineN != 0 && _start == InlineData();
+        }
+
+        // 把v的元素转移过来，v变成空的（回到内部空间）；要求本对象是空的
+        void MoveFrom(vector& v)
+        {
+            if (v.IsInline())
+            {
+                reserve(v.size());
+                Relocate(v._start, v._finish, _start);
+                _finish = _start + v.size();
+                v._finish = v._start;
+            }
+            else
+            {
+                Deallocate(_start, capacity());
+                _start = v._start;
+                _finish = v._finish;
+                _end_of_storage = v._end_of_storage;
+                v._start = v._finish = v.InlineData();
+                v._end_of_storage = v.InlineData() + InlineN;
+            }
+        }
+
+        // 把[first, last)逐个用move_if_noexcept构造到未初始化的dest：移动构造不抛异常时移动，
+        // 会抛异常时退回拷贝；中途抛异常就析构掉已构造的，源区间完好无损（强异常保证）
+        static void UninitializedMoveIfNoexcept(T* first, T* last, T* dest)
+        {
+            T* cur = dest;
+            try
+            {
+                for (; first != last; ++first, ++cur)
+                {
+                    ::new ((void*)cur) T(std::move_if_noexcept(*first));
+                }
+            }
+            catch (...)
+            {
+                std::destroy(dest, cur);
+                throw;
+            }
+        }
+
+        // 把[first, last)里的元素搬到未初始化的dest，搬完后源区间里已经没有对象了
+        // 可平凡重定位时直接memcpy，不调用任何构造和析构
+        static void Relocate(T* first, T* last, T* dest)
+        {
+            if constexpr (is_trivially_relocatable_v<T>)
+            {
+                size_t n = last - first;
+                if (n != 0)
+                    std::memcpy((void*)dest, (const void*)first, n * sizeof(T));
+            }
+            else
+            {
+                UninitializedMoveIfNoexcept(first, last, dest);
+                std::destroy(first, last);
+            }
+        }
+
+        // 满了之后在pos插入：新元素先构造到新空间的最终位置（参数可能引用本vector里的元素，旧空间这时还完好），
+        // 再把pos前后两段搬过去；任何一步抛异常，vector保持原样
+        template <class... Args>
+        iterator ReallocInsert(iterator pos, Args&&... args)
+        {
+            size_t len = pos - _start;  // 记录相对偏移量
+            size_t old_size = size();
+            size_t newCapacity = Growth::Next(capacity());
+            T* tmp = Allocate(newCapacity);
+            try
+            {
+                ::new ((void*)(tmp + len)) T(std::forward<Args>(args)...);
+            }
+            catch (...)
+            {
+                Deallocate(tmp, newCapacity);
+                throw;
+            }
+            if constexpr (is_trivially_relocatable_v<T>)
+            {
+                Relocate(_start, pos, tmp);
+                Relocate(pos, _finish, tmp + len + 1);
+            }
+            else
+            {
+                // 两段都构造成功之后才析构旧元素，后半段失败时前半段还在旧空间里
+                try
+                {
+                    UninitializedMoveIfNoexcept(_start, pos, tmp);
+                    try
+                    {
+                        UninitializedMoveIfNoexcept(pos, _finish, tmp + len + 1);
+                    }
+                    catch (...)
+                    {
+                        std::destroy(tmp, tmp + len);
+                        throw;
+                    }
+                }
+                catch (...)
+                {
+                    std::destroy_at(tmp + len);
+                    Deallocate(tmp, newCapacity);
+                    throw;
+                }
+                std::destroy(_start, _finish);
+            }
+            Deallocate(_start, capacity());
+            _start = tmp;
+            _finish = _start + old_size + 1;
+            _end_of_storage = _start + newCapacity;
+            return _start + len;
+        }
+
+        [[no_unique_address]] __VectorInlineStorage<T, InlineN> _inline;
         iterator _start = nullptr;
         iterator _finish = nullptr;
         iterator _end_of_storage = nullptr;
     };
+
+    // 小缓冲区优化的vector：不超过N个元素时放在对象内部，不分配堆内存；超过N个才搬到堆上，之后和vector一样
+    // 接口和vector完全相同（就是同一个类模板）；代价是对象本身大了N * sizeof(T)，移动和交换要逐个搬元素
+    template <class T, size_t N, class Growth = double_growth>
+    using small_vector = vector<T, Growth, N>;
 }
\ No newline at end of file